@@ -8,14 +8,23 @@ in VS_OUT {
     vec2 TexCoords;
 } fs_in;
 
-struct Light {
-    vec3 Position;
-    vec3 Color;
+//Shared by every program, written once per view (FrameUniforms)
+layout (std140) uniform ViewData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition;
+};
+//Shared by every program, written once per frame (FrameUniforms)
+const int MAX_LIGHTS = 16;
+layout (std140) uniform LightData
+{
+    vec4 lightPositions[MAX_LIGHTS];
+    vec4 lightColors[MAX_LIGHTS];
+    int lightCount;
 };
 
-uniform Light lights[4];
 uniform sampler2D diffuseTexture;
-uniform vec3 viewPos;
 
 void main()
 {
@@ -25,15 +34,15 @@ void main()
     vec3 ambient = 0.0 * color;
     // lighting
     vec3 lighting = vec3(0.0);
-    vec3 viewDir = normalize(viewPos - fs_in.FragPos);
-    for(int i = 0; i < 4; i++)
+    vec3 viewDir = normalize(viewPosition.xyz - fs_in.FragPos);
+    for(int i = 0; i < lightCount; i++)
     {
         // diffuse
-        vec3 lightDir = normalize(lights[i].Position - fs_in.FragPos);
+        vec3 lightDir = normalize(lightPositions[i].xyz - fs_in.FragPos);
         float diff = max(dot(lightDir, normal), 0.0);
-        vec3 result = lights[i].Color * diff * color;
+        vec3 result = lightColors[i].rgb * diff * color;
         // attenuation (use quadratic as we have gamma correction)
-        float distance = length(fs_in.FragPos - lights[i].Position);
+        float distance = length(fs_in.FragPos - lightPositions[i].xyz);
         result *= 1.0 / (distance * distance);
         lighting += result;
 
@@ -9,8 +9,13 @@ out VS_OUT {
     vec2 TexCoords;
 } vs_out;
 
-uniform mat4 projection;
-uniform mat4 view;
+//Shared by every program, written once per view (FrameUniforms)
+layout (std140) uniform ViewData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition;
+};
 uniform mat4 model;
 
 void main()
@@ -1,4 +1,8 @@
 ﻿#version 330 core
+// taps from the center to one edge of the kernel, center included
+#ifndef BLUR_TAPS
+#define BLUR_TAPS 5
+#endif
 out vec4 FragColor;
 
 in vec2 TexCoords;
@@ -6,7 +10,13 @@ in vec2 TexCoords;
 uniform sampler2D image;
 
 uniform bool horizontal;
-uniform float weight[5] = float[] (0.2270270270, 0.1945945946, 0.1216216216, 0.0540540541, 0.0162162162);
+#if BLUR_TAPS == 3
+const float weight[3] = float[] (0.375, 0.25, 0.0625);
+#elif BLUR_TAPS == 5
+const float weight[5] = float[] (0.2270270270, 0.1945945946, 0.1216216216, 0.0540540541, 0.0162162162);
+#else
+#error BLUR_TAPS must be 3 or 5
+#endif
 
 void main()
 {
@@ -14,7 +24,7 @@ void main()
     vec3 result = texture(image, TexCoords).rgb * weight[0];
     if(horizontal)
     {
-        for(int i = 1; i < 5; ++i)
+        for(int i = 1; i < BLUR_TAPS; ++i)
         {
             result += texture(image, TexCoords + vec2(tex_offset.x * i, 0.0)).rgb * weight[i];
             result += texture(image, TexCoords - vec2(tex_offset.x * i, 0.0)).rgb * weight[i];
@@ -22,7 +32,7 @@ void main()
     }
     else
     {
-        for(int i = 1; i < 5; ++i)
+        for(int i = 1; i < BLUR_TAPS; ++i)
         {
             result += texture(image, TexCoords + vec2(0.0, tex_offset.y * i)).rgb * weight[i];
             result += texture(image, TexCoords - vec2(0.0, tex_offset.y * i)).rgb * weight[i];
@@ -5,12 +5,18 @@ layout (location = 0) in vec3 aPos;
 
 out vec3 TexCoords;
 
-uniform mat4 projection;
-uniform mat4 view;
+//Shared by every program, written once per view (FrameUniforms)
+layout (std140) uniform ViewData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition;
+};
 
 void main()
 {
     TexCoords = aPos;
-    vec4 pos = (projection * view) * vec4(aPos, 1.0);
+    //The skybox follows the camera, only the rotation of the view applies
+    vec4 pos = (projection * mat4(mat3(view))) * vec4(aPos, 1.0);
     gl_Position = pos.xyww;
 }
\ No newline at end of file
@@ -6,12 +6,18 @@ out vec4 FragColor;
 in vec3 Normal;
 in vec3 Position;
 
-uniform vec3 cameraPos;
+//Shared by every program, written once per view (FrameUniforms)
+layout (std140) uniform ViewData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition;
+};
 uniform samplerCube skybox;
 
 void main()
 {
-    vec3 I = normalize(Position - cameraPos);
+    vec3 I = normalize(Position - viewPosition.xyz);
     vec3 R = reflect(I, normalize(Normal));
     FragColor = vec4(texture(skybox, R).rgb, 1.0);
 }
\ No newline at end of file
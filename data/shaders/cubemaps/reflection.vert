@@ -8,8 +8,13 @@ out vec3 Normal;
 out vec3 Position;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+//Shared by every program, written once per view (FrameUniforms)
+layout (std140) uniform ViewData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition;
+};
 
 void main()
 {
@@ -7,8 +7,13 @@ layout(location = 2) in vec2 tex;
 layout(location = 3) in ivec4 boneIds;
 layout(location = 4) in vec4 weights;
 
-uniform mat4 projection;
-uniform mat4 view;
+//Written by the engine right before the main pass (LateLatch)
+layout (std140) uniform ViewData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition;
+};
 uniform mat4 model;
 
 const int MAX_BONES = 100;
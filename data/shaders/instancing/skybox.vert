@@ -0,0 +1,22 @@
+﻿#version 300 es
+precision highp float;
+
+layout (location = 0) in vec3 aPos;
+
+out vec3 TexCoords;
+
+//Written by the engine right before the main pass (LateLatch)
+layout (std140) uniform ViewData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition;
+};
+
+void main()
+{
+    TexCoords = aPos;
+    //Rotation only, the skybox stays centered on the camera
+    vec4 pos = (projection * mat4(mat3(view))) * vec4(aPos, 1.0);
+    gl_Position = pos.xyww;
+}
\ No newline at end of file
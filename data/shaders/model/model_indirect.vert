@@ -0,0 +1,27 @@
+﻿#version 450
+#extension GL_ARB_shader_draw_parameters : require
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+out vec2 TexCoords;
+
+//One entry per command of the glMultiDrawElementsIndirect call (IndirectRenderer)
+struct DrawData
+{
+    mat4 model;
+};
+layout (std430, binding = 3) readonly buffer DrawBuffer
+{
+    DrawData draws[];
+};
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    TexCoords = aTexCoords;
+    gl_Position = projection * view * draws[gl_DrawIDARB].model * vec4(aPos, 1.0);
+}
\ No newline at end of file
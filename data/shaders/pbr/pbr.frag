@@ -1,4 +1,7 @@
 ﻿#version 330 core
+#ifndef LIGHT_COUNT
+#define LIGHT_COUNT 4
+#endif
 out vec4 FragColor;
 in vec2 TexCoords;
 in vec3 WorldPos;
@@ -16,8 +19,8 @@ uniform samplerCube prefilterMap;
 uniform sampler2D brdfLUT;
 
 // lights
-uniform vec3 lightPositions[4];
-uniform vec3 lightColors[4];
+uniform vec3 lightPositions[LIGHT_COUNT];
+uniform vec3 lightColors[LIGHT_COUNT];
 
 uniform vec3 camPos;
 
@@ -81,7 +84,7 @@ void main()
 
     // reflectance equation
     vec3 Lo = vec3(0.0);
-    for(int i = 0; i < 4; ++i)
+    for(int i = 0; i < LIGHT_COUNT; ++i)
     {
         // calculate per-light radiance
         vec3 L = normalize(lightPositions[i] - WorldPos);
@@ -1,4 +1,7 @@
 ﻿#version 330 core
+#ifndef SAMPLE_COUNT
+#define SAMPLE_COUNT 1024u
+#endif
 out vec4 FragColor;
 in vec3 WorldPos;
 
@@ -69,7 +72,6 @@ void main()
     vec3 R = N;
     vec3 V = R;
 
-    const uint SAMPLE_COUNT = 1024u;
     vec3 prefilteredColor = vec3(0.0);
     float totalWeight = 0.0;
 
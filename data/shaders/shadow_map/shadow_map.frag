@@ -1,4 +1,8 @@
 ﻿#version 330 core
+// PCF kernel of (2 * PCF_RADIUS + 1)^2 taps, 0 is a single hard tap
+#ifndef PCF_RADIUS
+#define PCF_RADIUS 1
+#endif
 out vec4 FragColor;
 
 in VS_OUT {
@@ -33,15 +37,15 @@ float ShadowCalculation(vec4 fragPosLightSpace)
     // PCF
     float shadow = 0.0;
     vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
-    for(int x = -1; x <= 1; ++x)
+    for(int x = -PCF_RADIUS; x <= PCF_RADIUS; ++x)
     {
-        for(int y = -1; y <= 1; ++y)
+        for(int y = -PCF_RADIUS; y <= PCF_RADIUS; ++y)
         {
             float pcfDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r;
             shadow += currentDepth - bias > pcfDepth  ? 1.0 : 0.0;
         }
     }
-    shadow /= 9.0;
+    shadow /= float((2 * PCF_RADIUS + 1) * (2 * PCF_RADIUS + 1));
 
     // keep the shadow at 0.0 when outside the far_plane region of the light's frustum.
     if(projCoords.z > 1.0)
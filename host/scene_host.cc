@@ -0,0 +1,24 @@
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+#include "engine.h"
+#include "scene_host.h"
+
+int main(int argc, char* argv[])
+{
+    //--scene NAME (a main/ file name, like hello_anim) picks the first scene, the others are in the Scenes window
+    std::string initial_scene;
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (std::string_view(argv[i]) == "--scene")
+        {
+            initial_scene = argv[i + 1];
+        }
+    }
+    gpr5300::SceneHost scene(initial_scene);
+    gpr5300::Engine engine(&scene, gpr5300::EngineSettings::FromArgs(argc, argv));
+    engine.Run();
+
+    return EXIT_SUCCESS;
+}
@@ -6,7 +6,7 @@ struct UVRect {
     float uMax, vMax;
 };
 
-UVRect GetUVRect(int row, int col, int totalRows, int totalCols) {
+inline UVRect GetUVRect(int row, int col, int totalRows, int totalCols) {
     float cellWidth = 1.0f / totalCols;
     float cellHeight = 1.0f / totalRows;
 
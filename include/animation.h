@@ -56,6 +56,7 @@ public:
 	inline float GetTicksPerSecond() { return m_TicksPerSecond; }
 	inline float GetDuration() { return m_Duration;}
 	inline const AssimpNodeData& GetRootNode() { return m_RootNode; }
+	inline std::vector<Bone>& GetBones() { return m_Bones; }
 	inline const std::map<std::string,BoneInfo>& GetBoneIDMap()
 	{
 		return m_BoneInfoMap;
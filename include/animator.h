@@ -8,6 +8,8 @@
 #include <assimp/Importer.hpp>
 #include <animation.h>
 #include <bone.h>
+#include "cpu_tracer.h"
+#include "job_system.h"
 
 class Animator
 {
@@ -25,13 +27,15 @@ public:
             m_FinalBoneMatrices.push_back(glm::mat4(1.0f));
     }
 
-    void UpdateAnimation(float dt)
+    void UpdateAnimation(float dt, gpr5300::JobSystem* jobs = nullptr)
     {
+        gpr5300::ScopedZone zone("Animator::UpdateAnimation");
         m_DeltaTime = dt;
         if (m_CurrentAnimation)
         {
             m_CurrentTime += m_CurrentAnimation->GetTicksPerSecond() * dt;
             m_CurrentTime = fmod(m_CurrentTime, m_CurrentAnimation->GetDuration());
+            UpdateBones(jobs);
             CalculateBoneTransform(&m_CurrentAnimation->GetRootNode(), glm::mat4(1.0f));
         }
     }
@@ -42,6 +46,22 @@ public:
         m_CurrentTime = 0.0f;
     }
 
+    //Keyframe interpolation is independent for each bone, only the hierarchy walk has to stay serial
+    void UpdateBones(gpr5300::JobSystem* jobs)
+    {
+        std::vector<Bone>& bones = m_CurrentAnimation->GetBones();
+        const auto update = [this, &bones](const std::size_t begin, const std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+                bones[i].Update(m_CurrentTime);
+        };
+        constexpr std::size_t bones_per_job = 16;
+        if (jobs != nullptr)
+            jobs->ParallelFor(bones.size(), bones_per_job, update);
+        else
+            update(0, bones.size());
+    }
+
     void CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parentTransform)
     {
         std::string nodeName = node->name;
@@ -51,7 +71,6 @@ public:
 
         if (Bone)
         {
-            Bone->Update(m_CurrentTime);
             nodeTransform = Bone->GetLocalTransform();
         }
 
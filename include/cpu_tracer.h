@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+namespace gpr5300
+{
+    //Low overhead CPU instrumentation. Each thread records its zones in its own fixed size ring buffer
+    //(no lock, no allocation once the thread registered), timestamps come from the monotonic steady_clock.
+    //The buffers can be dumped at any time to Chrome about://tracing / Perfetto JSON, zones overwritten while the dump
+    //copies a ring are left out instead of torn.
+    namespace CpuTracer
+    {
+        //Zone names are stored by pointer, they must outlive the tracer (string literals)
+        struct Zone
+        {
+            const char* name = nullptr;
+            std::int64_t start_ns = 0;
+            std::int64_t end_ns = 0;
+        };
+
+        inline constexpr std::size_t ring_capacity = 1 << 16;
+
+        inline std::int64_t Now()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        void Record(const char* name, std::int64_t start_ns, std::int64_t end_ns);
+        void SetThreadName(std::string_view name);
+        void SetEnabled(bool enabled);
+        [[nodiscard]] bool IsEnabled();
+
+        //Write every buffered zone of every thread, returns false if the file cannot be written
+        bool WriteChromeTrace(std::string_view path);
+    }
+
+    //Records the enclosing scope as one zone
+    class ScopedZone
+    {
+    public:
+        explicit ScopedZone(const char* name) : name_(name), start_ns_(CpuTracer::Now()) {}
+        ~ScopedZone() { CpuTracer::Record(name_, start_ns_, CpuTracer::Now()); }
+        ScopedZone(const ScopedZone&) = delete;
+        ScopedZone& operator=(const ScopedZone&) = delete;
+
+    private:
+        const char* name_;
+        std::int64_t start_ns_;
+    };
+} // namespace gpr5300
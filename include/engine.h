@@ -1,20 +1,109 @@
 #pragma once
+#include <string>
+
+#include "frame_pacer.h"
+#include "frame_uniforms.h"
+#include "headless_context.h"
+#include "input.h"
+#include "job_system.h"
+#include "late_latch.h"
+#include "render_target_pool.h"
+#include "render_thread.h"
+#include "resource_cache.h"
 #include "scene.h"
+#include "shader_watcher.h"
+
+//Set by CMake to the shaders of the source tree, the build tree copies when built without it
+#ifndef GPR5300_SHADER_SOURCE_DIR
+#define GPR5300_SHADER_SOURCE_DIR "data/shaders"
+#endif
 
 namespace gpr5300
 {
 
+struct EngineSettings
+{
+    //Initial window size, scenes read the current one from their RenderTargetPool
+    int width = 1280;
+    int height = 720;
+    PresentMode present_mode = PresentMode::Vsync;
+    //Software frame rate cap in Hz on top of the present mode, 0 to disable
+    int frame_cap_hz = 0;
+    //How many frames the CPU may queue ahead of the GPU, 0 leaves it to the driver
+    int max_frames_in_flight = 2;
+    //Simulation steps per second for scenes supporting FixedUpdate, 0 keeps the variable Update(dt)
+    int fixed_update_rate = 0;
+    //Threads of the job system, main thread included, 0 uses every hardware thread
+    int job_threads = 0;
+    //Record GL work on the simulation thread and replay it on a render thread, for scenes supporting it
+    bool render_thread = true;
+
+    //Headless benchmark: render offscreen with vsync off, print frame time statistics and quit
+    bool headless = false;
+    int benchmark_frames = 600;
+    int warmup_frames = 30;
+
+    //Chrome trace JSON of the CPU zones written at exit, empty to disable
+    std::string trace_path;
+
+    //Input recording written while running, or replayed instead of the live input (frame dt included)
+    std::string record_path;
+    std::string replay_path;
+
+    //Linked program binaries reused by the next launch, empty to always compile from source
+    std::string program_cache_dir = "shader_cache";
+    //Imported models mapped by the next launch instead of running Assimp, empty to always import
+    std::string mesh_cache_dir = "mesh_cache";
+    //Shaders rebuilt when a file under this directory is saved, empty to disable. Never in headless runs. The
+    //source tree by default: the programs are loaded from the copies of the build tree, a reload reads the saved
+    //file and its includes from here.
+    std::string shader_watch_dir = GPR5300_SHADER_SOURCE_DIR;
+
+    //Recognized arguments: --headless, --frames N, --warmup N, --present vsync|adaptive|uncapped,
+    //--no-vsync, --fps-cap HZ, --frames-in-flight N, --fixed-rate HZ, --jobs N, --no-render-thread, --trace FILE,
+    //--record FILE, --replay FILE, --program-cache DIR, --no-program-cache, --mesh-cache DIR, --no-mesh-cache,
+    //--no-hot-reload
+    static EngineSettings FromArgs(int argc, char* argv[]);
+};
+
 class Engine
 {
 public:
     Engine(Scene* scene);
+    Engine(Scene* scene, const EngineSettings& settings);
     void Run();
 private:
     void Begin();
+    bool BeginHeadless();
+    void BeginWindow();
     void End();
+    bool PollEvents(float& dt);
+    void ResizeIfNeeded();
+    void RenderFrame(float dt);
+    void SubmitFrame();
+    void UpdateScene(float dt);
+    void Present();
+    void EndFrame();
+    void MakeContextCurrent(bool current);
+    void RunBenchmark();
+
+    EngineSettings settings_;
     Scene* scene_ = nullptr;
     SDL_Window* window_ = nullptr;
     SDL_GLContext glRenderContext_{};
+    HeadlessContext headless_context_;
+    FramePacer frame_pacer_;
+    FrameUniforms frame_uniforms_;
+    JobSystem job_system_;
+    RenderThread render_thread_;
+    LateLatch late_latch_;
+    Input input_;
+    ResourceCache resource_cache_;
+    ShaderWatcher shader_watcher_;
+    RenderTargetPool render_targets_;
+    std::vector<SDL_Event> events_;
+    double fixed_update_accumulator_ = 0.0;
+    double elapsed_time_ = 0.0;
 };
-    
+
 } // namespace gpr5300
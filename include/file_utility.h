@@ -1,8 +1,38 @@
 #pragma once
 
+#include <cstddef>
+#include <span>
+#include <string>
 #include <string_view>
+#include <vector>
 
 namespace gpr5300
 {
     std::string LoadFile(std::string_view path);
+
+    //Read-only content of a whole file, memory mapped on Linux so only the pages touched are read, loaded into
+    //memory elsewhere. The bytes stay valid until the MappedFile is destroyed, moving it does not move them.
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::string& path);
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        [[nodiscard]] bool IsOpen() const { return data_ != nullptr; }
+        [[nodiscard]] std::span<const std::byte> Bytes() const { return {data_, size_}; }
+
+    private:
+        void Close();
+
+        const std::byte* data_ = nullptr;
+        std::size_t size_ = 0;
+        bool mapped_ = false;
+        //Content read without mmap
+        std::vector<std::byte> buffer_;
+    };
 } // namespace gpr5300
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace gpr5300
+{
+    enum class PresentMode
+    {
+        Vsync,
+        //Swap interval -1: waits for vblank unless the frame is late, then tears instead of dropping to half rate
+        AdaptiveVsync,
+        Uncapped
+    };
+
+    //Paces the frame loop: sets the swap interval for the present mode, optionally caps the frame rate in
+    //software and limits how many frames the CPU may queue ahead of the GPU with fences.
+    //With a render thread the fence wait runs on it one frame late: WaitForFrameSlot blocks the simulation on the
+    //previous frame wait so input is still sampled once the GPU made room, one more frame (the replayed one) in flight.
+    class FramePacer
+    {
+    public:
+        //Needs the window GL context to be current
+        static void ApplyPresentMode(PresentMode mode);
+
+        void Create(int frame_cap_hz, int max_frames_in_flight);
+        void Destroy();
+
+        //Simulation thread, before sampling input: waits out the software frame cap, then until the GL thread
+        //went through the BeginFrame of every frame submitted so far
+        void WaitForFrameSlot();
+        //GL thread, first command of a frame: blocks until the GPU finished the frame max_frames_in_flight frames ago
+        void BeginFrame();
+        //GL thread, after the swap: fences the frame
+        void EndFrame();
+
+    private:
+        void WaitForFrameCap();
+
+        std::vector<GLsync> fences_;
+        std::size_t frame_index_ = 0;
+        std::chrono::steady_clock::duration frame_period_{};
+        std::chrono::steady_clock::time_point next_frame_{};
+
+        std::mutex mutex_;
+        std::condition_variable frame_begun_;
+        //Frames the simulation asked a slot for, and frames whose BeginFrame returned on the GL thread
+        std::size_t requested_frames_ = 0;
+        std::size_t begun_frames_ = 0;
+    };
+} // namespace gpr5300
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace gpr5300
+{
+    struct FrameTimeSummary
+    {
+        double min = 0.0;
+        double mean = 0.0;
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+    };
+
+    //Collects per-frame durations in milliseconds and reduces them to min/mean/percentiles/max
+    class FrameStatistics
+    {
+    public:
+        void Reserve(const std::size_t count) { samples_.reserve(count); }
+        void Add(const double milliseconds) { samples_.push_back(milliseconds); }
+        void Clear() { samples_.clear(); }
+
+        [[nodiscard]] std::size_t Count() const { return samples_.size(); }
+        [[nodiscard]] FrameTimeSummary Summarize() const;
+
+        //Print one aligned row of the summary, see PrintHeader for the columns
+        void PrintRow(std::string_view label) const;
+        static void PrintHeader();
+
+    private:
+        std::vector<double> samples_;
+    };
+} // namespace gpr5300
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+namespace gpr5300
+{
+    //std140 layout of the FrameData uniform block, written by the engine at the start of every frame
+    struct FrameData
+    {
+        float time = 0.0f;
+        float delta_time = 0.0f;
+        glm::vec2 resolution{};
+    };
+
+    //std140 layout of the ViewData uniform block
+    struct ViewData
+    {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::vec4 view_position;
+    };
+
+    //std140 layout of the LightData uniform block, point lights with xyz used and w ignored
+    struct LightData
+    {
+        static constexpr int max_lights = 16;
+        glm::vec4 positions[max_lights];
+        glm::vec4 colors[max_lights];
+        int count = 0;
+        int padding[3] = {};
+    };
+
+    static_assert(sizeof(FrameData) == 16 && sizeof(ViewData) == 144 && sizeof(LightData) == 528,
+                  "Uniform block structs must match their std140 layout");
+
+    //Per frame and per view data shared by every program through uniform blocks at fixed binding points, written
+    //once instead of set on each program. The blocks live in a persistently mapped ring of one segment per frame
+    //the GPU may still read, each segment fenced when its frame ends. Every Set call of a frame gets its own range
+    //of the segment, so a second view (shadow pass, reflection) never overwrites one a draw still refers to.
+    class FrameUniforms
+    {
+    public:
+        static constexpr GLuint view_binding = 0;
+        static constexpr GLuint frame_binding = 1;
+        static constexpr GLuint light_binding = 2;
+
+        void Create(int frames_in_flight);
+        void Destroy();
+
+        //Points the FrameData, ViewData and LightData blocks of program at their binding, Shader does it once linked
+        static void BindBlocks(GLuint program);
+
+        //GL thread, frame start: moves to the next segment, waiting for the GPU if it still reads it
+        void BeginFrame(const FrameData& frame);
+        //GL thread, frame end: fences the segment of the frame
+        void EndFrame();
+
+        //GL thread: writes the block and binds it until the next call
+        void SetView(const ViewData& view);
+        void SetLights(const LightData& lights);
+
+    private:
+        void Write(const void* data, std::size_t size, GLuint binding);
+
+        GLuint buffer_ = 0;
+        std::byte* mapped_ = nullptr;
+        std::size_t alignment_ = 256;
+        std::vector<GLsync> fences_;
+        std::size_t segment_ = 0;
+        std::size_t offset_ = 0;
+        bool overflow_reported_ = false;
+    };
+} // namespace gpr5300
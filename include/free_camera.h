@@ -2,6 +2,7 @@
 #define FREE_CAMERA_H
 #include <glm/fwd.hpp>
 #include <glm/vec3.hpp>
+#include <glm/common.hpp>
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/ext/quaternion_geometric.hpp>
 
@@ -117,6 +118,29 @@ struct FreeCamera {
 
     glm::mat4 view() const { return view_;}
 
+    //Fixed timestep rendering: remember the state of the last simulation step...
+    glm::vec3 previous_position_ = camera_position_;
+    glm::vec3 previous_front_ = camera_front_;
+
+    void StorePreviousState()
+    {
+        previous_position_ = camera_position_;
+        previous_front_ = camera_front_;
+    }
+
+    //...and blend from it (alpha = 0) to the current step (alpha = 1)
+    glm::vec3 InterpolatedPosition(const float alpha) const
+    {
+        return glm::mix(previous_position_, camera_position_, alpha);
+    }
+
+    glm::mat4 InterpolatedView(const float alpha) const
+    {
+        const glm::vec3 front = glm::normalize(glm::mix(previous_front_, camera_front_, alpha));
+        const glm::vec3 position = InterpolatedPosition(alpha);
+        return glm::lookAt(position, position + front, camera_up_);
+    }
+
     Frustum createFrustum(float aspect, float fovY)
     {
         Frustum     frustum;
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <span>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gl_resources.h"
+
+namespace gpr5300
+{
+    //Shared vertex and index storage of one vertex layout. Meshes get a range of a large page instead of buffers of
+    //their own, so every mesh of a page draws from the same vertex array and glMultiDrawElementsIndirect can submit
+    //them together. Pages are never resized nor freed before Destroy: the vertex array of a page stays valid as long
+    //as the arena. A released range goes to the free list of its page and is reused by the next allocations that
+    //fit. GL thread only.
+    class GeometryArena
+    {
+    public:
+        //Location of a mesh, the base vertex and first index of its draws
+        struct Range
+        {
+            std::size_t page = 0;
+            GLint base_vertex = 0;
+            GLsizei vertex_count = 0;
+            GLuint first_index = 0;
+            GLsizei index_count = 0;
+        };
+
+        //Free elements of a page buffer, from offset
+        struct Block
+        {
+            std::size_t offset = 0;
+            std::size_t count = 0;
+        };
+
+        struct Page
+        {
+            GLuint vertex_array = 0;
+            GLuint vertex_buffer = 0;
+            GLuint index_buffer = 0;
+            std::size_t vertex_capacity = 0;
+            std::size_t index_capacity = 0;
+            //End of the used part, the free blocks below it excepted
+            std::size_t vertex_count = 0;
+            std::size_t index_count = 0;
+            //Released ranges sorted by offset, merged with their free neighbours
+            std::vector<Block> free_vertices;
+            std::vector<Block> free_indices;
+        };
+
+        //Vertices of stride bytes, attributes read from binding point 0
+        GeometryArena(GLsizei stride, std::initializer_list<GlResources::VertexAttribute> attributes);
+
+        //Copies vertex_count vertices and their indices, counted from the first vertex, to the first page with
+        //room for both: a released range first, else the end of the page. A new page when none has room.
+        Range Allocate(const void* vertices, std::size_t vertex_count, std::span<const unsigned int> indices);
+        //Gives the range back to its page, it must not be drawn anymore. Ignored once the arena is destroyed.
+        void Release(const Range& range);
+        [[nodiscard]] const Page& GetPage(const std::size_t page) const { return pages_[page]; }
+        //New vertex array reading page with the arena layout, for a draw adding attributes of its own (per instance
+        //data at another binding point). The caller deletes it.
+        [[nodiscard]] GLuint CreateVertexArray(std::size_t page) const;
+
+        void Destroy();
+
+    private:
+        GLsizei stride_;
+        std::vector<GlResources::VertexAttribute> attributes_;
+        std::vector<Page> pages_;
+    };
+} // namespace gpr5300
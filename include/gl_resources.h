@@ -0,0 +1,54 @@
+#pragma once
+
+#include <initializer_list>
+#include <span>
+#include <string_view>
+
+#include <GL/glew.h>
+
+namespace gpr5300
+{
+    //Creation of GL objects through direct state access (GL 4.5): objects are edited by name, nothing is bound and
+    //the GlState copy stays valid. Storage is immutable, the driver validates the size and format once at creation
+    //instead of at every draw using the object. GL thread only.
+    namespace GlResources
+    {
+        //One attribute read from the vertex buffer bound to binding point 0
+        struct VertexAttribute
+        {
+            GLuint index = 0;
+            GLint size = 0;
+            GLenum type = GL_FLOAT;
+            GLuint offset = 0;
+            //Read as integers by the shader (ivec4 bone ids), not converted to float
+            bool integer = false;
+        };
+
+        //flags are those of glNamedBufferStorage, 0 for a buffer never written again. A zero size creates the name only.
+        [[nodiscard]] GLuint CreateBuffer(GLsizeiptr size, const void* data, GLbitfield flags = 0);
+        //Interleaved vertices of stride bytes in vertex_buffer, element_buffer may be 0 for non-indexed draws
+        [[nodiscard]] GLuint CreateVertexArray(GLuint vertex_buffer, GLsizei stride,
+                                               std::initializer_list<VertexAttribute> attributes,
+                                               GLuint element_buffer = 0);
+        [[nodiscard]] GLuint CreateVertexArray(GLuint vertex_buffer, GLsizei stride,
+                                               std::span<const VertexAttribute> attributes,
+                                               GLuint element_buffer = 0);
+
+        //Levels down to 1x1, for textures with mipmaps
+        [[nodiscard]] GLsizei MipLevels(GLsizei width, GLsizei height);
+        //internal_format must be sized (GL_RGBA8, GL_SRGB8, GL_DEPTH_COMPONENT24...)
+        [[nodiscard]] GLuint CreateTexture2D(GLenum internal_format, GLsizei width, GLsizei height, GLsizei levels = 1);
+        [[nodiscard]] GLuint CreateTexture2DMultisample(GLenum internal_format, GLsizei width, GLsizei height,
+                                                        GLsizei samples);
+        //Six square faces, uploaded with glTextureSubImage3D, the face index as z
+        [[nodiscard]] GLuint CreateTextureCube(GLenum internal_format, GLsizei size, GLsizei levels = 1);
+        //Filters and wrap mode of every axis
+        void SetSampling(GLuint texture, GLenum min_filter, GLenum mag_filter, GLenum wrap);
+
+        [[nodiscard]] GLuint CreateRenderbuffer(GLenum internal_format, GLsizei width, GLsizei height,
+                                                GLsizei samples = 0);
+        [[nodiscard]] GLuint CreateFramebuffer();
+        //Prints name and the status when framebuffer is not complete
+        bool CheckFramebuffer(GLuint framebuffer, std::string_view name);
+    }
+} // namespace gpr5300
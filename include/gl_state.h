@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+#include <GL/glew.h>
+
+namespace gpr5300
+{
+    //Shadow copy of the GL bindings and fixed function state, so binding what is already bound costs no GL call.
+    //Every bind, enable and delete of the engine, its helpers and the scenes goes through these functions instead
+    //of the gl* function of the same name: a raw call would leave the copy stale and make a later bind be skipped.
+    //GL thread only, one context.
+    namespace GlState
+    {
+        struct Counters
+        {
+            std::uint64_t issued = 0;
+            std::uint64_t skipped = 0;
+        };
+
+        void UseProgram(GLuint program);
+        void BindProgramPipeline(GLuint pipeline);
+        void BindVertexArray(GLuint vertex_array);
+        void ActiveTexture(GLenum unit);
+        //On the active unit, like glBindTexture
+        void BindTexture(GLenum target, GLuint texture);
+        void BindFramebuffer(GLenum target, GLuint framebuffer);
+
+        void Enable(GLenum capability);
+        void Disable(GLenum capability);
+        void DepthFunc(GLenum function);
+        void DepthMask(GLboolean mask);
+        void CullFace(GLenum mode);
+        void BlendFunc(GLenum source, GLenum destination);
+
+        //Deleting an object bound reverts its bindings to 0, and GL may hand out its name again
+        void DeleteProgram(GLuint program);
+        void DeleteProgramPipelines(GLsizei count, const GLuint* pipelines);
+        void DeleteVertexArrays(GLsizei count, const GLuint* vertex_arrays);
+        void DeleteTextures(GLsizei count, const GLuint* textures);
+        void DeleteFramebuffers(GLsizei count, const GLuint* framebuffers);
+        //Programs deleted so far: what is cached by program name is stale once it changes, the name may be reused
+        [[nodiscard]] std::uint64_t ProgramDeletions();
+
+        //Forgets the copy, the next call of each kind reaches GL. After code changing the state around the cache.
+        void Invalidate();
+
+        //Once per frame on the GL thread: the counters of the frame are kept for LastFrame and restarted, and the
+        //copy is invalidated so what the ImGui backend or the driver changed cannot leak into the next frame
+        void EndFrame();
+        //Calls of the last complete frame that reached GL and those skipped, readable from any thread
+        [[nodiscard]] Counters LastFrame();
+        //Since the start, for the benchmark averages
+        [[nodiscard]] Counters Total();
+    }
+} // namespace gpr5300
@@ -4,13 +4,14 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
+#include "gl_state.h"
 #include "shader.h"
 
 // renderCube() renders a 1x1 3D cube in NDC.
 // -------------------------------------------------
-unsigned int cubeVAO = 0;
-unsigned int cubeVBO = 0;
-void renderCube()
+inline unsigned int cubeVAO = 0;
+inline unsigned int cubeVBO = 0;
+inline void renderCube()
 {
     // initialize (if necessary)
     if (cubeVAO == 0)
@@ -65,7 +66,7 @@ void renderCube()
         glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
         // link vertex attributes
-        glBindVertexArray(cubeVAO);
+        gpr5300::GlState::BindVertexArray(cubeVAO);
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(1);
@@ -73,19 +74,18 @@ void renderCube()
         glEnableVertexAttribArray(2);
         glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
         glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+        gpr5300::GlState::BindVertexArray(0);
     }
     // render Cube
-    glBindVertexArray(cubeVAO);
+    gpr5300::GlState::BindVertexArray(cubeVAO);
     glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
 }
 
 // renderQuad() renders a 1x1 XY quad in NDC
 // -----------------------------------------
-unsigned int quadVAO = 0;
-unsigned int quadVBO;
-void renderQuad()
+inline unsigned int quadVAO = 0;
+inline unsigned int quadVBO;
+inline void renderQuad()
 {
     if (quadVAO == 0)
     {
@@ -99,7 +99,7 @@ void renderQuad()
         // setup plane VAO
         glGenVertexArrays(1, &quadVAO);
         glGenBuffers(1, &quadVBO);
-        glBindVertexArray(quadVAO);
+        gpr5300::GlState::BindVertexArray(quadVAO);
         glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
@@ -107,9 +107,8 @@ void renderQuad()
         glEnableVertexAttribArray(1);
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
     }
-    glBindVertexArray(quadVAO);
+    gpr5300::GlState::BindVertexArray(quadVAO);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
 }
 
 //Render quad with normal map
@@ -185,7 +184,7 @@ inline void normal_renderQuad()
         // configure plane VAO
         glGenVertexArrays(1, &normal_quadVAO);
         glGenBuffers(1, &normal_quadVBO);
-        glBindVertexArray(normal_quadVAO);
+        gpr5300::GlState::BindVertexArray(normal_quadVAO);
         glBindBuffer(GL_ARRAY_BUFFER, normal_quadVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
@@ -199,9 +198,8 @@ inline void normal_renderQuad()
         glEnableVertexAttribArray(4);
         glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(11 * sizeof(float)));
     }
-    glBindVertexArray(normal_quadVAO);
+    gpr5300::GlState::BindVertexArray(normal_quadVAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
 }
 
 inline void renderScene(const Shader &shader, GLuint planeVAO)
@@ -209,7 +207,7 @@ inline void renderScene(const Shader &shader, GLuint planeVAO)
     // floor
     glm::mat4 model = glm::mat4(1.0f);
     shader.SetMat4("model", model);
-    glBindVertexArray(planeVAO);
+    gpr5300::GlState::BindVertexArray(planeVAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
     // cubes
     model = glm::mat4(1.0f);
@@ -307,7 +305,7 @@ inline void renderSphere()
                 data.push_back(uv[i].y);
             }
         }
-        glBindVertexArray(sphereVAO);
+        gpr5300::GlState::BindVertexArray(sphereVAO);
         glBindBuffer(GL_ARRAY_BUFFER, vbo);
         glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
@@ -321,7 +319,7 @@ inline void renderSphere()
         glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
     }
 
-    glBindVertexArray(sphereVAO);
+    gpr5300::GlState::BindVertexArray(sphereVAO);
     glDrawElements(GL_TRIANGLE_STRIP, indexCount, GL_UNSIGNED_INT, 0);
 }
 
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "frame_statistics.h"
+
+namespace gpr5300
+{
+    //Measures named render passes with GL_TIME_ELAPSED queries. Every frame owns its own set of queries
+    //and results are only read back frames_in_flight frames later, so the profiler never waits on the GPU.
+    //Passes are sequential, GL_TIME_ELAPSED queries cannot nest.
+    //With the render thread, queries are issued there while DrawImGui runs on the simulation thread.
+    class GpuProfiler
+    {
+    public:
+        static constexpr int frames_in_flight = 3;
+        static constexpr int history_length = 240;
+
+        static GpuProfiler& Get();
+
+        void Create();
+        void Destroy();
+
+        void BeginFrame();
+        void EndFrame();
+        void BeginPass(std::string_view name);
+        void EndPass();
+
+        void DrawImGui();
+        bool ExportCsv(std::string_view path) const;
+
+        //Keep every sample (not just the rolling history) to print percentiles at exit
+        void SetCollectStatistics(const bool collect) { collect_statistics_ = collect; }
+        void PrintStatistics() const;
+
+        bool visible_ = false;
+
+    private:
+        struct PassQuery
+        {
+            std::size_t pass_index = 0;
+            GLuint query = 0;
+        };
+
+        struct FrameQueries
+        {
+            std::uint64_t frame_index = 0;
+            bool pending = false;
+            GLuint frame_begin = 0;
+            GLuint frame_end = 0;
+            std::vector<GLuint> pool;
+            std::vector<PassQuery> passes;
+        };
+
+        struct PassHistory
+        {
+            std::string name;
+            std::array<float, history_length> samples{};
+            //False for the frames dropped, not resolved yet, or in which the pass did not run: their sample is 0
+            std::array<bool, history_length> valid{};
+            float last = 0.0f;
+            FrameStatistics statistics;
+        };
+
+        std::size_t FindOrAddPass(std::string_view name);
+        void Resolve(FrameQueries& frame);
+        void Record(PassHistory& history, std::size_t slot, float milliseconds) const;
+        //One past the last frame read back, the frames_in_flight frames after it still hold older samples
+        [[nodiscard]] std::uint64_t ResolvedEnd() const;
+
+        std::array<FrameQueries, frames_in_flight> frames_{};
+        //Guards what DrawImGui and the exports read: the pass histories, frame_index_ and dropped_frames_
+        mutable std::mutex history_mutex_;
+        std::vector<PassHistory> passes_;
+        PassHistory frame_history_{"Frame"};
+        std::uint64_t frame_index_ = 0;
+        std::uint64_t dropped_frames_ = 0;
+        int pass_depth_ = 0;
+        bool created_ = false;
+        bool collect_statistics_ = false;
+    };
+
+    //Times the enclosing scope as one pass
+    class ScopedGpuPass
+    {
+    public:
+        explicit ScopedGpuPass(const std::string_view name) { GpuProfiler::Get().BeginPass(name); }
+        ~ScopedGpuPass() { GpuProfiler::Get().EndPass(); }
+        ScopedGpuPass(const ScopedGpuPass&) = delete;
+        ScopedGpuPass& operator=(const ScopedGpuPass&) = delete;
+    };
+} // namespace gpr5300
@@ -0,0 +1,25 @@
+#pragma once
+
+namespace gpr5300
+{
+    //OpenGL 4.5 core context without any window, backed by an EGL pbuffer on Mesa's surfaceless platform
+    //(llvmpipe works). The pbuffer acts as the default framebuffer, so scenes binding FBO 0 still render.
+    //Only available when built with GPR5300_HEADLESS_EGL, Create() returns false otherwise.
+    class HeadlessContext
+    {
+    public:
+        bool Create(int width, int height);
+        void Destroy();
+        void Present() const;
+        //Binds the context to the calling thread, or releases it
+        void MakeCurrent(bool current) const;
+
+        [[nodiscard]] bool IsValid() const { return context_ != nullptr; }
+
+    private:
+        //EGLDisplay, EGLSurface and EGLContext, kept opaque so EGL headers do not leak in the engine
+        void* display_ = nullptr;
+        void* surface_ = nullptr;
+        void* context_ = nullptr;
+    };
+} // namespace gpr5300
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/mat4x4.hpp>
+
+#include "mesh.h"
+
+namespace gpr5300
+{
+    //Layout of a glMultiDrawElementsIndirect command
+    struct DrawElementsIndirectCommand
+    {
+        GLuint count = 0;
+        GLuint instance_count = 0;
+        GLuint first_index = 0;
+        GLint base_vertex = 0;
+        GLuint base_instance = 0;
+    };
+
+    //std430 layout of a DrawData entry, read by the vertex shader at draws[gl_DrawIDARB]
+    struct DrawData
+    {
+        glm::mat4 model;
+    };
+
+    static_assert(sizeof(DrawElementsIndirectCommand) == 20 && sizeof(DrawData) == 64,
+                  "Indirect draw structs must match their GL layout");
+
+    //Draws meshes of Mesh::Arena with one glMultiDrawElementsIndirect per batch instead of a bind and a
+    //glDrawElements per mesh. Meshes are queued with Add, a model or a whole scene, and batched by arena page and
+    //textures: meshes sharing their material go out in a single call. Submit writes the commands and the DrawData of
+    //the frame, the DrawData of each batch from an aligned offset of the storage buffer at draw_data_binding so the
+    //shader indexes it with gl_DrawIDARB alone. GL thread only.
+    class IndirectRenderer
+    {
+    public:
+        static constexpr GLuint draw_data_binding = 3;
+
+        //gl_DrawIDARB needs GL_ARB_shader_draw_parameters, draw with Mesh::Draw without it
+        [[nodiscard]] static bool Supported();
+
+        void Create();
+        void Destroy();
+
+        void Add(const Mesh& mesh, const DrawData& data);
+        //Draws and clears the queue, shader must be in use. The textures of each batch are bound for shader.
+        void Submit(GLuint shader);
+
+        //Meshes and glMultiDrawElementsIndirect calls of the last Submit
+        [[nodiscard]] std::size_t DrawCount() const { return draw_count_; }
+        [[nodiscard]] std::size_t CallCount() const { return call_count_; }
+
+    private:
+        struct Batch
+        {
+            std::size_t page = 0;
+            std::vector<Texture> textures;
+            std::vector<DrawElementsIndirectCommand> commands;
+            std::vector<DrawData> draws;
+        };
+
+        std::vector<Batch> batches_;
+        std::vector<DrawElementsIndirectCommand> commands_;
+        std::vector<std::byte> draw_data_;
+        GLuint command_buffer_ = 0;
+        GLuint draw_buffer_ = 0;
+        std::size_t alignment_ = 256;
+        std::size_t draw_count_ = 0;
+        std::size_t call_count_ = 0;
+    };
+} // namespace gpr5300
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+#include <SDL.h>
+
+namespace gpr5300
+{
+    //Per frame input seen by the scenes: the SDL events, the keyboard state and the relative mouse motion,
+    //sampled once per frame by the Engine. It can be recorded to a binary file together with each frame dt,
+    //then replayed so a camera fly-through renders identically across runs and builds.
+    class Input
+    {
+    public:
+        bool StartRecording(std::string_view path);
+        bool StartReplay(std::string_view path);
+        void Stop();
+
+        [[nodiscard]] bool IsRecording() const { return recording_; }
+        [[nodiscard]] bool IsReplaying() const { return replaying_; }
+
+        //Once per frame, events holds what SDL_PollEvent returned and dt the measured frame time.
+        //Recording writes them with the device state. Replaying substitutes the next recorded frame, only quit
+        //requests survive from the live events. Returns false once the replay is over.
+        bool BeginFrame(std::vector<SDL_Event>& events, float& dt);
+
+        //Use instead of SDL_GetKeyboardState / SDL_GetRelativeMouseState so replays are deterministic.
+        //The motion accumulates until read, like SDL does.
+        [[nodiscard]] const Uint8* GetKeyboardState() const;
+        Uint32 GetRelativeMouseState(int* x, int* y);
+
+        //Total motion arrived since BeginFrame, for the late latch. Live it pumps the SDL events, so only on the
+        //thread owning the window, and the motion joins the next frame, recorded with it. Replaying it is the
+        //motion recorded for the next frame. GetRelativeMouseState reports it on the next frame either way.
+        void SampleLateMouseMotion(int* x, int* y);
+
+    private:
+        void WriteFrame(const std::vector<SDL_Event>& events, float dt, int mouse_x, int mouse_y);
+        bool ReadFrame(std::vector<SDL_Event>& events, float& dt, int& mouse_x, int& mouse_y);
+
+        bool recording_ = false;
+        bool replaying_ = false;
+        std::ofstream record_file_;
+        std::ifstream replay_file_;
+
+        //Last recorded or replayed keyboard, the file only stores the keys that changed
+        std::array<Uint8, SDL_NUM_SCANCODES> keys_{};
+        int mouse_x_ = 0;
+        int mouse_y_ = 0;
+        Uint32 mouse_buttons_ = 0;
+        int late_x_ = 0;
+        int late_y_ = 0;
+        bool late_sampled_ = false;
+    };
+} // namespace gpr5300
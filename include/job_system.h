@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace gpr5300
+{
+    class JobCounter;
+
+    struct Job
+    {
+        std::function<void()> task;
+        JobCounter* counter = nullptr;
+    };
+
+    //Number of unfinished jobs in a group: wait on it with JobSystem::Wait or chain jobs with ScheduleAfter.
+    //A counter must not be destroyed before JobSystem::Wait returned on it.
+    class JobCounter
+    {
+    public:
+        [[nodiscard]] bool IsDone() const { return pending_.load(std::memory_order_acquire) == 0; }
+
+    private:
+        friend class JobSystem;
+        std::atomic<int> pending_{0};
+        std::mutex mutex_;
+        std::vector<Job> continuations_;
+    };
+
+    //Work stealing thread pool. Each thread owns a deque: it pushes and pops its own jobs at the back (newest
+    //first, data still in cache) and steals from the front of the others when it runs dry. The thread calling
+    //Create is thread 0, it runs jobs whenever it waits on a counter instead of blocking.
+    class JobSystem
+    {
+    public:
+        //0 uses every hardware thread, the calling thread included
+        void Create(int thread_count = 0);
+        //Runs the jobs still queued then joins the workers
+        void Destroy();
+
+        void Schedule(std::function<void()> task, JobCounter* counter = nullptr);
+        //Queues task once dependency reached zero
+        void ScheduleAfter(JobCounter& dependency, std::function<void()> task, JobCounter* counter = nullptr);
+        //Runs queued jobs until counter reaches zero
+        void Wait(JobCounter& counter);
+
+        //Calls fn(begin, end) on chunks of at most grain_size indices of [0, count) and waits for all of them,
+        //runs inline when the range fits in one chunk or the system is not created
+        template <typename Function>
+        void ParallelFor(std::size_t count, std::size_t grain_size, Function&& fn);
+
+        [[nodiscard]] std::size_t ThreadCount() const { return queues_.size(); }
+
+    private:
+        struct WorkQueue
+        {
+            std::mutex mutex;
+            std::deque<Job> jobs;
+        };
+
+        void Push(Job job);
+        bool Pop(Job& job);
+        void Execute(Job& job);
+        void WorkerLoop(std::size_t index);
+
+        std::vector<std::unique_ptr<WorkQueue>> queues_;
+        std::vector<std::thread> workers_;
+        std::atomic<int> queued_jobs_{0};
+        std::atomic<bool> running_{false};
+        std::mutex sleep_mutex_;
+        std::condition_variable wake_;
+    };
+
+    template <typename Function>
+    void JobSystem::ParallelFor(const std::size_t count, std::size_t grain_size, Function&& fn)
+    {
+        grain_size = std::max<std::size_t>(grain_size, 1);
+        if (queues_.size() <= 1 || count <= grain_size)
+        {
+            fn(std::size_t{0}, count);
+            return;
+        }
+        JobCounter counter;
+        for (std::size_t begin = grain_size; begin < count; begin += grain_size)
+        {
+            const std::size_t end = std::min(begin + grain_size, count);
+            Schedule([&fn, begin, end] { fn(begin, end); }, &counter);
+        }
+        //The caller takes the first chunk itself instead of waiting idle
+        fn(std::size_t{0}, grain_size);
+        Wait(counter);
+    }
+
+    //jobs->ParallelFor, or fn(0, count) on the calling thread when there is no job system
+    template <typename Function>
+    void ParallelFor(JobSystem* jobs, const std::size_t count, const std::size_t grain_size, Function&& fn)
+    {
+        if (jobs != nullptr)
+        {
+            jobs->ParallelFor(count, grain_size, std::forward<Function>(fn));
+        }
+        else
+        {
+            fn(std::size_t{0}, count);
+        }
+    }
+} // namespace gpr5300
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <mutex>
+
+#include <GL/glew.h>
+#include <glm/mat4x4.hpp>
+
+struct FreeCamera;
+
+namespace gpr5300
+{
+    class FrameUniforms;
+    class Input;
+
+    //Late latched camera: the view is not baked in the frame when the simulation runs but written into the ViewData
+    //uniform block of FrameUniforms right before the main pass draws, from the mouse motion that arrived in the meantime.
+    //The motion is sampled through Input, so it is recorded and replayed, and reaches the simulation on its next frame:
+    //the latched camera is a copy, it never loses nor doubles motion.
+    class LateLatch
+    {
+    public:
+        //sample_in_latch: single threaded the latch runs on the thread owning the SDL window and samples the motion
+        //itself. With the render thread the engine calls Sample once the frame is recorded instead.
+        void Create(Input* input, FrameUniforms* uniforms, bool sample_in_latch);
+        void Destroy();
+
+        //Thread owning the window, once the previous frame replayed and before the next Submit: takes the motion
+        //arrived since the simulation read the mouse, for the latch of the frame about to be submitted
+        void Sample();
+
+        //GL thread, right before the main pass: applies the sampled motion to a copy of the camera and uploads its
+        //view. mouse_look is the simulation decision to rotate the camera or not.
+        void Latch(FreeCamera camera, const glm::mat4& projection, bool mouse_look);
+
+    private:
+        Input* input_ = nullptr;
+        FrameUniforms* uniforms_ = nullptr;
+        bool sample_in_latch_ = false;
+
+        std::mutex mutex_;
+        int late_x_ = 0;
+        int late_y_ = 0;
+    };
+} // namespace gpr5300
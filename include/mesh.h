@@ -1,11 +1,20 @@
 ﻿#ifndef MESH_H
 #define MESH_H
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <GL/glew.h>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 
+#include "geometry_arena.h"
+#include "gl_resources.h"
+#include "gl_state.h"
+
 struct Vertex{
   glm::vec3 Position;
   glm::vec3 Normal;
@@ -21,76 +30,98 @@ struct Vertex{
   class Mesh
   {
   public:
-    //Mesh data
-    std::vector<Vertex> vertices_;
-    std::vector<unsigned int> indices_;
+    //Mesh data, the vertices and indices only live on the GPU, in Arena
     std::vector<Texture> textures_;
 
-    [[nodiscard]] unsigned int VAO() const {return VAO_;}
+    //Vertex array of the arena page holding the mesh, draw it with Range
+    [[nodiscard]] unsigned int VAO() const {return Arena().GetPage(range_.page).vertex_array;}
+    [[nodiscard]] GLsizei IndexCount() const {return range_.index_count;}
+    [[nodiscard]] const gpr5300::GeometryArena::Range& Range() const {return range_;}
+
+    //Shared storage of every Mesh, the owner of a mesh releases its Range. Destroyed by Engine::End.
+    static gpr5300::GeometryArena& Arena()
+    {
+      static gpr5300::GeometryArena arena(sizeof(Vertex), {
+          {0, 3, GL_FLOAT, offsetof(Vertex, Position)}, // vertex positions
+          {1, 3, GL_FLOAT, offsetof(Vertex, Normal)}, // vertex normals
+          {2, 2, GL_FLOAT, offsetof(Vertex, TexCoords)}, // vertex texture coords
+      });
+      return arena;
+    }
 
-    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures)
+    //Uploads straight from the spans, which may point into a mapped mesh cache file
+    Mesh(std::span<const Vertex> vertices, std::span<const unsigned int> indices, std::vector<Texture> textures)
+    {
+      this->textures_ = std::move(textures);
+      range_ = Arena().Allocate(vertices.data(), vertices.size(), indices);
+    }
+    void Draw(const GLuint shader) const
     {
-      this->vertices_ = vertices;
-      this->indices_ = indices;
-      this->textures_ = textures;
+      BindTextures(shader, textures_);
 
-      SetupMesh();
+      // draw mesh
+      gpr5300::GlState::BindVertexArray(VAO());
+      glDrawElementsBaseVertex(GL_TRIANGLES, range_.index_count, GL_UNSIGNED_INT,
+                               reinterpret_cast<const void*>(range_.first_index * sizeof(unsigned int)),
+                               range_.base_vertex);
     }
-    void Draw(GLuint& shader)
+
+    //Binds textures to the units 0, 1... and points the material samplers of shader at them
+    static void BindTextures(const GLuint shader, const std::vector<Texture>& textures)
     {
       unsigned int diffuseNr = 1;
       unsigned int specularNr = 1;
-      for(unsigned int i = 0; i < textures_.size(); i++)
+      for(unsigned int i = 0; i < textures.size(); i++)
       {
-        glActiveTexture(GL_TEXTURE0 + i); // activate proper texture unit before binding
+        gpr5300::GlState::ActiveTexture(GL_TEXTURE0 + i); // activate proper texture unit before binding
         // retrieve texture number (the N in diffuse_textureN)
-        std::string number;
-        std::string name = textures_[i].type;
+        unsigned int number = 0;
+        const std::string& name = textures[i].type;
         if(name == "texture_diffuse")
-          number = std::to_string(diffuseNr++);
+          number = diffuseNr++;
         else if(name == "texture_specular")
-          number = std::to_string(specularNr++);
+          number = specularNr++;
 
-        glUniform1i(glGetUniformLocation(shader, ("material." + name).append(number).c_str()), i);
-        glBindTexture(GL_TEXTURE_2D, textures_[i].id);
+        glUniform1i(SamplerLocation(shader, name, number), i);
+        gpr5300::GlState::BindTexture(GL_TEXTURE_2D, textures[i].id);
       }
-      glActiveTexture(GL_TEXTURE0);
-
-      // draw mesh
-      glBindVertexArray(VAO_);
-      glDrawElements(GL_TRIANGLES, indices_.size(), GL_UNSIGNED_INT, 0);
-      glBindVertexArray(0);
+      gpr5300::GlState::ActiveTexture(GL_TEXTURE0);
     }
   private:
-    //Render data
-    unsigned int VAO_, VBO_, EBO_;
-    void SetupMesh()
+    //Location of "material." + type + number in program (no number when 0), the name is only built and looked up
+    //the first time a program draws with it
+    static GLint SamplerLocation(const GLuint program, const std::string& type, const unsigned int number)
     {
-      glGenVertexArrays(1, &VAO_);
-      glGenBuffers(1, &VBO_);
-      glGenBuffers(1, &EBO_);
-
-      glBindVertexArray(VAO_);
-      glBindBuffer(GL_ARRAY_BUFFER, VBO_);
-
-      glBufferData(GL_ARRAY_BUFFER, vertices_.size() * sizeof(Vertex), &vertices_[0], GL_STATIC_DRAW);
-
-      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_);
-      glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.size() * sizeof(unsigned int),
-                   &indices_[0], GL_STATIC_DRAW);
-
-      // vertex positions
-      glEnableVertexAttribArray(0);
-      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-      // vertex normals
-      glEnableVertexAttribArray(1);
-      glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-      // vertex texture coords
-      glEnableVertexAttribArray(2);
-      glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-
-      glBindVertexArray(0);
+      struct Sampler
+      {
+        std::string type;
+        unsigned int number;
+        GLint location;
+      };
+      static std::unordered_map<GLuint, std::vector<Sampler>> programs;
+      static std::uint64_t program_deletions = 0;
+      //A new program may have the name of a deleted one
+      if(program_deletions != gpr5300::GlState::ProgramDeletions())
+      {
+        programs.clear();
+        program_deletions = gpr5300::GlState::ProgramDeletions();
+      }
+      std::vector<Sampler>& samplers = programs[program];
+      for(const Sampler& sampler : samplers)
+      {
+        if(sampler.number == number && sampler.type == type)
+          return sampler.location;
+      }
+      std::string uniform = "material." + type;
+      if(number > 0)
+        uniform += std::to_string(number);
+      const GLint location = glGetUniformLocation(program, uniform.c_str());
+      samplers.push_back({type, number, location});
+      return location;
     }
+
+    //Render data
+    gpr5300::GeometryArena::Range range_;
   };
 
 #endif //MESH_H
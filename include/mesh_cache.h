@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "file_utility.h"
+#include "mesh.h"
+
+namespace gpr5300
+{
+    //Axis aligned box around the vertex positions
+    struct MeshBounds
+    {
+        glm::vec3 min{0.0f};
+        glm::vec3 max{0.0f};
+    };
+
+    //On-disk copy of imported models (interleaved vertices, indices, texture references and bounds), written the
+    //first time a source file is imported so the next launches map it instead of running Assimp. An entry is keyed by
+    //the source path and stamped with the size and write time of the source and of the files next to it sharing its
+    //name (.mtl, glTF .bin): editing any of them invalidates it. Thread safe once the directory is set.
+    namespace MeshCache
+    {
+        struct MeshView
+        {
+            std::span<const Vertex> vertices;
+            std::span<const unsigned int> indices;
+            //Indices in the texture references of the model
+            std::vector<std::size_t> textures;
+            MeshBounds bounds;
+        };
+
+        struct TextureReference
+        {
+            std::string type;
+            std::string path;
+        };
+
+        //Content of an entry, the mesh spans point into file
+        struct CachedModel
+        {
+            MappedFile file;
+            std::vector<MeshView> meshes;
+            std::vector<TextureReference> textures;
+        };
+
+        //Directory of the cache files, created on the first save. Empty disables the cache.
+        void SetDirectory(std::string_view directory);
+
+        [[nodiscard]] MeshBounds ComputeBounds(std::span<const Vertex> vertices);
+
+        //Maps the entry of source_path, false when there is none or the source changed since it was written
+        bool Load(const std::string& source_path, CachedModel& model);
+        void Save(const std::string& source_path, std::span<const MeshView> meshes,
+                  std::span<const TextureReference> textures);
+
+        [[nodiscard]] std::size_t Hits();
+        [[nodiscard]] std::size_t Misses();
+    }
+} // namespace gpr5300
@@ -2,42 +2,142 @@
 #define MODEL_H
 #include <iostream>
 #include <GL/glew.h>
+#include <glm/common.hpp>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
 #include "mesh.h"
+#include "mesh_cache.h"
+#include "cpu_tracer.h"
+#include "indirect_renderer.h"
+#include "job_system.h"
 #include "stb_image.h"
 #include "texture_loader.h"
 
-unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma = false);
+//CPU side content of a model file. Building it makes no GL call so Model::Import can run on a job system worker,
+//Model(ModelData) then uploads it on the GL thread.
+struct ModelData
+{
+    struct MeshData
+    {
+        //Into imported_vertices and imported_indices after an Assimp import, into cache_file after a cache hit
+        std::span<const Vertex> vertices;
+        std::span<const unsigned int> indices;
+        std::vector<std::size_t> textures; //Indices in ModelData::textures
+        gpr5300::MeshBounds bounds;
+        std::vector<Vertex> imported_vertices;
+        std::vector<unsigned int> imported_indices;
+    };
+
+    struct TextureData
+    {
+        std::string type;
+        std::string path;
+        Image image;
+    };
+
+    std::vector<MeshData> meshes;
+    std::vector<TextureData> textures; //Decoded once per path
+    gpr5300::MappedFile cache_file;
+
+    ModelData() = default;
+    ModelData(ModelData&&) = default;
+    ModelData& operator=(ModelData&&) = default;
+    ModelData(const ModelData&) = delete;
+    ModelData& operator=(const ModelData&) = delete;
+    ~ModelData()
+    {
+        for (auto& texture : textures)
+            FreeImage(texture.image);
+    }
+};
 
 class Model
 {
 public:
     Model() = default;
-    explicit Model(const char* path)
+    //Owns the arena ranges of its meshes: moved, never copied
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+    Model(Model&& other) noexcept
+        : textures_loaded(std::move(other.textures_loaded)), meshes_(std::move(other.meshes_)), bounds_(other.bounds_)
     {
-        LoadModel(path);
+        other.meshes_.clear();
     }
-
-    void Draw(GLuint& shader)
+    Model& operator=(Model&& other) noexcept
     {
-        for (auto& meshe : meshes_)
-            meshe.Draw(shader);
+        if (this != &other)
+        {
+            ReleaseMeshes();
+            textures_loaded = std::move(other.textures_loaded);
+            meshes_ = std::move(other.meshes_);
+            bounds_ = other.bounds_;
+            other.meshes_.clear();
+        }
+        return *this;
+    }
+    //Gives the geometry of the meshes back to Mesh::Arena, on the GL thread like the upload
+    ~Model()
+    {
+        ReleaseMeshes();
     }
 
-    [[nodiscard]] std::vector<Mesh> meshes(){return meshes_;}
-    [[nodiscard]] std::vector<Texture> get_textures_loaded(){return textures_loaded;}
+    explicit Model(const char* path, gpr5300::JobSystem* jobs = nullptr) : Model(Import(path, jobs))
+    {
+    }
 
-private:
-    //Model data
-    std::vector<Texture> textures_loaded;	//Make sure textures are loaded once.
-    std::vector<Mesh> meshes_;
-    std::string directory_;
+    //Uploads an imported model, must run on the GL thread
+    explicit Model(ModelData data)
+    {
+        gpr5300::ScopedZone zone("Model::Upload");
+        textures_loaded.reserve(data.textures.size());
+        for (auto& texture : data.textures)
+        {
+            textures_loaded.push_back({TextureFromImage(texture.image), texture.type, texture.path});
+            FreeImage(texture.image);
+        }
+        meshes_.reserve(data.meshes.size());
+        for (auto& mesh : data.meshes)
+        {
+            std::vector<Texture> textures;
+            for (const std::size_t texture : mesh.textures)
+                textures.push_back(textures_loaded[texture]);
+            meshes_.emplace_back(mesh.vertices, mesh.indices, std::move(textures));
+            if (meshes_.size() == 1)
+                bounds_ = mesh.bounds;
+            bounds_.min = glm::min(bounds_.min, mesh.bounds.min);
+            bounds_.max = glm::max(bounds_.max, mesh.bounds.max);
+        }
+    }
 
-    void LoadModel(const std::string& path)
+    //Mesh cache entry or Assimp import, and texture decoding, thread safe. An Assimp import writes the cache entry.
+    //With jobs, meshes are converted and textures decoded in parallel, each into its own preallocated slot: the
+    //result is the same as a serial import whatever the scheduling.
+    static ModelData Import(const std::string& path, gpr5300::JobSystem* jobs = nullptr)
     {
+        gpr5300::ScopedZone zone("Model::Import");
+        ModelData data;
+        const std::string directory = path.substr(0, path.find_last_of('/'));
+        if (gpr5300::MeshCache::CachedModel cached; gpr5300::MeshCache::Load(path, cached))
+        {
+            data.textures.resize(cached.textures.size());
+            for (std::size_t i = 0; i < cached.textures.size(); i++)
+            {
+                data.textures[i].type = std::move(cached.textures[i].type);
+                data.textures[i].path = std::move(cached.textures[i].path);
+            }
+            gpr5300::ParallelFor(jobs, data.textures.size(), 1, [&data, &directory](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t i = begin; i < end; i++)
+                    DecodeTexture(data.textures[i], directory);
+            });
+            for (auto& mesh : cached.meshes)
+                data.meshes.push_back({mesh.vertices, mesh.indices, std::move(mesh.textures), mesh.bounds, {}, {}});
+            data.cache_file = std::move(cached.file);
+            return data;
+        }
+
         Assimp::Importer import;
 
         const aiScene* scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
@@ -45,196 +145,174 @@ private:
         if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
         {
             std::cout << "ERROR::ASSIMP::" << import.GetErrorString() << std::endl;
-            return;
+            return data;
+        }
+
+        //Mesh order and texture slots only depend on the file, settled serially before any conversion
+        std::vector<const aiMesh*> meshes;
+        CollectMeshes(scene->mRootNode, scene, meshes);
+        data.meshes.resize(meshes.size());
+        for (std::size_t i = 0; i < meshes.size(); i++)
+        {
+            const aiMaterial* material = scene->mMaterials[meshes[i]->mMaterialIndex];
+            LoadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", data, data.meshes[i].textures);
+            LoadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular", data, data.meshes[i].textures);
         }
-        directory_ = path.substr(0, path.find_last_of('/'));
 
-        ProcessNode(scene->mRootNode, scene);
+        //One job per mesh then per texture, the scene is only read
+        const std::size_t mesh_count = meshes.size();
+        gpr5300::ParallelFor(jobs, mesh_count + data.textures.size(), 1,
+                             [&meshes, &data, &directory, mesh_count](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                if (i < mesh_count)
+                    ProcessMesh(meshes[i], data.meshes[i]);
+                else
+                    DecodeTexture(data.textures[i - mesh_count], directory);
+            }
+        });
+
+        std::vector<gpr5300::MeshCache::MeshView> views;
+        views.reserve(data.meshes.size());
+        for (const auto& mesh : data.meshes)
+            views.push_back({mesh.vertices, mesh.indices, mesh.textures, mesh.bounds});
+        std::vector<gpr5300::MeshCache::TextureReference> references;
+        references.reserve(data.textures.size());
+        for (const auto& texture : data.textures)
+            references.push_back({texture.type, texture.path});
+        gpr5300::MeshCache::Save(path, views, references);
+        return data;
     }
 
-    void ProcessNode(aiNode* node, const aiScene* scene)
+    void Draw(const GLuint shader)
+    {
+        for (auto& meshe : meshes_)
+            meshe.Draw(shader);
+    }
+
+    //Queues every mesh into renderer with transform as model matrix, drawn by its next Submit
+    void Draw(gpr5300::IndirectRenderer& renderer, const glm::mat4& transform) const
+    {
+        for (const auto& meshe : meshes_)
+            renderer.Add(meshe, {transform});
+    }
+
+    [[nodiscard]] std::vector<Mesh> meshes(){return meshes_;}
+    [[nodiscard]] std::vector<Texture> get_textures_loaded(){return textures_loaded;}
+    [[nodiscard]] const gpr5300::MeshBounds& bounds() const {return bounds_;}
+
+private:
+    //Model data
+    std::vector<Texture> textures_loaded;	//Make sure textures are loaded once.
+    std::vector<Mesh> meshes_;
+    gpr5300::MeshBounds bounds_;
+
+    void ReleaseMeshes()
+    {
+        for (const auto& meshe : meshes_)
+            Mesh::Arena().Release(meshe.Range());
+        meshes_.clear();
+    }
+
+    //Meshes of node and its children, depth first like the draw order
+    static void CollectMeshes(const aiNode* node, const aiScene* scene, std::vector<const aiMesh*>& meshes)
     {
         // process all the node's meshes (if any)
         for (unsigned int i = 0; i < node->mNumMeshes; i++)
         {
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes_.push_back(ProcessMesh(mesh, scene));
+            meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
         }
         // then do the same for each of its children
         for (unsigned int i = 0; i < node->mNumChildren; i++)
         {
-            ProcessNode(node->mChildren[i], scene);
+            CollectMeshes(node->mChildren[i], scene, meshes);
         }
     }
 
-    Mesh ProcessMesh(aiMesh* mesh, const aiScene* scene)
+    //Fills the arrays and bounds of mesh_data, touches nothing else so meshes can run concurrently
+    static void ProcessMesh(const aiMesh* mesh, ModelData::MeshData& mesh_data)
     {
-        std::vector<Vertex> vertices;
-        std::vector<unsigned int> indices;
-        std::vector<Texture> textures;
+        gpr5300::ScopedZone zone("Model::ProcessMesh");
+        std::vector<Vertex>& vertices = mesh_data.imported_vertices;
+        std::vector<unsigned int>& indices = mesh_data.imported_indices;
 
         //Process vertex
+        vertices.resize(mesh->mNumVertices);
         for (unsigned int i = 0; i < mesh->mNumVertices; i++)
         {
-            Vertex vertex{};
-            glm::vec3 vector;
+            Vertex& vertex = vertices[i];
             //Positions
-            vector.x = mesh->mVertices[i].x;
-            vector.y = mesh->mVertices[i].y;
-            vector.z = mesh->mVertices[i].z;
-            vertex.Position = vector;
+            vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
             //Normals
-            vector.x = mesh->mNormals[i].x;
-            vector.y = mesh->mNormals[i].y;
-            vector.z = mesh->mNormals[i].z;
-            vertex.Normal = vector;
+            vertex.Normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
             //TexCoords
             if (mesh->mTextureCoords[0]) // does the mesh contain texture coordinates?
             {
-                glm::vec2 vec;
-                vec.x = mesh->mTextureCoords[0][i].x;
-                vec.y = mesh->mTextureCoords[0][i].y;
-                vertex.TexCoords = vec;
+                vertex.TexCoords = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
             }
             else
             {
                 vertex.TexCoords = glm::vec2(0.0f, 0.0f);
             }
-            vertices.push_back(vertex);
         }
 
-        //Process indices
-        for(unsigned int i = 0; i < mesh->mNumFaces; i++)
+        //Process indices, counted first to allocate once
+        std::size_t index_count = 0;
+        for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+            index_count += mesh->mFaces[i].mNumIndices;
+        indices.resize(index_count);
+        std::size_t index = 0;
+        for (unsigned int i = 0; i < mesh->mNumFaces; i++)
         {
-            aiFace face = mesh->mFaces[i];
-            for(unsigned int j = 0; j < face.mNumIndices; j++)
-                indices.push_back(face.mIndices[j]);
+            const aiFace& face = mesh->mFaces[i];
+            for (unsigned int j = 0; j < face.mNumIndices; j++)
+                indices[index++] = face.mIndices[j];
         }
 
-        //Process material
-        if(mesh->mMaterialIndex >= 0)
-        {
-            aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
-            std::vector<Texture> diffuseMaps = LoadMaterialTextures(material,
-                                                aiTextureType_DIFFUSE, "texture_diffuse");
-            textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-            std::vector<Texture> specularMaps = LoadMaterialTextures(material,
-                                                aiTextureType_SPECULAR, "texture_specular");
-            textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
-        }
-
-        return {vertices, indices, textures};
+        //mesh_data stays in place in ModelData::meshes, the spans stay valid
+        mesh_data.vertices = vertices;
+        mesh_data.indices = indices;
+        mesh_data.bounds = gpr5300::MeshCache::ComputeBounds(vertices);
     }
 
-    std::vector<Texture> LoadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName)
+    //Adds the texture indices of mat to textures, a path seen for the first time gets a slot in data.textures,
+    //decoded later
+    static void LoadMaterialTextures(const aiMaterial* mat, aiTextureType type, const std::string& typeName,
+                                     ModelData& data, std::vector<std::size_t>& textures)
     {
-        std::vector<Texture> textures;
         for(unsigned int i = 0; i < mat->GetTextureCount(type); i++)
         {
             aiString str;
             mat->GetTexture(type, i, &str);
             bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
+            for(std::size_t j = 0; j < data.textures.size(); j++)
             {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
+                if(std::strcmp(data.textures[j].path.data(), str.C_Str()) == 0)
                 {
-                    textures.push_back(textures_loaded[j]);
+                    textures.push_back(j);
                     skip = true;
                     break;
                 }
             }
             if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory_);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture); // add to loaded textures
+            {   // if texture hasn't been seen already, reserve its slot
+                textures.push_back(data.textures.size());
+                data.textures.push_back({typeName, str.C_Str(), {}});
             }
         }
-        return textures;
     }
-};
-
 
-unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma)
-{
-    std::string filename = std::string(path);
-    filename = directory + '/' + filename;
-
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
+    static void DecodeTexture(ModelData::TextureData& texture, const std::string& directory)
     {
-        GLenum internal_format;
-        GLenum data_format;
-        if (nrComponents == 1)
+        gpr5300::ScopedZone zone("Model::DecodeTexture");
+        texture.image = DecodeImage((directory + '/' + texture.path).c_str());
+        if (texture.image.pixel == nullptr)
         {
-            internal_format = data_format = GL_RED;
+            std::cout << "Texture failed to load at path: " << texture.path << std::endl;
         }
-        else if (nrComponents == 3)
-        {
-            internal_format = gamma ? GL_SRGB : GL_RGB;
-            data_format = GL_RGB;
-        }
-        else if (nrComponents == 4)
-        {
-            internal_format = gamma ? GL_SRGB_ALPHA : GL_RGBA;
-            data_format = GL_RGBA;
-        }
-
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, data_format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, data_format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, data_format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
     }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
-unsigned int CubemapFromVec(std::vector<std::string> faces)
-{
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+};
 
-    int width, height, nrChannels;
-    for (unsigned int i = 0; i < faces.size(); i++)
-    {
-        unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-        if (data)
-        {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
-        }
-        else
-        {
-            std::cout << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
-            stbi_image_free(data);
-        }
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-    return textureID;
-}
 
 #endif //MODEL_H
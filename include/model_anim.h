@@ -8,22 +8,25 @@
 #include <assimp/postprocess.h>
 
 #include "mesh_anim.h"
+#include "cpu_tracer.h"
+#include "job_system.h"
 #include "stb_image.h"
+#include "texture_loader.h"
 #include "animation_info.h"
 #include "assimp_to_glm.h"
 
-unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma = false);
 
 class ModelAnim
 {
 public:
     ModelAnim() = default;
-    explicit ModelAnim(const char* path)
+    //With jobs, meshes are converted and textures decoded in parallel, the GL upload stays on the calling thread
+    explicit ModelAnim(const char* path, gpr5300::JobSystem* jobs = nullptr)
     {
-        LoadModel(path);
+        LoadModel(path, jobs);
     }
 
-    void Draw(GLuint& shader)
+    void Draw(const GLuint shader)
     {
         for (auto& meshe : meshes_)
             meshe.Draw(shader);
@@ -45,8 +48,25 @@ private:
     int m_BoneCounter = 0;
 
 
-    void LoadModel(const std::string& path)
+    //CPU side content of one mesh, filled by a job
+    struct MeshData
     {
+        std::vector<VertexAnim> vertices;
+        std::vector<unsigned int> indices;
+        std::vector<std::size_t> textures; //Indices in textures_loaded
+        std::vector<int> bone_ids; //Id of each aiMesh::mBones entry
+    };
+
+    struct TextureData
+    {
+        std::string type;
+        std::string path;
+        Image image;
+    };
+
+    void LoadModel(const std::string& path, gpr5300::JobSystem* jobs)
+    {
+        gpr5300::ScopedZone zone("ModelAnim::LoadModel");
         Assimp::Importer import;
 
         const aiScene* scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
@@ -58,34 +78,87 @@ private:
         }
         directory_ = path.substr(0, path.find_last_of('/'));
 
-        ProcessNode(scene->mRootNode, scene);
+        //Mesh order, texture slots and bone ids only depend on the file, settled serially before any conversion
+        std::vector<const aiMesh*> meshes;
+        CollectMeshes(scene->mRootNode, scene, meshes);
+        std::vector<MeshData> mesh_data(meshes.size());
+        std::vector<TextureData> textures;
+        for (std::size_t i = 0; i < meshes.size(); i++)
+        {
+            const aiMaterial* material = scene->mMaterials[meshes[i]->mMaterialIndex];
+            LoadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", textures, mesh_data[i].textures);
+            LoadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular", textures,
+                                 mesh_data[i].textures);
+            RegisterBones(meshes[i], mesh_data[i].bone_ids);
+        }
+
+        //One job per mesh then per texture, each writes its own slot
+        const std::size_t mesh_count = meshes.size();
+        gpr5300::ParallelFor(jobs, mesh_count + textures.size(), 1,
+                             [this, &meshes, &mesh_data, &textures, mesh_count](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                if (i < mesh_count)
+                {
+                    ProcessMesh(meshes[i], mesh_data[i]);
+                }
+                else
+                {
+                    TextureData& texture = textures[i - mesh_count];
+                    texture.image = DecodeImage((directory_ + '/' + texture.path).c_str());
+                }
+            }
+        });
+
+        //GL upload, in file order
+        textures_loaded.reserve(textures.size());
+        for (auto& texture : textures)
+        {
+            if (texture.image.pixel == nullptr)
+            {
+                std::cout << "Texture failed to load at path: " << texture.path << std::endl;
+            }
+            textures_loaded.push_back({TextureFromImage(texture.image), texture.type, texture.path});
+            FreeImage(texture.image);
+        }
+        meshes_.reserve(mesh_data.size());
+        for (auto& mesh : mesh_data)
+        {
+            std::vector<Texture> mesh_textures;
+            for (const std::size_t texture : mesh.textures)
+                mesh_textures.push_back(textures_loaded[texture]);
+            meshes_.emplace_back(std::move(mesh.vertices), std::move(mesh.indices), std::move(mesh_textures));
+        }
     }
 
-    void ProcessNode(aiNode* node, const aiScene* scene)
+    //Meshes of node and its children, depth first like the draw order
+    static void CollectMeshes(const aiNode* node, const aiScene* scene, std::vector<const aiMesh*>& meshes)
     {
         // process all the node's meshes (if any)
         for (unsigned int i = 0; i < node->mNumMeshes; i++)
         {
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes_.push_back(ProcessMesh(mesh, scene));
+            meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
         }
         // then do the same for each of its children
         for (unsigned int i = 0; i < node->mNumChildren; i++)
         {
-            ProcessNode(node->mChildren[i], scene);
+            CollectMeshes(node->mChildren[i], scene, meshes);
         }
     }
 
-    MeshAnim ProcessMesh(aiMesh* mesh, const aiScene* scene)
+    //Fills the vertices and indices of mesh_data, touches nothing else so meshes can run concurrently
+    static void ProcessMesh(const aiMesh* mesh, MeshData& mesh_data)
     {
-        std::vector<Vertex> vertices;
-        std::vector<unsigned int> indices;
-        std::vector<Texture> textures;
+        gpr5300::ScopedZone zone("ModelAnim::ProcessMesh");
+        std::vector<VertexAnim>& vertices = mesh_data.vertices;
+        std::vector<unsigned int>& indices = mesh_data.indices;
 
         //Process vertex
+        vertices.resize(mesh->mNumVertices);
         for (unsigned int i = 0; i < mesh->mNumVertices; i++)
         {
-            Vertex vertex{};
+            VertexAnim& vertex = vertices[i];
             SetVertexBoneDataToDefault(vertex);
 
             vertex.Position = AssimpToGLM::GetGLMVec(mesh->mVertices[i]);
@@ -94,74 +167,78 @@ private:
             //TexCoords
             if (mesh->mTextureCoords[0]) // does the mesh contain texture coordinates?
             {
-                glm::vec2 vec;
-                vec.x = mesh->mTextureCoords[0][i].x;
-                vec.y = mesh->mTextureCoords[0][i].y;
-                vertex.TexCoords = vec;
+                vertex.TexCoords = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
             }
             else
             {
                 vertex.TexCoords = glm::vec2(0.0f, 0.0f);
             }
-            vertices.push_back(vertex);
-        }
-
-        //Process indices
-        for(unsigned int i = 0; i < mesh->mNumFaces; i++)
-        {
-            aiFace face = mesh->mFaces[i];
-            for(unsigned int j = 0; j < face.mNumIndices; j++)
-                indices.push_back(face.mIndices[j]);
         }
 
-        //Process material
-        if(mesh->mMaterialIndex >= 0)
+        //Process indices, counted first to allocate once
+        std::size_t index_count = 0;
+        for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+            index_count += mesh->mFaces[i].mNumIndices;
+        indices.resize(index_count);
+        std::size_t index = 0;
+        for (unsigned int i = 0; i < mesh->mNumFaces; i++)
         {
-            aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
-            std::vector<Texture> diffuseMaps = LoadMaterialTextures(material,
-                                                aiTextureType_DIFFUSE, "texture_diffuse");
-            textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-            std::vector<Texture> specularMaps = LoadMaterialTextures(material,
-                                                aiTextureType_SPECULAR, "texture_specular");
-            textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+            const aiFace& face = mesh->mFaces[i];
+            for (unsigned int j = 0; j < face.mNumIndices; j++)
+                indices[index++] = face.mIndices[j];
         }
 
-        ExtractBoneWeightForVertices(vertices,mesh,scene);
-
-        return {vertices, indices, textures};
+        ExtractBoneWeightForVertices(vertices, mesh, mesh_data.bone_ids);
     }
 
-    std::vector<Texture> LoadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName)
+    //Adds the texture indices of mat to mesh_textures, a path seen for the first time gets a slot in textures,
+    //decoded later
+    static void LoadMaterialTextures(const aiMaterial* mat, aiTextureType type, const std::string& typeName,
+                                     std::vector<TextureData>& textures, std::vector<std::size_t>& mesh_textures)
     {
-        std::vector<Texture> textures;
         for(unsigned int i = 0; i < mat->GetTextureCount(type); i++)
         {
             aiString str;
             mat->GetTexture(type, i, &str);
             bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
+            for(std::size_t j = 0; j < textures.size(); j++)
             {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
+                if(std::strcmp(textures[j].path.data(), str.C_Str()) == 0)
                 {
-                    textures.push_back(textures_loaded[j]);
+                    mesh_textures.push_back(j);
                     skip = true;
                     break;
                 }
             }
             if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory_);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture); // add to loaded textures
+            {   // if texture hasn't been seen already, reserve its slot
+                mesh_textures.push_back(textures.size());
+                textures.push_back({typeName, str.C_Str(), {}});
+            }
+        }
+    }
+
+    //Ids of the bones of mesh, a bone seen for the first time gets the next one
+    void RegisterBones(const aiMesh* mesh, std::vector<int>& bone_ids)
+    {
+        bone_ids.resize(mesh->mNumBones);
+        for (unsigned int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex)
+        {
+            std::string boneName = mesh->mBones[boneIndex]->mName.C_Str();
+            if (m_BoneInfoMap.find(boneName) == m_BoneInfoMap.end())
+            {
+                BoneInfo newBoneInfo;
+                newBoneInfo.id = m_BoneCounter;
+                newBoneInfo.offset = AssimpToGLM::ConvertMatrixToGLMFormat(
+                    mesh->mBones[boneIndex]->mOffsetMatrix);
+                m_BoneInfoMap[boneName] = newBoneInfo;
+                m_BoneCounter++;
             }
+            bone_ids[boneIndex] = m_BoneInfoMap[boneName].id;
         }
-        return textures;
     }
 
-    void SetVertexBoneDataToDefault(Vertex& vertex)
+    static void SetVertexBoneDataToDefault(VertexAnim& vertex)
     {
         for (int i = 0; i < MAX_BONE_INF; i++)
         {
@@ -170,7 +247,7 @@ private:
         }
     }
 
-    void SetVertexBoneData(Vertex& vertex, int boneID, float weight)
+    static void SetVertexBoneData(VertexAnim& vertex, int boneID, float weight)
     {
         for (int i = 0; i < MAX_BONE_INF; i++)
         {
@@ -183,26 +260,12 @@ private:
         }
     }
 
-    void ExtractBoneWeightForVertices(std::vector<Vertex>& vertices, aiMesh* mesh, const aiScene* scene)
+    static void ExtractBoneWeightForVertices(std::vector<VertexAnim>& vertices, const aiMesh* mesh,
+                                             const std::vector<int>& bone_ids)
     {
-        for (int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex)
+        for (unsigned int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex)
         {
-            int boneID = -1;
-            std::string boneName = mesh->mBones[boneIndex]->mName.C_Str();
-            if (m_BoneInfoMap.find(boneName) == m_BoneInfoMap.end())
-            {
-                BoneInfo newBoneInfo;
-                newBoneInfo.id = m_BoneCounter;
-                newBoneInfo.offset = AssimpToGLM::ConvertMatrixToGLMFormat(
-                    mesh->mBones[boneIndex]->mOffsetMatrix);
-                m_BoneInfoMap[boneName] = newBoneInfo;
-                boneID = m_BoneCounter;
-                m_BoneCounter++;
-            }
-            else
-            {
-                boneID = m_BoneInfoMap[boneName].id;
-            }
+            const int boneID = bone_ids[boneIndex];
             assert(boneID != -1);
             auto weights = mesh->mBones[boneIndex]->mWeights;
             int numWeights = mesh->mBones[boneIndex]->mNumWeights;
@@ -218,84 +281,4 @@ private:
     }
 };
 
-
-unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma)
-{
-    std::string filename = std::string(path);
-    filename = directory + '/' + filename;
-
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum internal_format;
-        GLenum data_format;
-        if (nrComponents == 1)
-        {
-            internal_format = data_format = GL_RED;
-        }
-        else if (nrComponents == 3)
-        {
-            internal_format = gamma ? GL_SRGB : GL_RGB;
-            data_format = GL_RGB;
-        }
-        else if (nrComponents == 4)
-        {
-            internal_format = gamma ? GL_SRGB_ALPHA : GL_RGBA;
-            data_format = GL_RGBA;
-        }
-
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, data_format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, data_format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, data_format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
-unsigned int CubemapFromVec(std::vector<std::string> faces)
-{
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-
-    int width, height, nrChannels;
-    for (unsigned int i = 0; i < faces.size(); i++)
-    {
-        unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-        if (data)
-        {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
-        }
-        else
-        {
-            std::cout << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
-            stbi_image_free(data);
-        }
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-    return textureID;
-}
-
 #endif //MODEL_ANIM_H
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
+
+#include <GL/glew.h>
+
+namespace gpr5300
+{
+    //On-disk cache of linked program binaries (glGetProgramBinary), so a launch only compiles the GLSL that changed.
+    //Entries are keyed by a hash of the sources and of the driver vendor, renderer and version strings: a driver
+    //update misses instead of feeding a stale blob. A blob the driver still rejects falls back to compilation.
+    //GL thread only.
+    namespace ProgramCache
+    {
+        //Directory of the cache files, created on the first save. Empty disables the cache.
+        void SetDirectory(std::string_view directory);
+
+        //Hash of the sources of every stage in order, plus the driver strings
+        [[nodiscard]] std::uint64_t Key(std::initializer_list<std::string_view> sources);
+
+        //Loads the binary stored for key into program, true when program is linked and ready to use
+        bool Load(std::uint64_t key, GLuint program);
+        //Stores the binary of a linked program, it must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+        void Save(std::uint64_t key, GLuint program);
+
+        [[nodiscard]] std::size_t Hits();
+        [[nodiscard]] std::size_t Misses();
+    }
+} // namespace gpr5300
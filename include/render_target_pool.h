@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace gpr5300
+{
+    //What a scene asks the pool for. The size follows the viewport through scale unless width and height are set.
+    struct RenderTargetDesc
+    {
+        GLenum internal_format = GL_RGBA8;
+        //Relative to the viewport, 0.5f for a half resolution target
+        float scale = 1.0f;
+        //Fixed size in pixels, ignores scale and the viewport when both are set
+        int width = 0;
+        int height = 0;
+        //Multisampled storage when above 0
+        int samples = 0;
+        //Renderbuffer instead of a texture, for attachments never sampled (depth, stencil)
+        bool renderbuffer = false;
+    };
+
+    struct RenderTarget
+    {
+        GLuint id = 0;
+        int width = 0;
+        int height = 0;
+        int samples = 0;
+        bool renderbuffer = false;
+    };
+
+    //Transient framebuffer attachments keyed by (format, size, samples). A released target stays in the pool and is
+    //handed back to the next request with the same key instead of allocating, across scenes too. Resize only records
+    //the new viewport and bumps the generation: scenes rebuild their attachments lazily when they see it change.
+    class RenderTargetPool
+    {
+    public:
+        //Engine thread, between frames. Zero sizes (minimized window) are ignored.
+        void Resize(int width, int height);
+        [[nodiscard]] int Width() const { return width_.load(std::memory_order_relaxed); }
+        [[nodiscard]] int Height() const { return height_.load(std::memory_order_relaxed); }
+        [[nodiscard]] float AspectRatio() const { return static_cast<float>(Width()) / static_cast<float>(Height()); }
+        //Compare with the generation the attachments were acquired at to know when to acquire them again
+        [[nodiscard]] std::uint32_t Generation() const { return generation_.load(std::memory_order_acquire); }
+
+        //GL thread. Texture storage is immutable, filtered linearly and clamped to edge.
+        RenderTarget Acquire(const RenderTargetDesc& desc);
+        //GL thread, resets target. Releasing a null target does nothing.
+        void Release(RenderTarget& target);
+        //Attaches target to framebuffer, which does not need to be bound
+        static void Attach(GLuint framebuffer, GLenum attachment, const RenderTarget& target);
+
+        //GL thread, once per frame: deletes the free targets of a previous viewport size right away and the others
+        //when no one acquired them for a few frames
+        void Collect();
+        //GL thread, every target must have been released
+        void Clear();
+
+        [[nodiscard]] std::size_t Size() const { return targets_.size(); }
+        [[nodiscard]] std::size_t Allocations() const { return allocations_; }
+
+    private:
+        struct Entry
+        {
+            RenderTargetDesc desc;
+            RenderTarget target;
+            bool in_use = false;
+            std::uint64_t last_used_frame = 0;
+        };
+
+        [[nodiscard]] bool IsStale(const Entry& entry) const;
+        static void Delete(const RenderTarget& target);
+
+        std::atomic<int> width_ = 1;
+        std::atomic<int> height_ = 1;
+        std::atomic<std::uint32_t> generation_ = 0;
+
+        std::vector<Entry> targets_;
+        std::uint64_t frame_ = 0;
+        std::size_t allocations_ = 0;
+    };
+} // namespace gpr5300
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gpr5300
+{
+    //Closure recorded by the simulation thread and replayed on the render thread. It must capture what it draws
+    //by value (matrices, bone transforms...), the simulation is already building the next frame when it runs.
+    using RenderCommand = std::function<void()>;
+
+    //Owns the GL context on its own thread and replays double buffered command lists: while the render thread
+    //submits frame N the simulation thread records frame N + 1 in the other list. Without a thread the commands
+    //simply run as they are enqueued, on the thread owning the context.
+    class RenderThread
+    {
+    public:
+        //make_current(true/false) binds or releases the GL context on the calling thread
+        void Create(bool threaded, std::function<void(bool)> make_current);
+        //Replays what is left, joins the thread and gives the GL context back to the calling thread
+        void Destroy();
+
+        [[nodiscard]] bool IsThreaded() const { return threaded_; }
+
+        void Enqueue(RenderCommand command);
+        //Blocks while the render thread still replays the last submitted list
+        void WaitForReplay();
+        //Hands the recorded list over, blocks while the render thread still replays the previous one
+        void Submit();
+        //Submits and waits until everything recorded so far ran
+        void Flush();
+        //Runs command on the render thread and waits for it, for loading and unloading
+        void Execute(RenderCommand command);
+
+    private:
+        void ThreadLoop();
+
+        std::array<std::vector<RenderCommand>, 2> lists_;
+        std::size_t record_index_ = 0;
+        std::size_t replay_index_ = 0;
+        bool threaded_ = false;
+        std::function<void(bool)> make_current_;
+
+        std::thread thread_;
+        std::mutex mutex_;
+        std::condition_variable submitted_;
+        std::condition_variable replayed_;
+        bool replaying_ = false;
+        bool running_ = false;
+    };
+} // namespace gpr5300
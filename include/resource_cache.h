@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "shader_source.h"
+
+class Shader;
+class ShaderStage;
+using ShaderDefines = std::vector<std::pair<std::string, std::string>>;
+
+namespace gpr5300
+{
+    class JobSystem;
+
+    //GL texture shared through the ResourceCache, deleted with its last reference
+    struct SharedTexture
+    {
+        explicit SharedTexture(const GLuint texture) : id(texture) {}
+        ~SharedTexture();
+        SharedTexture(const SharedTexture&) = delete;
+        SharedTexture& operator=(const SharedTexture&) = delete;
+
+        GLuint id = 0;
+    };
+
+    //Programs, textures and models loaded once and shared between scenes. Scenes hold a shared_ptr to what they use
+    //and reset it in End, the cache keeps its own reference so a resource survives until Trim finds no scene
+    //holding it anymore. Loading and the last release touch GL objects: GL thread only.
+    class ResourceCache
+    {
+    public:
+        //Compiled asynchronously: load every program of a scene before using the first one so their compiles overlap
+        //Variants of the same files are cached apart, keyed by their sorted defines: the order they are listed in
+        //does not make a new variant.
+        std::shared_ptr<const Shader> LoadShader(const char* vertex_path, const char* fragment_path,
+                                                 ShaderDefines defines = {});
+        //Sources embedded in a header generated by shader_compiler, cached as the same files loaded by path
+        std::shared_ptr<const Shader> LoadShader(const ProgramSource& source, ShaderDefines defines = {});
+        //Separable stage, compiled once per file and variant however many pipelines use it
+        std::shared_ptr<const ShaderStage> LoadStage(GLenum type, const char* path, ShaderDefines defines = {});
+        //Program pipeline of the two stages from LoadStage, for the vertex stages shared by several programs: the
+        //stage is compiled once instead of once per program
+        std::shared_ptr<const Shader> LoadPipeline(const char* vertex_path, const char* fragment_path,
+                                                   ShaderDefines defines = {});
+        std::shared_ptr<const SharedTexture> LoadTexture(const char* path, const std::string& directory,
+                                                         bool gamma = false);
+        std::shared_ptr<const SharedTexture> LoadCubemap(const std::vector<std::string>& faces,
+                                                         JobSystem* jobs = nullptr);
+
+        //Model and ModelAnim cannot share a translation unit, both go through these templates instead of
+        //being named here. Find returns null when key was never added for T.
+        template <typename T>
+        std::shared_ptr<T> Find(const std::string& key)
+        {
+            const auto it = resources_.find({std::type_index(typeid(T)), key});
+            if (it == resources_.end())
+            {
+                return nullptr;
+            }
+            hits_++;
+            return std::static_pointer_cast<T>(it->second);
+        }
+
+        template <typename T>
+        std::shared_ptr<T> Add(const std::string& key, std::shared_ptr<T> resource)
+        {
+            misses_++;
+            resources_[{std::type_index(typeid(T)), key}] = resource;
+            return resource;
+        }
+
+        //T constructible from the file path and a job system converting its meshes, like Model or ModelAnim
+        template <typename T>
+        std::shared_ptr<T> LoadModel(const std::string& path, JobSystem* jobs = nullptr)
+        {
+            if (auto model = Find<T>(path))
+            {
+                return model;
+            }
+            return Add(path, std::make_shared<T>(path.c_str(), jobs));
+        }
+
+        //Hot reload, GL thread once per frame: rebuilds in the background the programs and stages using one of the
+        //changed files and swaps each one into its live Shader or ShaderStage the frame its link completes, the
+        //pipelines of a stage attach the new one. A program that fails keeps running. Any program is rebuilt when
+        //a .glsl include changed.
+        void ReloadShaders(const std::vector<std::string>& changed_files);
+        //Where the shaders loaded from data/shaders are saved, the source tree the watcher reports: a rebuild reads
+        //the file there and resolves its includes from there. Unset, from data/shaders itself.
+        void SetShaderSourceDirectory(std::string directory);
+
+        //Releases what only the cache still holds, after a scene switch
+        void Trim();
+        //Releases the cache references, what scenes still hold lives on until they drop it
+        void Clear();
+
+        [[nodiscard]] std::size_t Size() const { return resources_.size(); }
+        [[nodiscard]] std::size_t Hits() const { return hits_; }
+        [[nodiscard]] std::size_t Misses() const { return misses_; }
+
+    private:
+        using Key = std::pair<std::type_index, std::string>;
+        std::map<Key, std::shared_ptr<void>> resources_;
+
+        struct ShaderReload
+        {
+            std::shared_ptr<Shader> live;
+            std::shared_ptr<Shader> next;
+        };
+        std::vector<ShaderReload> shader_reloads_;
+        struct StageReload
+        {
+            std::shared_ptr<ShaderStage> live;
+            std::shared_ptr<ShaderStage> next;
+        };
+        std::vector<StageReload> stage_reloads_;
+        std::string shader_source_directory_;
+        std::size_t hits_ = 0;
+        std::size_t misses_ = 0;
+    };
+} // namespace gpr5300
@@ -4,7 +4,14 @@
 
 namespace gpr5300
 {
-    
+    class FrameUniforms;
+    class Input;
+    class JobSystem;
+    class LateLatch;
+    class RenderTargetPool;
+    class RenderThread;
+    class ResourceCache;
+
     class Scene
     {
     public:
@@ -12,10 +19,45 @@ namespace gpr5300
         virtual void Begin() = 0;
         virtual void End() = 0;
         virtual void Update(float dt) = 0;
+        //Fixed timestep mode (EngineSettings::fixed_update_rate): scenes that support it get FixedUpdate
+        //zero or more times per frame at a constant step, then Render with alpha in [0, 1] telling how far
+        //the frame is between the previous and the current simulation step. Other scenes keep Update(dt).
+        virtual bool SupportsFixedUpdate() const { return false; }
+        virtual void FixedUpdate(const float fixed_dt) {}
+        virtual void Render(const float alpha) {}
+        //Render thread mode (EngineSettings::render_thread): Update, FixedUpdate, Render, OnEvent and DrawImGui
+        //run on the simulation thread and every GL call goes through render_thread_->Enqueue. Begin and End run
+        //on the render thread while the simulation waits. Other scenes run on a single thread, where Enqueue
+        //executes the command immediately.
+        virtual bool SupportsRenderThread() const { return false; }
+        //Late latched camera: the scene reads the mouse through input_ as usual and calls late_latch_->Latch
+        //right before its main pass, with the camera of the frame
+        virtual bool SupportsLateLatch() const { return false; }
         virtual void DrawImGui() {}
         virtual void OnEvent(const SDL_Event& event) {}
+        //Read the keyboard and mouse through input_, never straight from SDL, so recordings replay identically
         virtual void UpdateCamera(const float dt) {}
 
+        //Set by the Engine before Begin, the job system lives until after End
+        void SetJobSystem(JobSystem* job_system) { job_system_ = job_system; }
+        void SetRenderThread(RenderThread* render_thread) { render_thread_ = render_thread; }
+        void SetLateLatch(LateLatch* late_latch) { late_latch_ = late_latch; }
+        void SetInput(Input* input) { input_ = input; }
+        //Shared with the other scenes of the scene host, reset the handles taken from it in End
+        void SetResourceCache(ResourceCache* resources) { resources_ = resources; }
+        //Viewport size and transient framebuffer attachments, acquire them again when its generation changes
+        void SetRenderTargetPool(RenderTargetPool* render_targets) { render_targets_ = render_targets; }
+        //ViewData and LightData blocks shared by every program, set them every frame once per view on the GL thread
+        void SetFrameUniforms(FrameUniforms* frame_uniforms) { frame_uniforms_ = frame_uniforms; }
+
+    protected:
+        JobSystem* job_system_ = nullptr;
+        RenderThread* render_thread_ = nullptr;
+        LateLatch* late_latch_ = nullptr;
+        Input* input_ = nullptr;
+        ResourceCache* resources_ = nullptr;
+        RenderTargetPool* render_targets_ = nullptr;
+        FrameUniforms* frame_uniforms_ = nullptr;
     };
 
 } // namespace gpr5300
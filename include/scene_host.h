@@ -0,0 +1,43 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "scene.h"
+#include "scene_registry.h"
+
+namespace gpr5300
+{
+    //Scene running one registered scene at a time, picked from an ImGui menu. Switching ends the current scene
+    //and begins the next one while the ResourceCache keeps what both use, so only new assets get loaded.
+    //Hosted scenes always run single threaded, the render thread mode is chosen once when the engine begins.
+    class SceneHost final : public Scene
+    {
+    public:
+        explicit SceneHost(std::string initial_scene = {});
+
+        void Begin() override;
+        void End() override;
+        void Update(float dt) override;
+        bool SupportsFixedUpdate() const override;
+        void FixedUpdate(float fixed_dt) override;
+        void Render(float alpha) override;
+        bool SupportsLateLatch() const override;
+        void DrawImGui() override;
+        void OnEvent(const SDL_Event& event) override;
+        void UpdateCamera(float dt) override;
+
+    private:
+        void Switch(std::size_t index);
+        void ResetState() const;
+
+        std::string initial_scene_;
+        std::vector<SceneEntry> scenes_;
+        std::unique_ptr<Scene> current_;
+        std::size_t current_index_ = 0;
+        double switch_time_ = 0.0;
+    };
+} // namespace gpr5300
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "scene.h"
+
+namespace gpr5300
+{
+    struct SceneEntry
+    {
+        std::string name;
+        std::function<std::unique_ptr<Scene>()> create;
+    };
+
+    //Every scene linked in the executable. The main/ files register their scene with a static SceneRegistration
+    //instead of defining main when built into the scene host (GPR5300_SCENE_HOST).
+    std::vector<SceneEntry>& SceneRegistry();
+
+    struct SceneRegistration
+    {
+        SceneRegistration(std::string name, std::function<std::unique_ptr<Scene>()> create);
+    };
+} // namespace gpr5300
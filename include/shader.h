@@ -1,119 +1,818 @@
 ﻿#ifndef SHADER_H_
 #define SHADER_H_
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include <GL/glew.h>
 #include <glm/gtc/type_ptr.hpp>
 
-#include "file_utility.h"
+#include "cpu_tracer.h"
+#include "frame_uniforms.h"
+#include "gl_state.h"
+#include "program_cache.h"
+#include "shader_source.h"
+
+enum class ShaderCompile
+{
+    Blocking,
+    Async
+};
+
+//Name and value of the #define lines injected after #version, one set of them is a variant of the same sources
+using ShaderDefines = std::vector<std::pair<std::string, std::string>>;
+
+//#version has to stay the first line, the defines go right after it. #line keeps the line numbers of the
+//compile errors those of the file.
+inline std::string InjectDefines(std::string source, const ShaderDefines& defines)
+{
+    if (defines.empty())
+    {
+        return source;
+    }
+    std::string block;
+    for (const auto& [name, value] : defines)
+    {
+        block += "#define " + name + ' ' + value + '\n';
+    }
+    std::size_t position = 0;
+    int next_line = 1;
+    if (const auto version = source.find("#version"); version != std::string::npos)
+    {
+        position = source.find('\n', version);
+        if (position == std::string::npos)
+        {
+            source += '\n';
+            position = source.size() - 1;
+        }
+        position++;
+        next_line = 2;
+    }
+    block += "#line " + std::to_string(next_line) + '\n';
+    source.insert(position, block);
+    return source;
+}
+
+//Compile and link errors, so a broken hot reload tells what to fix
+template <typename GetIv, typename GetLog>
+void PrintInfoLog(const GLuint object, GetIv get_iv, GetLog get_log)
+{
+    GLint length = 0;
+    get_iv(object, GL_INFO_LOG_LENGTH, &length);
+    if (length > 1)
+    {
+        std::string log(length, '\0');
+        get_log(object, length, nullptr, log.data());
+        std::cerr << log << '\n';
+    }
+}
+
+//One value of a default block uniform read from a program and written to another. Only the types of the
+//UniformHandle setters and the samplers: the others are left to the scene.
+inline void CopyUniformValue(const GLuint from, const GLint from_location, const GLuint to, const GLint to_location,
+                             const GLenum type)
+{
+    GLfloat floats[16] = {};
+    GLint ints[1] = {};
+    switch (type)
+    {
+    case GL_FLOAT:
+        glGetUniformfv(from, from_location, floats);
+        glProgramUniform1fv(to, to_location, 1, floats);
+        break;
+    case GL_FLOAT_VEC2:
+        glGetUniformfv(from, from_location, floats);
+        glProgramUniform2fv(to, to_location, 1, floats);
+        break;
+    case GL_FLOAT_VEC3:
+        glGetUniformfv(from, from_location, floats);
+        glProgramUniform3fv(to, to_location, 1, floats);
+        break;
+    case GL_FLOAT_VEC4:
+        glGetUniformfv(from, from_location, floats);
+        glProgramUniform4fv(to, to_location, 1, floats);
+        break;
+    case GL_FLOAT_MAT2:
+        glGetUniformfv(from, from_location, floats);
+        glProgramUniformMatrix2fv(to, to_location, 1, GL_FALSE, floats);
+        break;
+    case GL_FLOAT_MAT3:
+        glGetUniformfv(from, from_location, floats);
+        glProgramUniformMatrix3fv(to, to_location, 1, GL_FALSE, floats);
+        break;
+    case GL_FLOAT_MAT4:
+        glGetUniformfv(from, from_location, floats);
+        glProgramUniformMatrix4fv(to, to_location, 1, GL_FALSE, floats);
+        break;
+    case GL_INT:
+    case GL_BOOL:
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_3D:
+    case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_2D_SHADOW:
+    case GL_SAMPLER_2D_ARRAY:
+    case GL_SAMPLER_2D_MULTISAMPLE:
+        glGetUniformiv(from, from_location, ints);
+        glProgramUniform1iv(to, to_location, 1, ints);
+        break;
+    default:
+        break;
+    }
+}
+
+//Hot reload: the values a scene set once, like the texture units of its samplers, would be lost with the old
+//program. Copies every default block uniform from declares with the same type as to, array elements included.
+inline void CopyUniformValues(const GLuint from, const GLuint to)
+{
+    const auto active_uniforms = [](const GLuint program)
+    {
+        GLint uniform_count = 0;
+        GLint max_length = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniform_count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+        std::string name(std::max(max_length, 1), '\0');
+        //Name as reported, "array[0]" for an array, to type and array size
+        std::unordered_map<std::string, std::pair<GLenum, GLint>> uniforms;
+        for (GLint i = 0; i < uniform_count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(program, i, max_length, &length, &size, &type, name.data());
+            uniforms.emplace(std::string(name.data(), length), std::make_pair(type, size));
+        }
+        return uniforms;
+    };
+    const auto targets = active_uniforms(to);
+    for (const auto& [name, uniform] : active_uniforms(from))
+    {
+        const auto target = targets.find(name);
+        if (target == targets.end() || target->second.first != uniform.first)
+        {
+            continue;
+        }
+        const GLint size = std::min(uniform.second, target->second.second);
+        const bool array = name.ends_with("[0]");
+        for (GLint element = 0; element < (array ? size : 1); element++)
+        {
+            const std::string element_name =
+                element == 0 ? name : name.substr(0, name.size() - 3) + "[" + std::to_string(element) + "]";
+            //Members of uniform blocks have no location, their values live in the buffer
+            const GLint from_location = glGetUniformLocation(from, element_name.c_str());
+            const GLint to_location = glGetUniformLocation(to, element_name.c_str());
+            if (from_location >= 0 && to_location >= 0)
+            {
+                CopyUniformValue(from, from_location, to, to_location, uniform.first);
+            }
+        }
+    }
+}
+
+//Location of a uniform in one program
+struct UniformSlot
+{
+    GLuint program = 0;
+    GLint location = -1;
+};
+
+//Uniform location resolved once from the reflected table of a Shader, T is the C++ side of the GLSL type.
+//count is the array size, 1 for a single value. A default handle (uniform inactive or misspelled) sets nothing.
+//A pipeline has a copy of the uniform in each stage declaring it, the second slot is the other stage.
+template <typename T>
+struct UniformHandle
+{
+    UniformSlot slots[2];
+    GLint count = 0;
+    [[nodiscard]] bool IsValid() const { return slots[0].location >= 0; }
+};
+
+//One stage linked alone as a separable program (GL_PROGRAM_SEPARABLE), so the same vertex stage compiles once and
+//is combined with any fragment stage in a Shader pipeline. Compiles like Shader: cached binary, or blocking or
+//async compile.
+class ShaderStage
+{
+public:
+    ShaderStage(const GLenum type, const char* path, const ShaderCompile mode = ShaderCompile::Blocking,
+                ShaderDefines defines = {})
+    {
+        gpr5300::ScopedZone zone("ShaderStage::ShaderStage");
+        type_ = type;
+        path_ = path;
+        defines_ = std::move(defines);
+        const auto content = InjectDefines(gpr5300::LoadShaderSource(path), defines_);
+        program_ = glCreateProgram();
+        //Must be set before the binary is loaded as well as before linking
+        glProgramParameteri(program_, GL_PROGRAM_SEPARABLE, GL_TRUE);
+        cache_key_ = gpr5300::ProgramCache::Key({"separable", std::to_string(type), content});
+        if (gpr5300::ProgramCache::Load(cache_key_, program_))
+        {
+            Finish();
+            return;
+        }
+        const char* code = content.data();
+        shader_ = glCreateShader(type);
+        glShaderSource(shader_, 1, &code, nullptr);
+        glCompileShader(shader_);
+        glAttachShader(program_, shader_);
+        glProgramParameteri(program_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(program_);
+        pending_ = true;
+        if (mode == ShaderCompile::Blocking)
+        {
+            Finish();
+        }
+    }
+
+    [[nodiscard]] bool IsReady() const
+    {
+        if (!pending_)
+        {
+            return true;
+        }
+        if (GLEW_KHR_parallel_shader_compile)
+        {
+            GLint completed = GL_FALSE;
+            glGetProgramiv(program_, GL_COMPLETION_STATUS_KHR, &completed);
+            if (!completed)
+            {
+                return false;
+            }
+        }
+        Finish();
+        return true;
+    }
+
+    [[nodiscard]] bool IsLinked() const
+    {
+        if (pending_)
+        {
+            gpr5300::ScopedZone zone("ShaderStage::Wait");
+            Finish();
+        }
+        return linked_;
+    }
+
+    //Hot reload, as Shader::Replace. The pipelines using the stage must attach the new program: the uniform values
+    //are on the stage program, copied here like Shader::Replace does.
+    void Replace(ShaderStage&& next)
+    {
+        const GLuint previous = program_;
+        const unsigned int revision = revision_;
+        std::string path = std::move(path_);
+        *this = std::move(next);
+        path_ = std::move(path);
+        revision_ = revision + 1;
+        CopyUniformValues(previous, program_);
+        gpr5300::GlState::DeleteProgram(previous);
+    }
+
+    void Delete() const
+    {
+        if (pending_)
+        {
+            glDeleteShader(shader_);
+        }
+        gpr5300::GlState::DeleteProgram(program_);
+    }
+
+    [[nodiscard]] GLuint Program() const { return program_; }
+    [[nodiscard]] GLenum Type() const { return type_; }
+    [[nodiscard]] unsigned int Revision() const { return revision_; }
+    [[nodiscard]] const std::string& Path() const { return path_; }
+    [[nodiscard]] const ShaderDefines& Defines() const { return defines_; }
+
+private:
+    void Finish() const
+    {
+        if (pending_)
+        {
+            GLint success;
+            glGetProgramiv(program_, GL_LINK_STATUS, &success);
+            linked_ = success;
+            if (!success)
+            {
+                std::cerr << "Error while loading shader stage " << path_ << '\n';
+                PrintInfoLog(shader_, glGetShaderiv, glGetShaderInfoLog);
+                PrintInfoLog(program_, glGetProgramiv, glGetProgramInfoLog);
+            }
+            else
+            {
+                gpr5300::ProgramCache::Save(cache_key_, program_);
+            }
+            glDetachShader(program_, shader_);
+            glDeleteShader(shader_);
+            pending_ = false;
+        }
+        gpr5300::FrameUniforms::BindBlocks(program_);
+    }
+
+    GLuint program_ = 0;
+    GLenum type_ = GL_VERTEX_SHADER;
+    std::uint64_t cache_key_ = 0;
+    GLuint shader_ = 0;
+    mutable bool pending_ = false;
+    mutable bool linked_ = true;
+    unsigned int revision_ = 0;
+    std::string path_;
+    ShaderDefines defines_;
+};
 
 class Shader
 {
 public:
+    //Program of the fragment stage for a pipeline, the one glUniform calls go to once it is in use
     unsigned int id_;
     Shader() = default;
-    //Constructor from paths
-    Shader(const char* vertex_path, const char* fragment_path)
+    //Constructor from paths, the linked program comes from the program binary cache when the sources did not change.
+    //Async only submits the compile and link: the driver works on it in the background (in parallel with
+    //GL_KHR_parallel_shader_compile) while the next programs get submitted, and the program is waited for the first
+    //time it is used. Poll IsReady to skip the draws of a program still compiling instead of waiting.
+    //defines are injected in both stages, the sources keep their own fallback with #ifndef.
+    Shader(const char* vertex_path, const char* fragment_path, const ShaderCompile mode = ShaderCompile::Blocking,
+           ShaderDefines defines = {})
+    {
+        gpr5300::ScopedZone zone("Shader::Shader");
+        vertex_path_ = vertex_path;
+        fragment_path_ = fragment_path;
+        defines_ = std::move(defines);
+        Create(gpr5300::LoadShaderSource(vertex_path), gpr5300::LoadShaderSource(fragment_path), mode);
+    }
+
+    //Constructor from the sources embedded by shader_compiler in a generated header, no file is read. The paths
+    //stay those hot reload watches.
+    explicit Shader(const gpr5300::ProgramSource& source, const ShaderCompile mode = ShaderCompile::Blocking,
+                    ShaderDefines defines = {})
+    {
+        gpr5300::ScopedZone zone("Shader::Shader");
+        vertex_path_ = source.vertex_path;
+        fragment_path_ = source.fragment_path;
+        defines_ = std::move(defines);
+        Create(std::string(source.vertex_source), std::string(source.fragment_source), mode);
+    }
+
+    //Program pipeline of two separable stages, shared with the other pipelines using them. Nothing is compiled here:
+    //the pipeline is ready once both stages are.
+    Shader(std::shared_ptr<const ShaderStage> vertex, std::shared_ptr<const ShaderStage> fragment)
+    {
+        vertex_path_ = vertex->Path();
+        fragment_path_ = fragment->Path();
+        defines_ = fragment->Defines();
+        vertex_stage_ = std::move(vertex);
+        fragment_stage_ = std::move(fragment);
+        id_ = fragment_stage_->Program();
+        glGenProgramPipelines(1, &pipeline_);
+        pending_ = true;
+    }
+
+    //Never blocks: false while the driver is still compiling or linking an async program
+    [[nodiscard]] bool IsReady() const
     {
-        GLint success;
-        //Load shaders
-        const auto vertex_content = gpr5300::LoadFile(vertex_path);
-        const auto* v_shader_code = vertex_content.data();
-        const unsigned int vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex_shader, 1, &v_shader_code, nullptr);
-        glCompileShader(vertex_shader);
-        glGetShaderiv(vertex_shader, GL_COMPILE_STATUS, &success);
-        if (!success)
+        if (!pending_)
         {
-            std::cerr << "Error while loading vertex shader\n";
+            return true;
         }
-
-        const auto fragment_content = gpr5300::LoadFile(fragment_path);
-        const auto* f_shader_code = fragment_content.data();
-        const unsigned int fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment_shader, 1, &f_shader_code, nullptr);
-        glCompileShader(fragment_shader);
-        glGetShaderiv(fragment_shader, GL_COMPILE_STATUS, &success);
-        if (!success)
+        if (IsPipeline())
         {
-            std::cerr << "Error while loading fragment shader\n";
+            if (!vertex_stage_->IsReady() || !fragment_stage_->IsReady())
+            {
+                return false;
+            }
         }
-
-        //Load program
-        id_ = glCreateProgram();
-        glAttachShader(id_, vertex_shader);
-        glAttachShader(id_, fragment_shader);
-        glLinkProgram(id_);
-        //Check if shader program was linked correctly
-        glGetProgramiv(id_, GL_LINK_STATUS, &success);
-        if (!success)
+        else if (GLEW_KHR_parallel_shader_compile)
         {
-            std::cerr << "Error while linking shader program\n";
+            GLint completed = GL_FALSE;
+            glGetProgramiv(id_, GL_COMPLETION_STATUS_KHR, &completed);
+            if (!completed)
+            {
+                return false;
+            }
         }
+        Finish();
+        return true;
+    }
 
-        glDeleteShader(vertex_shader);
-        glDeleteShader(fragment_shader);
+    //Once ready: false when the program failed to compile or link
+    [[nodiscard]] bool IsLinked() const
+    {
+        Wait();
+        return linked_;
+    }
+
+    [[nodiscard]] bool IsPipeline() const { return pipeline_ != 0; }
+    [[nodiscard]] bool UsesStage(const ShaderStage* stage) const
+    {
+        return vertex_stage_.get() == stage || fragment_stage_.get() == stage;
     }
 
+    //Hot reload: takes over the program of next, a ready and linked rebuild of the same files, and deletes the
+    //current one once the uniform values set on it are copied over. The paths stay those the shader was loaded
+    //from, next may have read the source tree. Bumps the revision, handles from GetUniform must be resolved again
+    //when it changes.
+    void Replace(Shader&& next)
+    {
+        const unsigned int previous = id_;
+        const unsigned int revision = revision_;
+        std::string vertex_path = std::move(vertex_path_);
+        std::string fragment_path = std::move(fragment_path_);
+        *this = std::move(next);
+        vertex_path_ = std::move(vertex_path);
+        fragment_path_ = std::move(fragment_path);
+        revision_ = revision + 1;
+        CopyUniformValues(previous, id_);
+        gpr5300::GlState::DeleteProgram(previous);
+    }
+
+    //Hot reload of a pipeline: one of its stages was replaced, attaches its new program. ShaderStage::Replace
+    //already copied the uniform values to it. Bumps the revision.
+    void RefreshStages()
+    {
+        id_ = fragment_stage_->Program();
+        pending_ = true;
+        revision_++;
+    }
+
+    [[nodiscard]] unsigned int Revision() const { return revision_; }
+    [[nodiscard]] const std::string& VertexPath() const { return vertex_path_; }
+    [[nodiscard]] const std::string& FragmentPath() const { return fragment_path_; }
+    [[nodiscard]] const ShaderDefines& Defines() const { return defines_; }
+
     void Use() const
     {
-        glUseProgram(id_);
+        Wait();
+        if (IsPipeline())
+        {
+            //A program in use takes precedence over the bound pipeline
+            gpr5300::GlState::UseProgram(0);
+            gpr5300::GlState::BindProgramPipeline(pipeline_);
+        }
+        else
+        {
+            gpr5300::GlState::UseProgram(id_);
+        }
     }
 
     void Delete() const
     {
-        glDeleteProgram(id_);
+        if (IsPipeline())
+        {
+            //The stages belong to the ResourceCache
+            gpr5300::GlState::DeleteProgramPipelines(1, &pipeline_);
+            return;
+        }
+        if (pending_)
+        {
+            glDeleteShader(vertex_shader_);
+            glDeleteShader(fragment_shader_);
+        }
+        gpr5300::GlState::DeleteProgram(id_);
     }
 
-    //Uniform functions
-    void SetBool(const std::string &name, const bool value) const
+    //Handle to a uniform of the default block, for the uniforms set every frame. Array elements may be named
+    //"array[i]", a handle to "array" or "array[0]" covers the whole array.
+    template <typename T>
+    [[nodiscard]] UniformHandle<T> GetUniform(const std::string_view name) const
     {
-        glUniform1i(glGetUniformLocation(id_, name.c_str()), static_cast<int>(value));
+        Wait();
+        const auto it = uniforms_.find(name);
+        if (it == uniforms_.end())
+        {
+            return {};
+        }
+        return {{it->second.slots[0], it->second.slots[1]}, it->second.count};
     }
-    void SetInt(const std::string &name, const int value) const
+    //From the constants generated by shader_compiler, the type comes with the name
+    template <typename T>
+    [[nodiscard]] UniformHandle<T> GetUniform(const gpr5300::UniformName<T> uniform) const
     {
-        glUniform1i(glGetUniformLocation(id_, name.c_str()), value);
+        return GetUniform<T>(uniform.name);
     }
-    void SetFloat(const std::string &name, const float value) const
+
+    //Set with glProgramUniform, which does not need the program in use and reaches every stage of a pipeline
+    void Set(const UniformHandle<bool> handle, const bool value) const
     {
-        glUniform1f(glGetUniformLocation(id_, name.c_str()), value);
+        ForEachSlot(handle, [&](const UniformSlot slot)
+        {
+            glProgramUniform1i(slot.program, slot.location, static_cast<int>(value));
+        });
     }
-    void SetVec2(const std::string &name, const glm::vec2 &value) const
+    void Set(const UniformHandle<int> handle, const int value) const
     {
-        glUniform2fv(glGetUniformLocation(id_, name.c_str()), 1, &value[0]);
+        ForEachSlot(handle, [&](const UniformSlot slot) { glProgramUniform1i(slot.program, slot.location, value); });
     }
-    void SetVec2(const std::string &name, const float x, const float y) const
+    void Set(const UniformHandle<float> handle, const float value) const
     {
-        glUniform2f(glGetUniformLocation(id_, name.c_str()), x, y);
+        ForEachSlot(handle, [&](const UniformSlot slot) { glProgramUniform1f(slot.program, slot.location, value); });
     }
-    void SetVec3(const std::string &name, const glm::vec3 &value) const
+    void Set(const UniformHandle<glm::vec2> handle, const glm::vec2 &value) const
     {
-        glUniform3fv(glGetUniformLocation(id_, name.c_str()), 1, &value[0]);
+        ForEachSlot(handle, [&](const UniformSlot slot)
+        {
+            glProgramUniform2fv(slot.program, slot.location, 1, &value[0]);
+        });
     }
-    void SetVec3(const std::string &name, const float x, const float y, const float z) const
+    void Set(const UniformHandle<glm::vec3> handle, const glm::vec3 &value) const
     {
-        glUniform3f(glGetUniformLocation(id_, name.c_str()), x, y, z);
+        ForEachSlot(handle, [&](const UniformSlot slot)
+        {
+            glProgramUniform3fv(slot.program, slot.location, 1, &value[0]);
+        });
     }
-    void SetVec4(const std::string &name, const glm::vec4 &value) const
+    void Set(const UniformHandle<glm::vec4> handle, const glm::vec4 &value) const
     {
-        glUniform4fv(glGetUniformLocation(id_, name.c_str()), 1, &value[0]);
+        ForEachSlot(handle, [&](const UniformSlot slot)
+        {
+            glProgramUniform4fv(slot.program, slot.location, 1, &value[0]);
+        });
     }
-    void SetVec4(const std::string &name, const float x, const float y, const float z, const float w) const
+    void Set(const UniformHandle<glm::mat2> handle, const glm::mat2 &value) const
     {
-        glUniform4f(glGetUniformLocation(id_, name.c_str()), x, y, z, w);
+        ForEachSlot(handle, [&](const UniformSlot slot)
+        {
+            glProgramUniformMatrix2fv(slot.program, slot.location, 1, GL_FALSE, value_ptr(value));
+        });
     }
-    void SetMat2(const std::string &name, const glm::mat2 &value) const
+    void Set(const UniformHandle<glm::mat3> handle, const glm::mat3 &value) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(id_, name.c_str()), 1,GL_FALSE, value_ptr(value));
+        ForEachSlot(handle, [&](const UniformSlot slot)
+        {
+            glProgramUniformMatrix3fv(slot.program, slot.location, 1, GL_FALSE, value_ptr(value));
+        });
     }
-    void SetMat3(const std::string &name, const glm::mat3 &value) const
+    void Set(const UniformHandle<glm::mat4> handle, const glm::mat4 &value) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(id_, name.c_str()), 1, GL_FALSE, value_ptr(value));
+        ForEachSlot(handle, [&](const UniformSlot slot)
+        {
+            glProgramUniformMatrix4fv(slot.program, slot.location, 1, GL_FALSE, value_ptr(value));
+        });
     }
-    void SetMat4(const std::string &name, const glm::mat4 &value) const
+    //Whole array in one call, count is clamped to the array size
+    void Set(const UniformHandle<glm::mat4> handle, const glm::mat4* values, const GLsizei count) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(id_, name.c_str()), 1, GL_FALSE, value_ptr(value));
+        ForEachSlot(handle, [&](const UniformSlot slot)
+        {
+            glProgramUniformMatrix4fv(slot.program, slot.location, std::min(count, handle.count), GL_FALSE,
+                                      reinterpret_cast<const GLfloat*>(values));
+        });
     }
+
+    //Generated uniform constant and value, the value converts to the type of the uniform
+    template <typename T>
+    void Set(const gpr5300::UniformName<T> uniform, const std::type_identity_t<T>& value) const
+    {
+        Set(GetUniform<T>(uniform.name), value);
+    }
+
+    //Uniform functions, looked up by name in the reflected table instead of asking GL each call
+    void SetBool(const std::string_view name, const bool value) const
+    {
+        Set(GetUniform<bool>(name), value);
+    }
+    void SetInt(const std::string_view name, const int value) const
+    {
+        Set(GetUniform<int>(name), value);
+    }
+    void SetFloat(const std::string_view name, const float value) const
+    {
+        Set(GetUniform<float>(name), value);
+    }
+    void SetVec2(const std::string_view name, const glm::vec2 &value) const
+    {
+        Set(GetUniform<glm::vec2>(name), value);
+    }
+    void SetVec2(const std::string_view name, const float x, const float y) const
+    {
+        Set(GetUniform<glm::vec2>(name), glm::vec2(x, y));
+    }
+    void SetVec3(const std::string_view name, const glm::vec3 &value) const
+    {
+        Set(GetUniform<glm::vec3>(name), value);
+    }
+    void SetVec3(const std::string_view name, const float x, const float y, const float z) const
+    {
+        Set(GetUniform<glm::vec3>(name), glm::vec3(x, y, z));
+    }
+    void SetVec4(const std::string_view name, const glm::vec4 &value) const
+    {
+        Set(GetUniform<glm::vec4>(name), value);
+    }
+    void SetVec4(const std::string_view name, const float x, const float y, const float z, const float w) const
+    {
+        Set(GetUniform<glm::vec4>(name), glm::vec4(x, y, z, w));
+    }
+    void SetMat2(const std::string_view name, const glm::mat2 &value) const
+    {
+        Set(GetUniform<glm::mat2>(name), value);
+    }
+    void SetMat3(const std::string_view name, const glm::mat3 &value) const
+    {
+        Set(GetUniform<glm::mat3>(name), value);
+    }
+    void SetMat4(const std::string_view name, const glm::mat4 &value) const
+    {
+        Set(GetUniform<glm::mat4>(name), value);
+    }
+
+private:
+    void Create(const std::string& vertex_source, const std::string& fragment_source, const ShaderCompile mode)
+    {
+        const auto vertex_content = InjectDefines(vertex_source, defines_);
+        const auto fragment_content = InjectDefines(fragment_source, defines_);
+        id_ = glCreateProgram();
+        cache_key_ = gpr5300::ProgramCache::Key({vertex_content, fragment_content});
+        if (gpr5300::ProgramCache::Load(cache_key_, id_))
+        {
+            Finish();
+            return;
+        }
+        Submit(vertex_content.data(), fragment_content.data());
+        if (mode == ShaderCompile::Blocking)
+        {
+            Finish();
+        }
+    }
+
+    //Queues the compile and link without asking GL for any status, which would wait for them
+    void Submit(const char* v_shader_code, const char* f_shader_code)
+    {
+        vertex_shader_ = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertex_shader_, 1, &v_shader_code, nullptr);
+        glCompileShader(vertex_shader_);
+
+        fragment_shader_ = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragment_shader_, 1, &f_shader_code, nullptr);
+        glCompileShader(fragment_shader_);
+
+        //Load program
+        glAttachShader(id_, vertex_shader_);
+        glAttachShader(id_, fragment_shader_);
+        //Without the hint the driver may not keep a binary to retrieve for the program cache
+        glProgramParameteri(id_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(id_);
+        pending_ = true;
+    }
+
+    void Wait() const
+    {
+        if (pending_)
+        {
+            gpr5300::ScopedZone zone("Shader::Wait");
+            Finish();
+        }
+    }
+
+    //Checks the link once it completed, then caches the binary and reflects the uniforms
+    void Finish() const
+    {
+        if (pending_ && IsPipeline())
+        {
+            linked_ = vertex_stage_->IsLinked() && fragment_stage_->IsLinked();
+            //A stage that failed to link cannot be attached, the pipeline draws nothing
+            if (linked_)
+            {
+                glUseProgramStages(pipeline_, GL_VERTEX_SHADER_BIT, vertex_stage_->Program());
+                glUseProgramStages(pipeline_, GL_FRAGMENT_SHADER_BIT, fragment_stage_->Program());
+                //Where the glUniform calls of code given id_, like Model::Draw, go
+                glActiveShaderProgram(pipeline_, fragment_stage_->Program());
+            }
+            pending_ = false;
+            uniforms_.clear();
+            ReflectUniforms(vertex_stage_->Program());
+            ReflectUniforms(fragment_stage_->Program());
+            return;
+        }
+        if (pending_)
+        {
+            //Check if shader program was linked correctly, the stages only need checking when it did not
+            GLint success;
+            glGetProgramiv(id_, GL_LINK_STATUS, &success);
+            linked_ = success;
+            if (!success)
+            {
+                glGetShaderiv(vertex_shader_, GL_COMPILE_STATUS, &success);
+                if (!success)
+                {
+                    std::cerr << "Error while loading vertex shader " << vertex_path_ << '\n';
+                    PrintInfoLog(vertex_shader_, glGetShaderiv, glGetShaderInfoLog);
+                }
+                glGetShaderiv(fragment_shader_, GL_COMPILE_STATUS, &success);
+                if (!success)
+                {
+                    std::cerr << "Error while loading fragment shader " << fragment_path_ << '\n';
+                    PrintInfoLog(fragment_shader_, glGetShaderiv, glGetShaderInfoLog);
+                }
+                std::cerr << "Error while linking shader program\n";
+                PrintInfoLog(id_, glGetProgramiv, glGetProgramInfoLog);
+            }
+            else
+            {
+                gpr5300::ProgramCache::Save(cache_key_, id_);
+            }
+            glDetachShader(id_, vertex_shader_);
+            glDetachShader(id_, fragment_shader_);
+            glDeleteShader(vertex_shader_);
+            glDeleteShader(fragment_shader_);
+            pending_ = false;
+        }
+        ReflectUniforms(id_);
+        gpr5300::FrameUniforms::BindBlocks(id_);
+    }
+
+    struct UniformInfo
+    {
+        UniformSlot slots[2];
+        GLint count = 1;
+    };
+
+    template <typename T, typename Function>
+    static void ForEachSlot(const UniformHandle<T>& handle, Function function)
+    {
+        for (const UniformSlot slot : handle.slots)
+        {
+            if (slot.location >= 0)
+            {
+                function(slot);
+            }
+        }
+    }
+
+    //Transparent so string_view and string literals look up without building a std::string
+    struct NameHash
+    {
+        using is_transparent = void;
+        std::size_t operator()(const std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+
+    //The second stage of a pipeline declaring a uniform gets the second slot
+    void AddUniform(const std::string& name, const GLuint program, const GLint location, const GLint count) const
+    {
+        UniformInfo& info = uniforms_[name];
+        UniformSlot& slot = info.slots[0].location >= 0 && info.slots[0].program != program ? info.slots[1]
+                                                                                          : info.slots[0];
+        slot = {program, location};
+        info.count = count;
+    }
+
+    //Every active uniform of the default block, known once linked, so a name missing here is inactive
+    void ReflectUniforms(const GLuint program) const
+    {
+        GLint uniform_count = 0;
+        GLint max_length = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniform_count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+        std::string name(std::max(max_length, 1), '\0');
+        for (GLint i = 0; i < uniform_count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(program, i, max_length, &length, &size, &type, name.data());
+            const std::string uniform_name(name.data(), length);
+            const GLint location = glGetUniformLocation(program, uniform_name.c_str());
+            //Members of uniform blocks have no location
+            if (location < 0)
+            {
+                continue;
+            }
+            AddUniform(uniform_name, program, location, size);
+            //Arrays are reported as "array[0]", also register "array" and every other element
+            if (uniform_name.ends_with("[0]"))
+            {
+                const std::string base = uniform_name.substr(0, uniform_name.size() - 3);
+                AddUniform(base, program, location, size);
+                for (GLint element = 1; element < size; element++)
+                {
+                    const std::string element_name = base + "[" + std::to_string(element) + "]";
+                    AddUniform(element_name, program, glGetUniformLocation(program, element_name.c_str()),
+                               size - element);
+                }
+            }
+        }
+    }
+
+    mutable std::unordered_map<std::string, UniformInfo, NameHash, std::equal_to<>> uniforms_;
+    std::uint64_t cache_key_ = 0;
+    //Stages of an async program until its link completed
+    GLuint vertex_shader_ = 0;
+    GLuint fragment_shader_ = 0;
+    //Separable stages of a pipeline, pipeline_ is 0 for a monolithic program
+    GLuint pipeline_ = 0;
+    std::shared_ptr<const ShaderStage> vertex_stage_;
+    std::shared_ptr<const ShaderStage> fragment_stage_;
+    mutable bool pending_ = false;
+    //Programs restored from the binary cache are linked
+    mutable bool linked_ = true;
+    unsigned int revision_ = 0;
+    std::string vertex_path_;
+    std::string fragment_path_;
+    ShaderDefines defines_;
 };
 
 #endif //SHADER_H_
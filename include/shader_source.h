@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace gpr5300
+{
+    //Source of a shader file with each #include "file" line replaced by that file, looked up next to the file
+    //including it. A file is included once however many files include it. The UTF-8 byte order mark is dropped.
+    //Shared by the runtime and the offline shader_compiler, so both compile the same text. complete is false when a
+    //file could not be read, its #include becomes an #error the compile reports.
+    std::string LoadShaderSource(std::string_view path, bool* complete = nullptr);
+
+    //Stages of a program embedded by shader_compiler in its generated header, the paths are what hot reload watches
+    struct ProgramSource
+    {
+        const char* vertex_path;
+        std::string_view vertex_source;
+        const char* fragment_path;
+        std::string_view fragment_source;
+    };
+
+    //Uniform of a program reflected by shader_compiler, T is the C++ side of its GLSL type. A misspelled name is a
+    //missing constant: a compile error instead of a location of -1.
+    template <typename T>
+    struct UniformName
+    {
+        std::string_view name;
+    };
+} // namespace gpr5300
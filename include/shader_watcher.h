@@ -0,0 +1,38 @@
+#pragma once
+
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace gpr5300
+{
+    //Watches a shader directory and its subdirectories with inotify on a background thread and collects the files
+    //written since the last TakeChanges. Only records paths: the programs are rebuilt by ResourceCache on the
+    //GL thread. Linux only, Start fails elsewhere.
+    class ShaderWatcher
+    {
+    public:
+        bool Start(std::string_view directory);
+        void Stop();
+
+        //Paths of the files written or moved in since the last call, each once
+        [[nodiscard]] std::vector<std::string> TakeChanges();
+
+    private:
+        void Run();
+        void Watch(const std::string& directory);
+
+        int inotify_fd_ = -1;
+        //Wakes the watcher thread out of poll when stopping
+        int stop_fd_ = -1;
+        std::thread thread_;
+        std::unordered_map<int, std::string> directories_;
+
+        std::mutex mutex_;
+        std::set<std::string> changes_;
+    };
+} // namespace gpr5300
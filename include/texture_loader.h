@@ -1,7 +1,14 @@
 #ifndef SAMPLES_OPENGL_TEXTURE_LOADER_H
 #define SAMPLES_OPENGL_TEXTURE_LOADER_H
 
+#include <string>
 #include <string_view>
+#include <vector>
+
+namespace gpr5300
+{
+class JobSystem;
+}
 
 struct Image
 {
@@ -11,6 +18,15 @@ struct Image
   int comp = 0; //stat that depends on the format -> .jpeg has 3 I think and stuff....
 };
 
+//stbi_load without any GL call, safe to run on a job system worker. pixel is null if the file failed to load
+Image DecodeImage(const char* path, int desired_comp = 0);
+void FreeImage(Image& image);
+
+//GL texture loaders shared by Model, ModelAnim and the scenes, defined once here so every scene can link together
+unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma = false);
+unsigned int TextureFromImage(const Image& image, bool gamma = false);
+unsigned int CubemapFromVec(std::vector<std::string> faces, gpr5300::JobSystem* jobs = nullptr);
+
 
 class TextureManager
 {
@@ -1,6 +1,7 @@
 ﻿#include <fstream>
 #include <imgui.h>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -9,15 +10,32 @@
 
 #include "engine.h"
 #include "file_utility.h"
+#include "frame_uniforms.h"
 #include "free_camera.h"
+#include "gl_resources.h"
+#include "gl_state.h"
+#include "gpu_profiler.h"
 #include "global_utility.h"
+#include "input.h"
 #include "model.h"
+#include "render_target_pool.h"
+#include "resource_cache.h"
 #include "scene.h"
+#include "scene_registry.h"
 #include "shader.h"
+#include "shaders/bloom_blur.h"
+#include "shaders/bloom_final.h"
+#include "shaders/bloom_light.h"
+#include "shaders/bloom_scene.h"
 #include "texture_loader.h"
 
 namespace gpr5300
 {
+    namespace blur_uniforms = shaders::bloom_blur::uniforms;
+    namespace final_uniforms = shaders::bloom_final::uniforms;
+    namespace light_uniforms = shaders::bloom_light::uniforms;
+    namespace scene_uniforms = shaders::bloom_scene::uniforms;
+
     class Bloom final : public Scene
     {
     public:
@@ -29,103 +47,74 @@ namespace gpr5300
         void UpdateCamera(const float dt) override;
 
     private:
-        Shader shader_ = {};
-        Shader shader_light_ = {};
-        Shader shader_blur_ = {};
-        Shader shader_bloom_final_ = {};
+        void AcquireTargets();
+        [[nodiscard]] std::shared_ptr<const Shader> LoadBlurShader() const;
+
+        std::shared_ptr<const Shader> shader_;
+        std::shared_ptr<const Shader> shader_light_;
+        std::shared_ptr<const Shader> shader_blur_;
+        std::shared_ptr<const Shader> shader_bloom_final_;
+        //Variant picked in the UI, the current blur keeps running until it linked
+        std::shared_ptr<const Shader> next_shader_blur_;
 
         GLuint hdr_fbo_ = 0;
-        GLuint color_buffer_[2] = {};
-        GLuint rbo_depth_ = 0;
+        RenderTarget color_buffer_[2];
+        RenderTarget rbo_depth_;
 
         //Pingpong for blur
         GLuint pingpong_fbo_[2] = {};
-        GLuint pingpong_color_buffer_[2] = {};
+        RenderTarget pingpong_color_buffer_[2];
+        std::uint32_t targets_generation_ = 0;
 
-        unsigned int ground_texture_ = 0;
-        unsigned int box_texture_ = 0;
+        std::shared_ptr<const SharedTexture> ground_texture_;
+        std::shared_ptr<const SharedTexture> box_texture_;
 
         float elapsedTime_ = 0.0f;
 
         std::vector<glm::vec3> light_positions_ = {};
         std::vector<glm::vec3> light_colors_ = {};
 
-        FreeCamera* camera_ = nullptr;
+        std::unique_ptr<FreeCamera> camera_;
 
+        bool shaders_configured_ = false;
         bool hdr_state_ = true;
         bool bloom_state_ = true;
         float exposure_ = 1.0f;
+        //5 taps a side when set, 3 otherwise
+        bool high_quality_blur_ = true;
     };
 
     void Bloom::Begin()
     {
         // configure global opengl state
         // -----------------------------
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LESS);
-        // glEnable(GL_CULL_FACE);
-        // glCullFace(GL_FRONT);
+        GlState::Enable(GL_DEPTH_TEST);
+        GlState::DepthFunc(GL_LESS);
+        // GlState::Enable(GL_CULL_FACE);
+        // GlState::CullFace(GL_FRONT);
 
-        camera_ = new FreeCamera();
+        camera_ = std::make_unique<FreeCamera>();
 
         //Build shaders
-        shader_ = Shader("data/shaders/bloom/bloom.vert", "data/shaders/bloom/bloom.frag");
-        shader_light_ = Shader("data/shaders/bloom/bloom.vert", "data/shaders/bloom/light.frag");
-        shader_blur_ = Shader("data/shaders/bloom/blur.vert", "data/shaders/bloom/blur.frag");
-        shader_bloom_final_ = Shader("data/shaders/bloom/bloom_final.vert", "data/shaders/bloom/bloom_final.frag");
+        //bloom.vert is compiled once for the boxes and the lights
+        shader_ = resources_->LoadPipeline(shaders::bloom_scene::source.vertex_path,
+                                           shaders::bloom_scene::source.fragment_path);
+        shader_light_ = resources_->LoadPipeline(shaders::bloom_light::source.vertex_path,
+                                                 shaders::bloom_light::source.fragment_path);
+        shader_blur_ = LoadBlurShader();
+        shader_bloom_final_ = resources_->LoadShader(shaders::bloom_final::source);
 
         //load textures
-        ground_texture_ = TextureFromFile("marble.jpg", "data/textures", true);
-        box_texture_ = TextureFromFile("container2.png", "data/textures", true);
+        ground_texture_ = resources_->LoadTexture("marble.jpg", "data/textures", true);
+        box_texture_ = resources_->LoadTexture("container2.png", "data/textures", true);
 
 
         //Configure FBO
-        glGenFramebuffers(1, &hdr_fbo_);
-        glBindFramebuffer(GL_FRAMEBUFFER, hdr_fbo_);
-        //We need 2 floating point color buffers, for normal rendering and brightness thresholds
-        glGenTextures(2, color_buffer_);
-        for (unsigned int i = 0; i < 2; i++)
-        {
-            glBindTexture(GL_TEXTURE_2D, color_buffer_[i]);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, 1280, 720, 0, GL_RGBA, GL_FLOAT, NULL);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            //be sure to clamp to edge!
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, color_buffer_[i], 0);
-        }
-
-        //create and attach depth buffer
-        glGenRenderbuffers(1, &rbo_depth_);
-        glBindRenderbuffer(GL_RENDERBUFFER, rbo_depth_);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, 1280, 720);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rbo_depth_);
-        //select color attachment
-        unsigned int attachments[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
-        glDrawBuffers(2, attachments);
-        // finally check if framebuffer is complete
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-            std::cout << "Framebuffer not complete!" << std::endl;
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
+        hdr_fbo_ = GlResources::CreateFramebuffer();
         //Pingpong for blur
-        glGenFramebuffers(2, pingpong_fbo_);
-        glGenTextures(2, pingpong_color_buffer_);
-        for (unsigned int i = 0; i < 2; i++)
-        {
-            glBindFramebuffer(GL_FRAMEBUFFER, pingpong_fbo_[i]);
-            glBindTexture(GL_TEXTURE_2D, pingpong_color_buffer_[i]);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, 1280, 720, 0, GL_RGBA, GL_FLOAT, NULL);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingpong_color_buffer_[i], 0);
-            // also check if framebuffers are complete (no need for depth buffer)
-            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-                std::cout << "Framebuffer not complete!" << std::endl;
-        }
+        pingpong_fbo_[0] = GlResources::CreateFramebuffer();
+        pingpong_fbo_[1] = GlResources::CreateFramebuffer();
+        AcquireTargets();
 
         // lighting info
         // -------------
@@ -141,143 +130,221 @@ namespace gpr5300
         light_colors_.push_back(glm::vec3(0.0f, 5.0f, 0.0f));
 
 
-        // shader configuration
-        // --------------------
-        shader_.Use();
-        shader_.SetInt("diffuseTexture", 0);
-        shader_blur_.Use();
-        shader_blur_.SetInt("image", 0);
-        shader_bloom_final_.Use();
-        shader_bloom_final_.SetInt("scene", 0);
-        shader_bloom_final_.SetInt("bloomBlur", 1);
+        shaders_configured_ = false;
+    }
+
+    void Bloom::AcquireTargets()
+    {
+        //The buffers of the previous size go back to the pool, which deletes them at the end of the frame
+        for (unsigned int i = 0; i < 2; i++)
+        {
+            render_targets_->Release(color_buffer_[i]);
+            render_targets_->Release(pingpong_color_buffer_[i]);
+        }
+        render_targets_->Release(rbo_depth_);
+        targets_generation_ = render_targets_->Generation();
+
+        //Pool textures are linear and clamped to edge, as the blur needs
+        constexpr RenderTargetDesc hdr_desc{.internal_format = GL_RGBA16F};
+        //We need 2 floating point color buffers, for normal rendering and brightness thresholds
+        for (unsigned int i = 0; i < 2; i++)
+        {
+            color_buffer_[i] = render_targets_->Acquire(hdr_desc);
+            RenderTargetPool::Attach(hdr_fbo_, GL_COLOR_ATTACHMENT0 + i, color_buffer_[i]);
+        }
+
+        //create and attach depth buffer
+        rbo_depth_ = render_targets_->Acquire({.internal_format = GL_DEPTH_COMPONENT24, .renderbuffer = true});
+        RenderTargetPool::Attach(hdr_fbo_, GL_DEPTH_ATTACHMENT, rbo_depth_);
+        //select color attachment
+        constexpr GLenum attachments[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+        glNamedFramebufferDrawBuffers(hdr_fbo_, 2, attachments);
+        // finally check if framebuffer is complete
+        GlResources::CheckFramebuffer(hdr_fbo_, "bloom hdr");
+
+        for (unsigned int i = 0; i < 2; i++)
+        {
+            pingpong_color_buffer_[i] = render_targets_->Acquire(hdr_desc);
+            RenderTargetPool::Attach(pingpong_fbo_[i], GL_COLOR_ATTACHMENT0, pingpong_color_buffer_[i]);
+            // also check if framebuffers are complete (no need for depth buffer)
+            GlResources::CheckFramebuffer(pingpong_fbo_[i], "bloom pingpong");
+        }
     }
 
     void Bloom::End()
     {
-        shader_.Delete();
-        shader_blur_.Delete();
-        shader_light_.Delete();
-        shader_bloom_final_.Delete();
+        for (unsigned int i = 0; i < 2; i++)
+        {
+            render_targets_->Release(color_buffer_[i]);
+            render_targets_->Release(pingpong_color_buffer_[i]);
+        }
+        render_targets_->Release(rbo_depth_);
+        GlState::DeleteFramebuffers(1, &hdr_fbo_);
+        GlState::DeleteFramebuffers(2, pingpong_fbo_);
+        shader_.reset();
+        shader_blur_.reset();
+        next_shader_blur_.reset();
+        shader_light_.reset();
+        shader_bloom_final_.reset();
+        ground_texture_.reset();
+        box_texture_.reset();
     }
 
     void Bloom::Update(const float dt)
     {
         UpdateCamera(dt);
         elapsedTime_ += dt;
+        if (targets_generation_ != render_targets_->Generation())
+        {
+            AcquireTargets();
+        }
 
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        //The programs keep linking in the background after Begin, skip the frames until all of them are ready
+        if (!shaders_configured_)
+        {
+            if (!shader_->IsReady() || !shader_light_->IsReady() || !shader_blur_->IsReady() ||
+                !shader_bloom_final_->IsReady())
+            {
+                return;
+            }
+            // shader configuration
+            // --------------------
+            shader_->Use();
+            shader_->Set(scene_uniforms::diffuseTexture, 0);
+            shader_blur_->Use();
+            shader_blur_->Set(blur_uniforms::image, 0);
+            shader_bloom_final_->Use();
+            shader_bloom_final_->Set(final_uniforms::scene, 0);
+            shader_bloom_final_->Set(final_uniforms::bloomBlur, 1);
+            shaders_configured_ = true;
+        }
+        if (next_shader_blur_ != nullptr && next_shader_blur_->IsReady())
+        {
+            next_shader_blur_->Use();
+            next_shader_blur_->Set(blur_uniforms::image, 0);
+            shader_blur_ = std::move(next_shader_blur_);
+        }
+
+        auto& profiler = GpuProfiler::Get();
+
         // 1. render scene into floating point framebuffer
         // -----------------------------------------------
-        glBindFramebuffer(GL_FRAMEBUFFER, hdr_fbo_);
+        profiler.BeginPass("HDR scene");
+        GlState::BindFramebuffer(GL_FRAMEBUFFER, hdr_fbo_);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        auto projection = glm::perspective(glm::radians(45.0f), (float)1280 / (float)720, 0.1f, 1000.0f);
+        auto projection = glm::perspective(glm::radians(45.0f), render_targets_->AspectRatio(), 0.1f, 1000.0f);
         auto view = camera_->view();
         auto model = glm::mat4(1.0f);
-        shader_.Use();
-        shader_.SetMat4("projection", projection);
-        shader_.SetMat4("view", view);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, ground_texture_);
-        // set lighting uniforms
-        for (unsigned int i = 0; i < light_positions_.size(); i++)
+        //View and lights go to the shared uniform blocks once for both programs
+        frame_uniforms_->SetView({view, projection, glm::vec4(camera_->camera_position_, 1.0f)});
+        LightData lights;
+        lights.count = static_cast<int>(light_positions_.size());
+        for (int i = 0; i < lights.count; i++)
         {
-            shader_.SetVec3("lights[" + std::to_string(i) + "].Position", light_positions_[i]);
-            shader_.SetVec3("lights[" + std::to_string(i) + "].Color", light_colors_[i]);
+            lights.positions[i] = glm::vec4(light_positions_[i], 1.0f);
+            lights.colors[i] = glm::vec4(light_colors_[i], 1.0f);
         }
-        shader_.SetVec3("viewPos", camera_->camera_position_);
+        frame_uniforms_->SetLights(lights);
+        shader_->Use();
+        GlState::ActiveTexture(GL_TEXTURE0);
+        GlState::BindTexture(GL_TEXTURE_2D, ground_texture_->id);
         // create one large cube that acts as the floor
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(0.0f, -1.0f, 0.0));
         model = glm::scale(model, glm::vec3(12.5f, 0.5f, 12.5f));
-        shader_.SetMat4("model", model);
+        shader_->Set(scene_uniforms::model, model);
         renderCube();
         // then create multiple cubes as the scenery
-        glBindTexture(GL_TEXTURE_2D, box_texture_);
+        GlState::BindTexture(GL_TEXTURE_2D, box_texture_->id);
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(0.0f, 1.5f, 0.0));
         model = glm::scale(model, glm::vec3(0.5f));
-        shader_.SetMat4("model", model);
+        shader_->Set(scene_uniforms::model, model);
         renderCube();
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(2.0f, 0.0f, 1.0));
         model = glm::scale(model, glm::vec3(0.5f));
-        shader_.SetMat4("model", model);
+        shader_->Set(scene_uniforms::model, model);
         renderCube();
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(-1.0f, -1.0f, 2.0));
         model = glm::rotate(model, glm::radians(60.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
-        shader_.SetMat4("model", model);
+        shader_->Set(scene_uniforms::model, model);
         renderCube();
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(0.0f, 2.7f, 4.0));
         model = glm::rotate(model, glm::radians(23.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
         model = glm::scale(model, glm::vec3(1.25));
-        shader_.SetMat4("model", model);
+        shader_->Set(scene_uniforms::model, model);
         renderCube();
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(-2.0f, 1.0f, -3.0));
         model = glm::rotate(model, glm::radians(124.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
-        shader_.SetMat4("model", model);
+        shader_->Set(scene_uniforms::model, model);
         renderCube();
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(-3.0f, 0.0f, 0.0));
         model = glm::scale(model, glm::vec3(0.5f));
-        shader_.SetMat4("model", model);
+        shader_->Set(scene_uniforms::model, model);
         renderCube();
 
         // finally show all the light sources as bright cubes
-        shader_light_.Use();
-        shader_light_.SetMat4("projection", projection);
-        shader_light_.SetMat4("view", view);
+        shader_light_->Use();
 
         for (unsigned int i = 0; i < light_positions_.size(); i++)
         {
             model = glm::mat4(1.0f);
             model = glm::translate(model, glm::vec3(light_positions_[i]));
             model = glm::scale(model, glm::vec3(0.25f));
-            shader_light_.SetMat4("model", model);
-            shader_light_.SetVec3("lightColor", light_colors_[i]);
+            shader_light_->Set(light_uniforms::model, model);
+            shader_light_->Set(light_uniforms::lightColor, light_colors_[i]);
             renderCube();
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        GlState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.EndPass();
 
         // 2. blur bright fragments with two-pass Gaussian Blur
         // --------------------------------------------------
         bool horizontal = true, first_iteration = true;
         unsigned int amount = 10;
-        shader_blur_.Use();
+        profiler.BeginPass("Blur");
+        shader_blur_->Use();
         for (unsigned int i = 0; i < amount; i++)
         {
-            glBindFramebuffer(GL_FRAMEBUFFER, pingpong_fbo_[horizontal]);
-            shader_blur_.SetInt("horizontal", horizontal);
-            glBindTexture(GL_TEXTURE_2D, first_iteration ? color_buffer_[1] : pingpong_color_buffer_[!horizontal]);  // bind texture of other framebuffer (or scene if first iteration)
+            GlState::BindFramebuffer(GL_FRAMEBUFFER, pingpong_fbo_[horizontal]);
+            shader_blur_->Set(blur_uniforms::horizontal, horizontal);
+            GlState::BindTexture(GL_TEXTURE_2D, first_iteration ? color_buffer_[1].id : pingpong_color_buffer_[!horizontal].id);  // bind texture of other framebuffer (or scene if first iteration)
             renderQuad();
             horizontal = !horizontal;
             if (first_iteration)
                 first_iteration = false;
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        GlState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.EndPass();
 
         // 3. now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
         // --------------------------------------------------------------------------------------------------------------------------
+        profiler.BeginPass("Composite");
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        shader_bloom_final_.Use();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, color_buffer_[0]);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, pingpong_color_buffer_[!horizontal]);
-        shader_bloom_final_.SetInt("bloom", bloom_state_);
-        shader_bloom_final_.SetFloat("exposure", exposure_);
+        shader_bloom_final_->Use();
+        GlState::ActiveTexture(GL_TEXTURE0);
+        GlState::BindTexture(GL_TEXTURE_2D, color_buffer_[0].id);
+        GlState::ActiveTexture(GL_TEXTURE1);
+        GlState::BindTexture(GL_TEXTURE_2D, pingpong_color_buffer_[!horizontal].id);
+        shader_bloom_final_->Set(final_uniforms::bloom, bloom_state_);
+        shader_bloom_final_->Set(final_uniforms::exposure, exposure_);
         renderQuad();
+        profiler.EndPass();
 
-        glBindVertexArray(0);
+        GlState::BindVertexArray(0);
     }
 
     void Bloom::OnEvent(const SDL_Event& event)
@@ -288,7 +355,7 @@ namespace gpr5300
     void Bloom::UpdateCamera(const float dt)
     {
         // Get keyboard state
-        const Uint8* state = SDL_GetKeyboardState(NULL);
+        const Uint8* state = input_->GetKeyboardState();
 
         // Camera controls
         if (state[SDL_SCANCODE_W])
@@ -317,7 +384,7 @@ namespace gpr5300
         }
 
         int mouseX, mouseY;
-        const Uint32 mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
+        const Uint32 mouseState = input_->GetRelativeMouseState(&mouseX, &mouseY);
         if (mouseState & SDL_BUTTON(SDL_BUTTON_LEFT) && !ImGui::GetIO().WantCaptureMouse)
         {
             camera_->Update(mouseX, mouseY);
@@ -325,6 +392,11 @@ namespace gpr5300
     }
 
 
+    std::shared_ptr<const Shader> Bloom::LoadBlurShader() const
+    {
+        return resources_->LoadShader(shaders::bloom_blur::source, {{"BLUR_TAPS", high_quality_blur_ ? "5" : "3"}});
+    }
+
     void Bloom::DrawImGui()
     {
         ImGui::Begin("My Window"); // Start a new window
@@ -335,6 +407,11 @@ namespace gpr5300
 
         ImGui::SliderFloat("Exposure", &exposure_, 0.1f, 5.0f, "%.1f");
 
+        if (ImGui::Checkbox("High quality blur", &high_quality_blur_))
+        {
+            next_shader_blur_ = LoadBlurShader();
+        }
+
         // static ImVec4 LightColour = ImVec4(1.0f, 1.0f, 1.0f, 1.0f); // Default color
         // ImGui::ColorPicker3("Light Colour", reinterpret_cast<float*>(&light_colors_[0]));
         ImGui::End(); // End the window
@@ -342,11 +419,15 @@ namespace gpr5300
 }
 
 
+#ifdef GPR5300_SCENE_HOST
+static gpr5300::SceneRegistration registration("bloom", [] { return std::make_unique<gpr5300::Bloom>(); });
+#else
 int main(int argc, char* argv[])
 {
     gpr5300::Bloom scene;
-    gpr5300::Engine engine(&scene);
+    gpr5300::Engine engine(&scene, gpr5300::EngineSettings::FromArgs(argc, argv));
     engine.Run();
 
     return EXIT_SUCCESS;
 }
+#endif
@@ -1,6 +1,7 @@
 ﻿#include <fstream>
 #include <imgui.h>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -12,29 +13,47 @@
 #include "engine.h"
 #include "file_utility.h"
 #include "free_camera.h"
+#include "gl_resources.h"
+#include "gl_state.h"
+#include "gpu_profiler.h"
 #include "global_utility.h"
+#include "input.h"
 #include "model_anim.h"
+#include "render_target_pool.h"
+#include "resource_cache.h"
 #include "scene.h"
+#include "scene_registry.h"
 #include "shader.h"
+#include "shaders/combined.h"
+#include "shaders/shadow_debug_quad.h"
+#include "shaders/shadow_depth.h"
 
 namespace gpr5300
 {
+    namespace combined_uniforms = shaders::combined::uniforms;
+    namespace depth_uniforms = shaders::shadow_depth::uniforms;
+
     class CombinedScene final : public Scene
     {
     public:
         void Begin() override;
         void End() override;
         void Update(float dt) override;
+        bool SupportsFixedUpdate() const override { return true; }
+        void FixedUpdate(float fixed_dt) override;
+        void Render(float alpha) override;
         void OnEvent(const SDL_Event& event) override;
         void DrawImGui() override;
         void UpdateCamera(const float dt) override;
 
     private:
-        Shader shader_ = {};
-        Shader shader_depth_ = {};
-        Shader shader_quad_ = {};
+        std::shared_ptr<const Shader> shader_;
+        UniformHandle<glm::mat4> bones_uniform_;
+        unsigned int bones_revision_ = 0;
+        std::shared_ptr<const Shader> shader_depth_;
+        std::shared_ptr<const Shader> shader_quad_;
 
-        ModelAnim model_;
+        std::shared_ptr<ModelAnim> model_;
         Animation animation_ = {};
         Animator animator_ = {};
 
@@ -43,32 +62,33 @@ namespace gpr5300
         GLuint depth_map_fbo_ = 0;
         GLuint depth_map_texture_ = 0;
 
-        unsigned int ground_texture_ = 0;
+        std::shared_ptr<const SharedTexture> ground_texture_;
         float animation_speed_ = 1.0f;
         float model_scale_ = 1.0f;
 
         const unsigned int SHADOW_WIDTH = 1024, SHADOW_HEIGHT = 1024;
         glm::vec3 light_position_ = glm::vec3(-2.0f, 4.0f, -1.0f);
-        FreeCamera* camera_ = nullptr;
+        std::unique_ptr<FreeCamera> camera_;
     };
 
     void CombinedScene::Begin()
     {
         // Camera and OpenGL settings
-        camera_ = new FreeCamera();
-        glEnable(GL_DEPTH_TEST);
+        camera_ = std::make_unique<FreeCamera>();
+        GlState::Enable(GL_DEPTH_TEST);
 
         // Shaders
         // Main scene shader
-        shader_ = Shader("data/shaders/combined/combined.vert", "data/shaders/combined/combined.frag");
+        shader_ = resources_->LoadShader(shaders::combined::source);
+        bones_uniform_ = shader_->GetUniform(combined_uniforms::finalBonesMatrices);
         // Shadow depth shader
-        shader_depth_ = Shader("data/shaders/shadow_map/shadow_depth.vert","data/shaders/shadow_map/shadow_depth.frag");
+        shader_depth_ = resources_->LoadShader(shaders::shadow_depth::source);
         // Quad shader (if needed for post-processing)
-        shader_quad_ = Shader("data/shaders/shadow_map/debug_quad.vert", "data/shaders/shadow_map/debug_quad.frag");
+        shader_quad_ = resources_->LoadShader(shaders::shadow_debug_quad::source);
 
         // Animated Model
-        model_ = ModelAnim("data/Twist_Dance/Twist_Dance.dae");
-        animation_ = Animation("data/Twist_Dance/Twist_Dance.dae", &model_);
+        model_ = resources_->LoadModel<ModelAnim>("data/Twist_Dance/Twist_Dance.dae", job_system_);
+        animation_ = Animation("data/Twist_Dance/Twist_Dance.dae", model_.get());
         animator_ = Animator(&animation_);
 
         // Plane
@@ -83,7 +103,7 @@ namespace gpr5300
         };
         glGenVertexArrays(1, &plane_vao_);
         glGenBuffers(1, &plane_vbo_);
-        glBindVertexArray(plane_vao_);
+        GlState::BindVertexArray(plane_vao_);
         glBindBuffer(GL_ARRAY_BUFFER, plane_vbo_);
         glBufferData(GL_ARRAY_BUFFER, sizeof(planeVertices), planeVertices, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
@@ -92,97 +112,117 @@ namespace gpr5300
         glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
         glEnableVertexAttribArray(2);
         glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-        glBindVertexArray(0);
+        GlState::BindVertexArray(0);
 
         // Depth Map FBO
-        glGenFramebuffers(1, &depth_map_fbo_);
-        glGenTextures(1, &depth_map_texture_);
-        glBindTexture(GL_TEXTURE_2D, depth_map_texture_);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, 1024, 1024, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        depth_map_fbo_ = GlResources::CreateFramebuffer();
+        depth_map_texture_ = GlResources::CreateTexture2D(GL_DEPTH_COMPONENT24, 1024, 1024);
+        GlResources::SetSampling(depth_map_texture_, GL_NEAREST, GL_NEAREST, GL_CLAMP_TO_BORDER);
         float borderColor[] = {1.0f, 1.0f, 1.0f, 1.0f};
-        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-        glBindFramebuffer(GL_FRAMEBUFFER, depth_map_fbo_);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth_map_texture_, 0);
-        glDrawBuffer(GL_NONE);
-        glReadBuffer(GL_NONE);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glTextureParameterfv(depth_map_texture_, GL_TEXTURE_BORDER_COLOR, borderColor);
+        glNamedFramebufferTexture(depth_map_fbo_, GL_DEPTH_ATTACHMENT, depth_map_texture_, 0);
+        glNamedFramebufferDrawBuffer(depth_map_fbo_, GL_NONE);
+        glNamedFramebufferReadBuffer(depth_map_fbo_, GL_NONE);
+        GlResources::CheckFramebuffer(depth_map_fbo_, "combined scene shadow map");
 
-        shader_.Use();
-        shader_.SetInt("diffuseTexture", 0);
-        shader_.SetInt("shadowMap", 1);
+        shader_->Use();
+        shader_->Set(combined_uniforms::diffuseTexture, 0);
+        shader_->Set(combined_uniforms::shadowMap, 1);
 
         // Load textures
-        ground_texture_ = TextureFromFile("wood.png", "data/textures");
+        ground_texture_ = resources_->LoadTexture("wood.png", "data/textures");
     }
 
     void CombinedScene::End()
     {
-        shader_.Delete();
-        shader_quad_.Delete();
-        shader_depth_.Delete();
+        shader_.reset();
+        shader_quad_.reset();
+        shader_depth_.reset();
+        ground_texture_.reset();
+        model_.reset();
+
+        GlState::DeleteVertexArrays(1, &plane_vao_);
+        glDeleteBuffers(1, &plane_vbo_);
+        GlState::DeleteFramebuffers(1, &depth_map_fbo_);
+        GlState::DeleteTextures(1, &depth_map_texture_);
     }
 
     void CombinedScene::Update(const float dt)
+    {
+        FixedUpdate(dt);
+        Render(1.0f);
+    }
+
+    void CombinedScene::FixedUpdate(const float fixed_dt)
     {
         // Update camera and animation
-        UpdateCamera(dt);
-        animator_.UpdateAnimation(animation_speed_ * dt);
+        camera_->StorePreviousState();
+        UpdateCamera(fixed_dt);
+        animator_.UpdateAnimation(animation_speed_ * fixed_dt, job_system_);
+    }
+
+    void CombinedScene::Render(const float alpha)
+    {
+        auto& profiler = GpuProfiler::Get();
 
         // Shadow Pass
+        profiler.BeginPass("Shadow");
         glViewport(0, 0, 1024, 1024);
-        glBindFramebuffer(GL_FRAMEBUFFER, depth_map_fbo_);
+        GlState::BindFramebuffer(GL_FRAMEBUFFER, depth_map_fbo_);
         glClear(GL_DEPTH_BUFFER_BIT);
-        shader_depth_.Use();
+        shader_depth_->Use();
 
         // Render Plane in Shadow Pass
         glm::mat4 lightProjection = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, 1.0f, 7.5f);
         glm::mat4 lightView = glm::lookAt(light_position_, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
         glm::mat4 lightSpaceMatrix = lightProjection * lightView;
-        shader_depth_.SetMat4("lightSpaceMatrix", lightSpaceMatrix);
+        shader_depth_->Set(depth_uniforms::lightSpaceMatrix, lightSpaceMatrix);
 
         auto model = glm::mat4(1.0f);
-        shader_depth_.SetMat4("model", model);
-        glBindVertexArray(plane_vao_);
+        shader_depth_->Set(depth_uniforms::model, model);
+        GlState::BindVertexArray(plane_vao_);
         glDrawArrays(GL_TRIANGLES, 0, 6);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        GlState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.EndPass();
 
         // Scene Pass
-        glViewport(0, 0, 1280, 720);
+        profiler.BeginPass("Scene");
+        glViewport(0, 0, render_targets_->Width(), render_targets_->Height());
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        shader_.Use();
+        shader_->Use();
 
-        auto view = camera_->view();
-        auto projection = glm::perspective(glm::radians(45.0f), 1280.0f / 720.0f, 0.1f, 100.0f);
-        shader_.SetMat4("view", view);
-        shader_.SetMat4("projection", projection);
+        auto view = camera_->InterpolatedView(alpha);
+        auto projection = glm::perspective(glm::radians(45.0f), render_targets_->AspectRatio(), 0.1f, 100.0f);
+        shader_->Set(combined_uniforms::view, view);
+        shader_->Set(combined_uniforms::projection, projection);
 
-        shader_.SetMat4("lightSpaceMatrix", lightSpaceMatrix);
-        shader_.SetVec3("lightPos", light_position_);
-        shader_.SetVec3("viewPos", camera_->camera_position_);
+        shader_->Set(combined_uniforms::lightSpaceMatrix, lightSpaceMatrix);
+        shader_->Set(combined_uniforms::lightPos, light_position_);
+        shader_->Set(combined_uniforms::viewPos, camera_->InterpolatedPosition(alpha));
 
         // Render Plane
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, ground_texture_);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, depth_map_texture_);
+        GlState::ActiveTexture(GL_TEXTURE0);
+        GlState::BindTexture(GL_TEXTURE_2D, ground_texture_->id);
+        GlState::ActiveTexture(GL_TEXTURE1);
+        GlState::BindTexture(GL_TEXTURE_2D, depth_map_texture_);
         // renderScene(shader_, plane_vao_);
 
         // Render Animated Model
         auto transforms = animator_.GetFinalBoneMatrices();
-        for (int i = 0; i < transforms.size(); ++i)
+        //A hot reload may have moved the uniform
+        if (bones_revision_ != shader_->Revision())
         {
-            shader_.SetMat4("finalBonesMatrices[" + std::to_string(i) + "]", transforms[i]);
+            bones_uniform_ = shader_->GetUniform(combined_uniforms::finalBonesMatrices);
+            bones_revision_ = shader_->Revision();
         }
+        shader_->Set(bones_uniform_, transforms.data(), static_cast<GLsizei>(transforms.size()));
         model = glm::translate(model, glm::vec3(0.0f, -0.4f, 0.0f));
         model = glm::scale(model, model_scale_ * glm::vec3(1.0f, 1.0f, 1.0f));
 
-        shader_.SetMat4("model", model);
-        model_.Draw(shader_.id_);
+        shader_->Set(combined_uniforms::model, model);
+        model_->Draw(shader_->id_);
+        profiler.EndPass();
 
     }
 
@@ -213,7 +253,7 @@ namespace gpr5300
     void CombinedScene::UpdateCamera(const float dt)
     {
         // Get keyboard state
-        const Uint8* state = SDL_GetKeyboardState(NULL);
+        const Uint8* state = input_->GetKeyboardState();
 
         // Camera controls
         if (state[SDL_SCANCODE_W])
@@ -242,7 +282,7 @@ namespace gpr5300
         }
 
         int mouseX, mouseY;
-        const Uint32 mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
+        const Uint32 mouseState = input_->GetRelativeMouseState(&mouseX, &mouseY);
         if (mouseState & SDL_BUTTON(SDL_BUTTON_LEFT) && !ImGui::GetIO().WantCaptureMouse)
         {
             camera_->Update(mouseX, mouseY);
@@ -250,11 +290,15 @@ namespace gpr5300
     }
 }
 
+#ifdef GPR5300_SCENE_HOST
+static gpr5300::SceneRegistration registration("combined_scene", [] { return std::make_unique<gpr5300::CombinedScene>(); });
+#else
 int main(int argc, char* argv[])
 {
     gpr5300::CombinedScene scene;
-    gpr5300::Engine engine(&scene);
+    gpr5300::Engine engine(&scene, gpr5300::EngineSettings::FromArgs(argc, argv));
     engine.Run();
 
     return EXIT_SUCCESS;
 }
+#endif
@@ -2,6 +2,7 @@
 #include <imgui.h>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <sstream>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -10,14 +11,25 @@
 
 #include "engine.h"
 #include "file_utility.h"
+#include "frame_uniforms.h"
 #include "free_camera.h"
+#include "gl_state.h"
+#include "input.h"
 #include "model.h"
+#include "render_target_pool.h"
+#include "resource_cache.h"
 #include "scene.h"
+#include "scene_registry.h"
 #include "shader.h"
+#include "shaders/cubemap_reflection.h"
+#include "shaders/cubemap_skybox.h"
 #include "texture_loader.h"
 
 namespace gpr5300
 {
+    namespace reflection_uniforms = shaders::cubemap_reflection::uniforms;
+    namespace skybox_uniforms = shaders::cubemap_skybox::uniforms;
+
     class Cubemap final : public Scene
     {
     public:
@@ -29,9 +41,9 @@ namespace gpr5300
         void UpdateCamera(const float dt) override;
 
     private:
-        Shader shader_ = {};
+        std::shared_ptr<const Shader> shader_;
 
-        Shader skybox_shader_ = {};
+        std::shared_ptr<const Shader> skybox_shader_;
 
         GLuint cube_vao_ = 0;
         GLuint cube_vbo_ = 0;
@@ -42,9 +54,9 @@ namespace gpr5300
         GLuint skybox_vao_ = 0;
         GLuint skybox_vbo_ = 0;
 
-        unsigned int cubeTexture = -1;
-        unsigned int floorTexture = -1;
-        unsigned int skybox_texture_ = -1;
+        std::shared_ptr<const SharedTexture> cubeTexture;
+        std::shared_ptr<const SharedTexture> floorTexture;
+        std::shared_ptr<const SharedTexture> skybox_texture_;
 
         float elapsedTime_ = 0.0f;
 
@@ -52,24 +64,24 @@ namespace gpr5300
         float plane_vertices_[30] = {};
         float skybox_vertices_[108] = {};
 
-        FreeCamera* camera_ = nullptr;
+        std::unique_ptr<FreeCamera> camera_;
     };
 
     void Cubemap::Begin()
     {
-        camera_ = new FreeCamera();
+        camera_ = std::make_unique<FreeCamera>();
 
         //Main program
-        shader_ = Shader("data/shaders/cubemaps/reflection.vert", "data/shaders/cubemaps/reflection.frag");
-        skybox_shader_ = Shader("data/shaders/cubemaps/cubemaps.vert", "data/shaders/cubemaps/cubemaps.frag");
+        shader_ = resources_->LoadShader(shaders::cubemap_reflection::source);
+        skybox_shader_ = resources_->LoadShader(shaders::cubemap_skybox::source);
 
 
         // Configure global opengl state
         // -----------------------------
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LESS);
-        // glEnable(GL_CULL_FACE);
-        // glCullFace(GL_FRONT);
+        GlState::Enable(GL_DEPTH_TEST);
+        GlState::DepthFunc(GL_LESS);
+        // GlState::Enable(GL_CULL_FACE);
+        // GlState::CullFace(GL_FRONT);
 
         // set up vertex data (and buffer(s)) and configure vertex attributes
         // ------------------------------------------------------------------
@@ -195,7 +207,7 @@ namespace gpr5300
 
         // cube VAO
         glGenVertexArrays(1, &cube_vao_);
-        glBindVertexArray(cube_vao_);
+        GlState::BindVertexArray(cube_vao_);
 
         glGenBuffers(1, &cube_vbo_);
         glBindBuffer(GL_ARRAY_BUFFER, cube_vbo_);
@@ -208,7 +220,7 @@ namespace gpr5300
 
         // plane VAO
         glGenVertexArrays(1, &plane_vao_);
-        glBindVertexArray(plane_vao_);
+        GlState::BindVertexArray(plane_vao_);
 
         glGenBuffers(1, &plane_vbo_);
         glBindBuffer(GL_ARRAY_BUFFER, plane_vbo_);
@@ -221,7 +233,7 @@ namespace gpr5300
 
         //skybox VAO
         glGenVertexArrays(1, &skybox_vao_);
-        glBindVertexArray(skybox_vao_);
+        GlState::BindVertexArray(skybox_vao_);
 
         glGenBuffers(1, &skybox_vbo_);
         glBindBuffer(GL_ARRAY_BUFFER, skybox_vbo_);
@@ -242,18 +254,18 @@ namespace gpr5300
         };
         // load textures
         // -------------
-        cubeTexture = TextureFromFile("container.jpg", "data/textures");
-        floorTexture = TextureFromFile("marble.jpg", "data/textures");
-        skybox_texture_ = CubemapFromVec(faces);
+        cubeTexture = resources_->LoadTexture("container.jpg", "data/textures");
+        floorTexture = resources_->LoadTexture("marble.jpg", "data/textures");
+        skybox_texture_ = resources_->LoadCubemap(faces, job_system_);
 
 
         // shader configuration
         // --------------------
-        shader_.Use();
-        shader_.SetInt("skybox", 0);
+        shader_->Use();
+        shader_->Set(reflection_uniforms::skybox, 0);
 
-        skybox_shader_.Use();
-        skybox_shader_.SetInt("skybox", 0);
+        skybox_shader_->Use();
+        skybox_shader_->Set(skybox_uniforms::skybox, 0);
 
         // draw as wireframe
         //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -262,11 +274,18 @@ namespace gpr5300
     void Cubemap::End()
     {
         //Unload program/pipeline
-        shader_.Delete();
-        skybox_shader_.Delete();
-
-        glDeleteVertexArrays(1, &cube_vao_);
-        glDeleteVertexArrays(1, &plane_vao_);
+        shader_.reset();
+        skybox_shader_.reset();
+
+        GlState::DeleteVertexArrays(1, &cube_vao_);
+        GlState::DeleteVertexArrays(1, &plane_vao_);
+        GlState::DeleteVertexArrays(1, &skybox_vao_);
+        glDeleteBuffers(1, &cube_vbo_);
+        glDeleteBuffers(1, &plane_vbo_);
+        glDeleteBuffers(1, &skybox_vbo_);
+        cubeTexture.reset();
+        floorTexture.reset();
+        skybox_texture_.reset();
     }
 
     void Cubemap::Update(const float dt)
@@ -278,50 +297,46 @@ namespace gpr5300
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        shader_.Use();
+        shader_->Use();
 
         auto model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first
         auto view = camera_->view();
-        auto projection = glm::perspective(glm::radians(45.0f), (float)1280 / (float)720, 0.1f, 100.0f);
+        auto projection = glm::perspective(glm::radians(45.0f), render_targets_->AspectRatio(), 0.1f, 100.0f);
 
-        shader_.SetMat4("model", model);
-        shader_.SetMat4("view", view);
-        shader_.SetMat4("projection", projection);
-        shader_.SetVec3("cameraPos", camera_->camera_position_);
+        //One view block for the reflective cubes and the skybox
+        frame_uniforms_->SetView({view, projection, glm::vec4(camera_->camera_position_, 1.0f)});
+        shader_->Set(reflection_uniforms::model, model);
 
         //Cubes
-        glBindVertexArray(cube_vao_);
-        // glActiveTexture(GL_TEXTURE0);
-        // glBindTexture(GL_TEXTURE_2D, cubeTexture);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, skybox_texture_);
+        GlState::BindVertexArray(cube_vao_);
+        // GlState::ActiveTexture(GL_TEXTURE0);
+        // GlState::BindTexture(GL_TEXTURE_2D, cubeTexture->id);
+        GlState::BindTexture(GL_TEXTURE_CUBE_MAP, skybox_texture_->id);
         model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
-        shader_.SetMat4("model", model);
+        shader_->Set(reflection_uniforms::model, model);
         glDrawArrays(GL_TRIANGLES, 0, 36);
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
-        shader_.SetMat4("model", model);
+        shader_->Set(reflection_uniforms::model, model);
         glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
+        GlState::BindVertexArray(0);
         //Floor
-        // glBindVertexArray(plane_vao_);
-        // glBindTexture(GL_TEXTURE_2D, floorTexture);
+        // GlState::BindVertexArray(plane_vao_);
+        // GlState::BindTexture(GL_TEXTURE_2D, floorTexture->id);
         // model = glm::mat4(1.0f);
         // program_.SetMat4("model", model);
         // glDrawArrays(GL_TRIANGLES, 0, 6);
 
         //Draw skybox
-        glDepthFunc(GL_LEQUAL);
-        skybox_shader_.Use();
-        view = glm::mat4(glm::mat3(camera_->view()));
-        skybox_shader_.SetMat4("view", view);
-        skybox_shader_.SetMat4("projection", projection);
+        GlState::DepthFunc(GL_LEQUAL);
+        skybox_shader_->Use();
         //Skybox cube
-        glBindVertexArray(skybox_vao_);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, skybox_texture_);
+        GlState::BindVertexArray(skybox_vao_);
+        GlState::ActiveTexture(GL_TEXTURE0);
+        GlState::BindTexture(GL_TEXTURE_CUBE_MAP, skybox_texture_->id);
         glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
-        glDepthFunc(GL_LESS);
+        GlState::BindVertexArray(0);
+        GlState::DepthFunc(GL_LESS);
     }
 
     void Cubemap::OnEvent(const SDL_Event& event)
@@ -332,7 +347,7 @@ namespace gpr5300
     void Cubemap::UpdateCamera(const float dt)
     {
         // Get keyboard state
-        const Uint8* state = SDL_GetKeyboardState(NULL);
+        const Uint8* state = input_->GetKeyboardState();
 
         // Camera controls
         if (state[SDL_SCANCODE_W])
@@ -361,7 +376,7 @@ namespace gpr5300
         }
 
         int mouseX, mouseY;
-        const Uint32 mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
+        const Uint32 mouseState = input_->GetRelativeMouseState(&mouseX, &mouseY);
         if (mouseState & SDL_BUTTON(SDL_BUTTON_LEFT) && !ImGui::GetIO().WantCaptureMouse)
         {
             camera_->Update(mouseX, mouseY);
@@ -378,11 +393,15 @@ namespace gpr5300
     }
 }
 
+#ifdef GPR5300_SCENE_HOST
+static gpr5300::SceneRegistration registration("cubemap", [] { return std::make_unique<gpr5300::Cubemap>(); });
+#else
 int main(int argc, char* argv[])
 {
     gpr5300::Cubemap scene;
-    gpr5300::Engine engine(&scene);
+    gpr5300::Engine engine(&scene, gpr5300::EngineSettings::FromArgs(argc, argv));
     engine.Run();
 
     return EXIT_SUCCESS;
 }
+#endif
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <imgui.h>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -11,8 +12,13 @@
 #include "engine.h"
 #include "file_utility.h"
 #include "free_camera.h"
+#include "gl_state.h"
+#include "input.h"
 #include "model.h"
+#include "render_target_pool.h"
+#include "resource_cache.h"
 #include "scene.h"
+#include "scene_registry.h"
 #include "texture_loader.h"
 
 
@@ -38,8 +44,8 @@ namespace gpr5300
         GLuint cube_vbo_ = 0;
         GLuint plane_vao_ = 0;
         GLuint plane_vbo_ = 0;
-        unsigned int cubeTexture = -1;
-        unsigned int floorTexture = -1;
+        std::shared_ptr<const SharedTexture> cubeTexture;
+        std::shared_ptr<const SharedTexture> floorTexture;
 
         Model model_;
 
@@ -48,12 +54,12 @@ namespace gpr5300
         float cube_vertices_[180] = {};
         float plane_vertices_[30] = {};
 
-        FreeCamera* camera_ = nullptr;
+        std::unique_ptr<FreeCamera> camera_;
     };
 
     void DepthTesting::Begin()
     {
-        camera_ = new FreeCamera();
+        camera_ = std::make_unique<FreeCamera>();
 
         //Main program
 
@@ -122,10 +128,10 @@ namespace gpr5300
 
         // Configure global opengl state
         // -----------------------------
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LESS);
+        GlState::Enable(GL_DEPTH_TEST);
+        GlState::DepthFunc(GL_LESS);
 
-        glEnable(GL_STENCIL_TEST);
+        GlState::Enable(GL_STENCIL_TEST);
         glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
         glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
 
@@ -192,47 +198,53 @@ namespace gpr5300
     // cube VAO
     glGenVertexArrays(1, &cube_vao_);
     glGenBuffers(1, &cube_vbo_);
-    glBindVertexArray(cube_vao_);
+    GlState::BindVertexArray(cube_vao_);
     glBindBuffer(GL_ARRAY_BUFFER, cube_vbo_);
     glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices_), &cube_vertices_, GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glBindVertexArray(0);
+    GlState::BindVertexArray(0);
     // plane VAO
     glGenVertexArrays(1, &plane_vao_);
     glGenBuffers(1, &plane_vbo_);
-    glBindVertexArray(plane_vao_);
+    GlState::BindVertexArray(plane_vao_);
     glBindBuffer(GL_ARRAY_BUFFER, plane_vbo_);
     glBufferData(GL_ARRAY_BUFFER, sizeof(plane_vertices_), &plane_vertices_, GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glBindVertexArray(0);
+    GlState::BindVertexArray(0);
 
     // load textures
     // -------------
-    cubeTexture  = TextureFromFile("container2.png", "data/textures");
-    floorTexture = TextureFromFile("marble.jpg", "data/textures");
+    cubeTexture = resources_->LoadTexture("container2.png", "data/textures");
+    floorTexture = resources_->LoadTexture("marble.jpg", "data/textures");
 
     // shader configuration
     // --------------------
-    glUseProgram(program_);
+    GlState::UseProgram(program_);
     glUniform1i(glGetUniformLocation(program_, "texture1"), 0);
     }
 
     void DepthTesting::End()
     {
         //Unload program/pipeline
-        glDeleteProgram(program_);
+        GlState::DeleteProgram(program_);
+        GlState::DeleteProgram(outline_);
 
         glDeleteShader(vertexShader_);
         glDeleteShader(fragmentShader_);
-
-        glDeleteVertexArrays(1, &cube_vao_);
-        glDeleteVertexArrays(1, &plane_vao_);
+        glDeleteShader(outlineFragShader_);
+
+        GlState::DeleteVertexArrays(1, &cube_vao_);
+        GlState::DeleteVertexArrays(1, &plane_vao_);
+        glDeleteBuffers(1, &cube_vbo_);
+        glDeleteBuffers(1, &plane_vbo_);
+        cubeTexture.reset();
+        floorTexture.reset();
     }
 
     void DepthTesting::Update(const float dt)
@@ -244,12 +256,12 @@ namespace gpr5300
 
         auto model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first
         auto view = camera_->view();
-        auto projection = glm::perspective(glm::radians(45.0f), (float)1280 / (float)720, 0.1f, 100.0f);
-        glUseProgram(outline_);
+        auto projection = glm::perspective(glm::radians(45.0f), render_targets_->AspectRatio(), 0.1f, 100.0f);
+        GlState::UseProgram(outline_);
         glUniformMatrix4fv(glGetUniformLocation(outline_, "view"), 1, GL_FALSE, glm::value_ptr(view));
         glUniformMatrix4fv(glGetUniformLocation(outline_, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
 
-        glUseProgram(program_);
+        GlState::UseProgram(program_);
         glUniformMatrix4fv(glGetUniformLocation(program_, "view"), 1, GL_FALSE, glm::value_ptr(view));
         glUniformMatrix4fv(glGetUniformLocation(program_, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
 
@@ -258,19 +270,19 @@ namespace gpr5300
 
         // floor
         glStencilMask(0x00);
-        glBindVertexArray(plane_vao_);
-        glBindTexture(GL_TEXTURE_2D, floorTexture);
+        GlState::BindVertexArray(plane_vao_);
+        GlState::BindTexture(GL_TEXTURE_2D, floorTexture->id);
         model = glm::mat4(1.0f);
         glUniformMatrix4fv(glGetUniformLocation(program_, "model"), 1, GL_FALSE, glm::value_ptr(model));
         glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);
+        GlState::BindVertexArray(0);
 
         //Cubes 1st pass
         glStencilFunc(GL_ALWAYS, 1, 0xFF);
         glStencilMask(0xFF);
-        glBindVertexArray(cube_vao_);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, cubeTexture);
+        GlState::BindVertexArray(cube_vao_);
+        GlState::ActiveTexture(GL_TEXTURE0);
+        GlState::BindTexture(GL_TEXTURE_2D, cubeTexture->id);
         model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
         glUniformMatrix4fv(glGetUniformLocation(program_, "model"), 1, GL_FALSE, glm::value_ptr(model));
         glDrawArrays(GL_TRIANGLES, 0, 36);
@@ -282,11 +294,11 @@ namespace gpr5300
         //Cubes 2nd pass - outline
         glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
         glStencilMask(0x00);
-        glDisable(GL_DEPTH_TEST);
-        glUseProgram(outline_);
+        GlState::Disable(GL_DEPTH_TEST);
+        GlState::UseProgram(outline_);
         float scale = 1.1f;
-        glBindVertexArray(cube_vao_);
-        glBindTexture(GL_TEXTURE_2D, cubeTexture);
+        GlState::BindVertexArray(cube_vao_);
+        GlState::BindTexture(GL_TEXTURE_2D, cubeTexture->id);
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
         model = glm::scale(model, glm::vec3(scale, scale, scale));
@@ -300,8 +312,8 @@ namespace gpr5300
 
         glStencilMask(0xFF);
         glStencilFunc(GL_ALWAYS, 0, 0xFF);
-        glEnable(GL_DEPTH_TEST);
-        glBindVertexArray(0);
+        GlState::Enable(GL_DEPTH_TEST);
+        GlState::BindVertexArray(0);
     }
 
     void DepthTesting::OnEvent(const SDL_Event& event)
@@ -312,7 +324,7 @@ namespace gpr5300
     void DepthTesting::UpdateCamera(const float dt)
     {
         // Get keyboard state
-        const Uint8* state = SDL_GetKeyboardState(NULL);
+        const Uint8* state = input_->GetKeyboardState();
 
         // Camera controls
         if (state[SDL_SCANCODE_W])
@@ -341,7 +353,7 @@ namespace gpr5300
         }
 
         int mouseX, mouseY;
-        const Uint32 mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
+        const Uint32 mouseState = input_->GetRelativeMouseState(&mouseX, &mouseY);
         if (mouseState & SDL_BUTTON(SDL_BUTTON_LEFT) && !ImGui::GetIO().WantCaptureMouse)
         {
             camera_->Update(mouseX, mouseY);
@@ -358,12 +370,15 @@ namespace gpr5300
     }
 }
 
+#ifdef GPR5300_SCENE_HOST
+static gpr5300::SceneRegistration registration("depth_testing", [] { return std::make_unique<gpr5300::DepthTesting>(); });
+#else
 int main(int argc, char* argv[])
 {
     gpr5300::DepthTesting scene;
-    gpr5300::Engine engine(&scene);
+    gpr5300::Engine engine(&scene, gpr5300::EngineSettings::FromArgs(argc, argv));
     engine.Run();
 
     return EXIT_SUCCESS;
 }
-
+#endif
@@ -2,6 +2,7 @@
 #include <imgui.h>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <sstream>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -11,8 +12,13 @@
 #include "engine.h"
 #include "file_utility.h"
 #include "free_camera.h"
+#include "gl_state.h"
+#include "input.h"
 #include "model.h"
+#include "render_target_pool.h"
+#include "resource_cache.h"
 #include "scene.h"
+#include "scene_registry.h"
 #include "texture_loader.h"
 
 namespace gpr5300
@@ -38,20 +44,20 @@ namespace gpr5300
         GLuint plane_vao_ = 0;
         GLuint plane_vbo_ = 0;
 
-        unsigned int cubeTexture = -1;
-        unsigned int floorTexture = -1;
+        std::shared_ptr<const SharedTexture> cubeTexture;
+        std::shared_ptr<const SharedTexture> floorTexture;
 
         float elapsedTime_ = 0.0f;
 
         float cube_vertices_[180] = {};
         float plane_vertices_[30] = {};
 
-        FreeCamera* camera_ = nullptr;
+        std::unique_ptr<FreeCamera> camera_;
     };
 
     void FaceCulling::Begin()
     {
-        camera_ = new FreeCamera();
+        camera_ = std::make_unique<FreeCamera>();
 
         //Main program
 
@@ -96,10 +102,10 @@ namespace gpr5300
 
         // Configure global opengl state
         // -----------------------------
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LESS);
-        glEnable(GL_CULL_FACE);
-        // glCullFace(GL_FRONT);
+        GlState::Enable(GL_DEPTH_TEST);
+        GlState::DepthFunc(GL_LESS);
+        GlState::Enable(GL_CULL_FACE);
+        // GlState::CullFace(GL_FRONT);
 
         // set up vertex data (and buffer(s)) and configure vertex attributes
         // ------------------------------------------------------------------
@@ -175,7 +181,7 @@ namespace gpr5300
         // cube VAO
         glGenVertexArrays(1, &cube_vao_);
         glGenBuffers(1, &cube_vbo_);
-        glBindVertexArray(cube_vao_);
+        GlState::BindVertexArray(cube_vao_);
         glBindBuffer(GL_ARRAY_BUFFER, cube_vbo_);
         glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices_), &cube_vertices_, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
@@ -186,7 +192,7 @@ namespace gpr5300
         // plane VAO
         glGenVertexArrays(1, &plane_vao_);
         glGenBuffers(1, &plane_vbo_);
-        glBindVertexArray(plane_vao_);
+        GlState::BindVertexArray(plane_vao_);
         glBindBuffer(GL_ARRAY_BUFFER, plane_vbo_);
         glBufferData(GL_ARRAY_BUFFER, sizeof(plane_vertices_), &plane_vertices_, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
@@ -197,25 +203,29 @@ namespace gpr5300
 
         // load textures
         // -------------
-        cubeTexture = TextureFromFile("container2.png", "data/textures");
-        floorTexture = TextureFromFile("marble.jpg", "data/textures");
+        cubeTexture = resources_->LoadTexture("container2.png", "data/textures");
+        floorTexture = resources_->LoadTexture("marble.jpg", "data/textures");
 
         // shader configuration
         // --------------------
-        glUseProgram(program_);
+        GlState::UseProgram(program_);
         glUniform1i(glGetUniformLocation(program_, "texture1"), 0);
     }
 
     void FaceCulling::End()
     {
         //Unload program/pipeline
-        glDeleteProgram(program_);
+        GlState::DeleteProgram(program_);
 
         glDeleteShader(vertexShader_);
         glDeleteShader(fragmentShader_);
 
-        glDeleteVertexArrays(1, &cube_vao_);
-        glDeleteVertexArrays(1, &plane_vao_);
+        GlState::DeleteVertexArrays(1, &cube_vao_);
+        GlState::DeleteVertexArrays(1, &plane_vao_);
+        glDeleteBuffers(1, &cube_vbo_);
+        glDeleteBuffers(1, &plane_vbo_);
+        cubeTexture.reset();
+        floorTexture.reset();
     }
 
     void FaceCulling::Update(const float dt)
@@ -225,11 +235,11 @@ namespace gpr5300
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT); // also clear the depth buffer
 
-        glUseProgram(program_);
+        GlState::UseProgram(program_);
 
         auto model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first
         auto view = camera_->view();
-        auto projection = glm::perspective(glm::radians(45.0f), (float)1280 / (float)720, 0.1f, 100.0f);
+        auto projection = glm::perspective(glm::radians(45.0f), render_targets_->AspectRatio(), 0.1f, 100.0f);
 
         glUniformMatrix4fv(glGetUniformLocation(program_, "view"), 1, GL_FALSE, glm::value_ptr(view));
         glUniformMatrix4fv(glGetUniformLocation(program_, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
@@ -239,9 +249,9 @@ namespace gpr5300
 
         //DRAW OPAQUE OBJECTS FIRST
         //Cubes 1st pass
-        glBindVertexArray(cube_vao_);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, cubeTexture);
+        GlState::BindVertexArray(cube_vao_);
+        GlState::ActiveTexture(GL_TEXTURE0);
+        GlState::BindTexture(GL_TEXTURE_2D, cubeTexture->id);
         model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
         glUniformMatrix4fv(glGetUniformLocation(program_, "model"), 1, GL_FALSE, glm::value_ptr(model));
         glDrawArrays(GL_TRIANGLES, 0, 36);
@@ -251,14 +261,14 @@ namespace gpr5300
         glDrawArrays(GL_TRIANGLES, 0, 36);
 
         // floor
-        glBindVertexArray(plane_vao_);
-        glBindTexture(GL_TEXTURE_2D, floorTexture);
+        GlState::BindVertexArray(plane_vao_);
+        GlState::BindTexture(GL_TEXTURE_2D, floorTexture->id);
         model = glm::mat4(1.0f);
         glUniformMatrix4fv(glGetUniformLocation(program_, "model"), 1, GL_FALSE, glm::value_ptr(model));
         glDrawArrays(GL_TRIANGLES, 0, 6);
 
 
-        glBindVertexArray(0);
+        GlState::BindVertexArray(0);
     }
 
     void FaceCulling::OnEvent(const SDL_Event& event)
@@ -269,7 +279,7 @@ namespace gpr5300
     void FaceCulling::UpdateCamera(const float dt)
     {
         // Get keyboard state
-        const Uint8* state = SDL_GetKeyboardState(NULL);
+        const Uint8* state = input_->GetKeyboardState();
 
         // Camera controls
         if (state[SDL_SCANCODE_W])
@@ -298,7 +308,7 @@ namespace gpr5300
         }
 
         int mouseX, mouseY;
-        const Uint32 mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
+        const Uint32 mouseState = input_->GetRelativeMouseState(&mouseX, &mouseY);
         if (mouseState & SDL_BUTTON(SDL_BUTTON_LEFT) && !ImGui::GetIO().WantCaptureMouse)
         {
             camera_->Update(mouseX, mouseY);
@@ -315,11 +325,15 @@ namespace gpr5300
     }
 }
 
+#ifdef GPR5300_SCENE_HOST
+static gpr5300::SceneRegistration registration("face_culling", [] { return std::make_unique<gpr5300::FaceCulling>(); });
+#else
 int main(int argc, char* argv[])
 {
     gpr5300::FaceCulling scene;
-    gpr5300::Engine engine(&scene);
+    gpr5300::Engine engine(&scene, gpr5300::EngineSettings::FromArgs(argc, argv));
     engine.Run();
 
     return EXIT_SUCCESS;
 }
+#endif
@@ -2,6 +2,7 @@
 #include <imgui.h>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <sstream>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -11,8 +12,14 @@
 #include "engine.h"
 #include "file_utility.h"
 #include "free_camera.h"
+#include "gl_resources.h"
+#include "gl_state.h"
+#include "input.h"
 #include "model.h"
+#include "render_target_pool.h"
+#include "resource_cache.h"
 #include "scene.h"
+#include "scene_registry.h"
 #include "texture_loader.h"
 
 namespace gpr5300
@@ -28,6 +35,8 @@ namespace gpr5300
         void UpdateCamera(const float dt) override;
 
     private:
+        void AcquireTargets();
+
         GLuint program_ = 0;
         GLuint vertexShader_ = 0;
         GLuint fragmentShader_ = 0;
@@ -43,12 +52,15 @@ namespace gpr5300
         GLuint plane_vbo_ = 0;
 
         GLuint quad_vao_ = 0;
+        GLuint quad_vbo_ = 0;
 
         GLuint fbo_ = 0;
-        GLuint textureColourBuffer_ = 0;
+        RenderTarget textureColourBuffer_;
+        RenderTarget rbo_;
+        std::uint32_t targets_generation_ = 0;
 
-        unsigned int cubeTexture = -1;
-        unsigned int floorTexture = -1;
+        std::shared_ptr<const SharedTexture> cubeTexture;
+        std::shared_ptr<const SharedTexture> floorTexture;
 
         float elapsedTime_ = 0.0f;
 
@@ -56,12 +68,12 @@ namespace gpr5300
         float quad_vertices_[24] = {};
         float plane_vertices_[30] = {};
 
-        FreeCamera* camera_ = nullptr;
+        std::unique_ptr<FreeCamera> camera_;
     };
 
     void Framebuffers::Begin()
     {
-        camera_ = new FreeCamera();
+        camera_ = std::make_unique<FreeCamera>();
 
         //Main program
 
@@ -144,10 +156,10 @@ namespace gpr5300
 
         // Configure global opengl state
         // -----------------------------
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LESS);
-        glEnable(GL_CULL_FACE);
-        // glCullFace(GL_FRONT);
+        GlState::Enable(GL_DEPTH_TEST);
+        GlState::DepthFunc(GL_LESS);
+        GlState::Enable(GL_CULL_FACE);
+        // GlState::CullFace(GL_FRONT);
 
         // set up vertex data (and buffer(s)) and configure vertex attributes
         // ------------------------------------------------------------------
@@ -236,7 +248,7 @@ namespace gpr5300
         // cube VAO
         glGenVertexArrays(1, &cube_vao_);
         glGenBuffers(1, &cube_vbo_);
-        glBindVertexArray(cube_vao_);
+        GlState::BindVertexArray(cube_vao_);
         glBindBuffer(GL_ARRAY_BUFFER, cube_vbo_);
         glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices_), &cube_vertices_, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
@@ -247,7 +259,7 @@ namespace gpr5300
         // plane VAO
         glGenVertexArrays(1, &plane_vao_);
         glGenBuffers(1, &plane_vbo_);
-        glBindVertexArray(plane_vao_);
+        GlState::BindVertexArray(plane_vao_);
         glBindBuffer(GL_ARRAY_BUFFER, plane_vbo_);
         glBufferData(GL_ARRAY_BUFFER, sizeof(plane_vertices_), &plane_vertices_, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
@@ -257,9 +269,9 @@ namespace gpr5300
 
         //Quad VAO
         glGenVertexArrays(1, &quad_vao_);
-        glGenBuffers(1, &quad_vao_);
-        glBindVertexArray(quad_vao_);
-        glBindBuffer(GL_ARRAY_BUFFER, quad_vao_);
+        glGenBuffers(1, &quad_vbo_);
+        GlState::BindVertexArray(quad_vao_);
+        glBindBuffer(GL_ARRAY_BUFFER, quad_vbo_);
         glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertices_), &quad_vertices_, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
@@ -271,76 +283,85 @@ namespace gpr5300
         // The general rule is that if you never need to sample data from a specific buffer,
         // it is wise to use a renderbuffer object for that specific buffer.
         // If you need to sample data from a specific buffer like colors or depth values, you should use a texture attachment instead.
-        glGenFramebuffers(1, &fbo_);
-        glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
-
-        //Texture attachment (for colours)
-        glGenTextures(1, &textureColourBuffer_);
-        glBindTexture(GL_TEXTURE_2D, textureColourBuffer_);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1280, 720, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureColourBuffer_, 0);
-
-
-        //RBO attachment specifically designed for fbo, write only, often used as depth & stencil attachment to the FBO
-        unsigned int rbo;
-        glGenRenderbuffers(1, &rbo);
-        glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-        //Create depth & stencil renderbuffer object
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, 1280, 720);
-        glBindRenderbuffer(GL_RENDERBUFFER, 0);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
-
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        {
-            std::cerr << "Error: Framebuffer incomplete\n";
-        }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        fbo_ = GlResources::CreateFramebuffer();
+        AcquireTargets();
 
         // load textures
         // -------------
-        cubeTexture = TextureFromFile("container.jpg", "data/textures");
-        floorTexture = TextureFromFile("marble.jpg", "data/textures");
+        cubeTexture = resources_->LoadTexture("container.jpg", "data/textures");
+        floorTexture = resources_->LoadTexture("marble.jpg", "data/textures");
 
         // shader configuration
         // --------------------
-        glUseProgram(program_);
+        GlState::UseProgram(program_);
         glUniform1i(glGetUniformLocation(program_, "texture1"), 0);
 
         // draw as wireframe
         //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     }
 
+    void Framebuffers::AcquireTargets()
+    {
+        //The buffers of the previous size go back to the pool, which deletes them at the end of the frame
+        render_targets_->Release(textureColourBuffer_);
+        render_targets_->Release(rbo_);
+        targets_generation_ = render_targets_->Generation();
+
+        //Texture attachment (for colours)
+        textureColourBuffer_ = render_targets_->Acquire({.internal_format = GL_RGB8});
+        RenderTargetPool::Attach(fbo_, GL_COLOR_ATTACHMENT0, textureColourBuffer_);
+
+        //RBO attachment specifically designed for fbo, write only, often used as depth & stencil attachment to the FBO
+        rbo_ = render_targets_->Acquire({.internal_format = GL_DEPTH24_STENCIL8, .renderbuffer = true});
+        RenderTargetPool::Attach(fbo_, GL_DEPTH_STENCIL_ATTACHMENT, rbo_);
+
+        GlResources::CheckFramebuffer(fbo_, "framebuffers");
+    }
+
     void Framebuffers::End()
     {
+        render_targets_->Release(textureColourBuffer_);
+        render_targets_->Release(rbo_);
         //Unload program/pipeline
-        glDeleteProgram(program_);
+        GlState::DeleteProgram(program_);
+        GlState::DeleteProgram(screen_program_);
 
         glDeleteShader(vertexShader_);
         glDeleteShader(fragmentShader_);
-
-        glDeleteVertexArrays(1, &cube_vao_);
-        glDeleteVertexArrays(1, &plane_vao_);
-        glDeleteFramebuffers(1, &fbo_);
+        glDeleteShader(screen_vertexShader_);
+        glDeleteShader(screen_fragmentShader_);
+
+        GlState::DeleteVertexArrays(1, &cube_vao_);
+        GlState::DeleteVertexArrays(1, &plane_vao_);
+        GlState::DeleteVertexArrays(1, &quad_vao_);
+        glDeleteBuffers(1, &cube_vbo_);
+        glDeleteBuffers(1, &plane_vbo_);
+        glDeleteBuffers(1, &quad_vbo_);
+        GlState::DeleteFramebuffers(1, &fbo_);
+        cubeTexture.reset();
+        floorTexture.reset();
     }
 
     void Framebuffers::Update(const float dt)
     {
         UpdateCamera(dt);
         elapsedTime_ += dt;
+        if (targets_generation_ != render_targets_->Generation())
+        {
+            AcquireTargets();
+        }
 
         //First pass, in the fbo
-        glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
-        glEnable(GL_DEPTH_TEST);
+        GlState::BindFramebuffer(GL_FRAMEBUFFER, fbo_);
+        GlState::Enable(GL_DEPTH_TEST);
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glUseProgram(program_);
+        GlState::UseProgram(program_);
 
         auto model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first
         auto view = camera_->view();
-        auto projection = glm::perspective(glm::radians(45.0f), (float)1280 / (float)720, 0.1f, 100.0f);
+        auto projection = glm::perspective(glm::radians(45.0f), render_targets_->AspectRatio(), 0.1f, 100.0f);
 
         glUniformMatrix4fv(glGetUniformLocation(program_, "view"), 1, GL_FALSE, glm::value_ptr(view));
         glUniformMatrix4fv(glGetUniformLocation(program_, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
@@ -349,9 +370,9 @@ namespace gpr5300
         glUniform3f(glGetUniformLocation(program_, "viewPos"), view_pos.x, view_pos.y, view_pos.z);
 
         //Cubes
-        glBindVertexArray(cube_vao_);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, cubeTexture);
+        GlState::BindVertexArray(cube_vao_);
+        GlState::ActiveTexture(GL_TEXTURE0);
+        GlState::BindTexture(GL_TEXTURE_2D, cubeTexture->id);
         model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
         glUniformMatrix4fv(glGetUniformLocation(program_, "model"), 1, GL_FALSE, glm::value_ptr(model));
         glDrawArrays(GL_TRIANGLES, 0, 36);
@@ -360,25 +381,25 @@ namespace gpr5300
         glUniformMatrix4fv(glGetUniformLocation(program_, "model"), 1, GL_FALSE, glm::value_ptr(model));
         glDrawArrays(GL_TRIANGLES, 0, 36);
         //Floor
-        glBindVertexArray(plane_vao_);
-        glBindTexture(GL_TEXTURE_2D, floorTexture);
+        GlState::BindVertexArray(plane_vao_);
+        GlState::BindTexture(GL_TEXTURE_2D, floorTexture->id);
         model = glm::mat4(1.0f);
         glUniformMatrix4fv(glGetUniformLocation(program_, "model"), 1, GL_FALSE, glm::value_ptr(model));
         glDrawArrays(GL_TRIANGLES, 0, 6);
 
         //Second pass, out of the fbo
-        glBindFramebuffer(GL_FRAMEBUFFER, 0); //Default
-        glDisable(GL_DEPTH_TEST);
+        GlState::BindFramebuffer(GL_FRAMEBUFFER, 0); //Default
+        GlState::Disable(GL_DEPTH_TEST);
         glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        glUseProgram(screen_program_);
-        glBindVertexArray(quad_vao_);
-        glBindTexture(GL_TEXTURE_2D, textureColourBuffer_);
+        GlState::UseProgram(screen_program_);
+        GlState::BindVertexArray(quad_vao_);
+        GlState::BindTexture(GL_TEXTURE_2D, textureColourBuffer_.id);
         glDrawArrays(GL_TRIANGLES, 0, 6);
 
 
-        glBindVertexArray(0);
+        GlState::BindVertexArray(0);
     }
 
     void Framebuffers::OnEvent(const SDL_Event& event)
@@ -389,7 +410,7 @@ namespace gpr5300
     void Framebuffers::UpdateCamera(const float dt)
     {
         // Get keyboard state
-        const Uint8* state = SDL_GetKeyboardState(NULL);
+        const Uint8* state = input_->GetKeyboardState();
 
         // Camera controls
         if (state[SDL_SCANCODE_W])
@@ -418,7 +439,7 @@ namespace gpr5300
         }
 
         int mouseX, mouseY;
-        const Uint32 mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
+        const Uint32 mouseState = input_->GetRelativeMouseState(&mouseX, &mouseY);
         if (mouseState & SDL_BUTTON(SDL_BUTTON_LEFT) && !ImGui::GetIO().WantCaptureMouse)
         {
             camera_->Update(mouseX, mouseY);
@@ -435,12 +456,15 @@ namespace gpr5300
     }
 }
 
+#ifdef GPR5300_SCENE_HOST
+static gpr5300::SceneRegistration registration("framebuffers", [] { return std::make_unique<gpr5300::Framebuffers>(); });
+#else
 int main(int argc, char* argv[])
 {
     gpr5300::Framebuffers scene;
-    gpr5300::Engine engine(&scene);
+    gpr5300::Engine engine(&scene, gpr5300::EngineSettings::FromArgs(argc, argv));
     engine.Run();
 
     return EXIT_SUCCESS;
 }
-
+#endif
@@ -1,6 +1,7 @@
 ﻿#include <fstream>
 #include <imgui.h>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -10,14 +11,26 @@
 #include "engine.h"
 #include "file_utility.h"
 #include "free_camera.h"
+#include "gl_resources.h"
+#include "gl_state.h"
+#include "gpu_profiler.h"
 #include "global_utility.h"
+#include "input.h"
 #include "model.h"
+#include "render_target_pool.h"
+#include "resource_cache.h"
 #include "scene.h"
+#include "scene_registry.h"
 #include "shader.h"
+#include "shaders/hdr_lighting.h"
+#include "shaders/hdr_tone_map.h"
 #include "texture_loader.h"
 
 namespace gpr5300
 {
+    namespace lighting_uniforms = shaders::hdr_lighting::uniforms;
+    namespace tone_map_uniforms = shaders::hdr_tone_map::uniforms;
+
     class HDR final : public Scene
     {
     public:
@@ -29,21 +42,24 @@ namespace gpr5300
         void UpdateCamera(const float dt) override;
 
     private:
-        Shader lighting_shader_ = {};
-        Shader hdr_shader_ = {};
+        void AcquireTargets();
+
+        std::shared_ptr<const Shader> lighting_shader_;
+        std::shared_ptr<const Shader> hdr_shader_;
 
         GLuint hdr_fbo_ = 0;
-        GLuint color_buffer_ = 0;
-        GLuint rbo_depth_ = 0;
+        RenderTarget color_buffer_;
+        RenderTarget rbo_depth_;
+        std::uint32_t targets_generation_ = 0;
 
-        unsigned int wall_texture_ = 0;
+        std::shared_ptr<const SharedTexture> wall_texture_;
 
         float elapsedTime_ = 0.0f;
 
         std::vector<glm::vec3> light_positions_ = {};
         std::vector<glm::vec3> light_colors_ = {};
 
-        FreeCamera* camera_ = nullptr;
+        std::unique_ptr<FreeCamera> camera_;
 
         bool hdr_state_ = true;
         float exposure_ = 1.0f;
@@ -53,43 +69,22 @@ namespace gpr5300
     {
         // configure global opengl state
         // -----------------------------
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LESS);
-        // glEnable(GL_CULL_FACE);
-        // glCullFace(GL_FRONT);
+        GlState::Enable(GL_DEPTH_TEST);
+        GlState::DepthFunc(GL_LESS);
+        // GlState::Enable(GL_CULL_FACE);
+        // GlState::CullFace(GL_FRONT);
 
-        camera_ = new FreeCamera();
+        camera_ = std::make_unique<FreeCamera>();
 
-        wall_texture_ = TextureFromFile("brickwall.jpg", "data/textures");
+        wall_texture_ = resources_->LoadTexture("brickwall.jpg", "data/textures");
 
         //Main program(s)
-        lighting_shader_ = Shader("data/shaders/hdr/light.vert", "data/shaders/hdr/light.frag");
-        hdr_shader_ = Shader("data/shaders/hdr/hdr.vert", "data/shaders/hdr/hdr.frag");
+        lighting_shader_ = resources_->LoadShader(shaders::hdr_lighting::source);
+        hdr_shader_ = resources_->LoadShader(shaders::hdr_tone_map::source);
 
         //Configure FBO
-        glGenFramebuffers(1, &hdr_fbo_);
-
-        //Floating point color buffer
-        glGenTextures(1, &color_buffer_);
-        glBindTexture(GL_TEXTURE_2D, color_buffer_);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, 1280, 720, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        //Depth buffer (render buffer)
-        glGenRenderbuffers(1, &rbo_depth_);
-        glBindRenderbuffer(GL_RENDERBUFFER, rbo_depth_);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, 1280, 720);
-
-        //Attach buffers
-        glBindFramebuffer(GL_FRAMEBUFFER, hdr_fbo_);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color_buffer_, 0);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rbo_depth_);
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        {
-            std::cout << "Framebuffer not complete!" << std::endl;
-        }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        hdr_fbo_ = GlResources::CreateFramebuffer();
+        AcquireTargets();
 
         // lighting info
         // -------------
@@ -104,67 +99,99 @@ namespace gpr5300
         light_colors_.push_back(glm::vec3(0.0f, 0.0f, 0.2f));
         light_colors_.push_back(glm::vec3(0.0f, 0.1f, 0.0f));
 
-        lighting_shader_.Use();
-        lighting_shader_.SetInt("diffuseTexture", 0);
+        lighting_shader_->Use();
+        lighting_shader_->Set(lighting_uniforms::diffuseTexture, 0);
 
-        hdr_shader_.Use();
-        hdr_shader_.SetInt("hdrBuffer", 0);
+        hdr_shader_->Use();
+        hdr_shader_->Set(tone_map_uniforms::hdrBuffer, 0);
+    }
+
+    void HDR::AcquireTargets()
+    {
+        //The buffers of the previous size go back to the pool, which deletes them at the end of the frame
+        render_targets_->Release(color_buffer_);
+        render_targets_->Release(rbo_depth_);
+        targets_generation_ = render_targets_->Generation();
+
+        //Floating point color buffer
+        color_buffer_ = render_targets_->Acquire({.internal_format = GL_RGBA16F});
+        //Depth buffer (render buffer)
+        rbo_depth_ = render_targets_->Acquire({.internal_format = GL_DEPTH_COMPONENT24, .renderbuffer = true});
+
+        //Attach buffers
+        RenderTargetPool::Attach(hdr_fbo_, GL_COLOR_ATTACHMENT0, color_buffer_);
+        RenderTargetPool::Attach(hdr_fbo_, GL_DEPTH_ATTACHMENT, rbo_depth_);
+        GlResources::CheckFramebuffer(hdr_fbo_, "hdr");
     }
 
     void HDR::End()
     {
-        lighting_shader_.Delete();
-        hdr_shader_.Delete();
+        render_targets_->Release(color_buffer_);
+        render_targets_->Release(rbo_depth_);
+        GlState::DeleteFramebuffers(1, &hdr_fbo_);
+        lighting_shader_.reset();
+        hdr_shader_.reset();
+        wall_texture_.reset();
     }
 
     void HDR::Update(const float dt)
     {
         UpdateCamera(dt);
         elapsedTime_ += dt;
+        if (targets_generation_ != render_targets_->Generation())
+        {
+            AcquireTargets();
+        }
 
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        auto& profiler = GpuProfiler::Get();
+
         // 1. render scene into floating point framebuffer
         // -----------------------------------------------
-        glBindFramebuffer(GL_FRAMEBUFFER, hdr_fbo_);
+        profiler.BeginPass("HDR scene");
+        GlState::BindFramebuffer(GL_FRAMEBUFFER, hdr_fbo_);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        auto projection = glm::perspective(glm::radians(45.0f), (float)1280 / (float)720, 0.1f, 1000.0f);
+        auto projection = glm::perspective(glm::radians(45.0f), render_targets_->AspectRatio(), 0.1f, 1000.0f);
         auto view = camera_->view();
 
-        lighting_shader_.Use();
-        lighting_shader_.SetMat4("projection", projection);
-        lighting_shader_.SetMat4("view", view);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, wall_texture_);
+        lighting_shader_->Use();
+        lighting_shader_->Set(lighting_uniforms::projection, projection);
+        lighting_shader_->Set(lighting_uniforms::view, view);
+        GlState::ActiveTexture(GL_TEXTURE0);
+        GlState::BindTexture(GL_TEXTURE_2D, wall_texture_->id);
         // set lighting uniforms
         for (unsigned int i = 0; i < light_positions_.size(); i++)
         {
-            lighting_shader_.SetVec3("lights[" + std::to_string(i) + "].Position", light_positions_[i]);
-            lighting_shader_.SetVec3("lights[" + std::to_string(i) + "].Color", light_colors_[i]);
+            lighting_shader_->SetVec3("lights[" + std::to_string(i) + "].Position", light_positions_[i]);
+            lighting_shader_->SetVec3("lights[" + std::to_string(i) + "].Color", light_colors_[i]);
         }
-        lighting_shader_.SetVec3("viewPos", camera_->camera_position_);
+        lighting_shader_->Set(lighting_uniforms::viewPos, camera_->camera_position_);
         // render tunnel
         auto model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(0.0f, 0.0f, 25.0));
         model = glm::scale(model, glm::vec3(2.5f, 2.5f, 27.5f));
-        lighting_shader_.SetMat4("model", model);
-        lighting_shader_.SetInt("inverse_normals", true);
+        lighting_shader_->Set(lighting_uniforms::model, model);
+        lighting_shader_->Set(lighting_uniforms::inverse_normals, true);
         renderCube();
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        GlState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.EndPass();
 
         // 2. now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
         // --------------------------------------------------------------------------------------------------------------------------
+        profiler.BeginPass("Tonemap");
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        hdr_shader_.Use();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, color_buffer_);
-        hdr_shader_.SetInt("hdr", hdr_state_);
-        hdr_shader_.SetFloat("exposure", exposure_);
+        hdr_shader_->Use();
+        GlState::ActiveTexture(GL_TEXTURE0);
+        GlState::BindTexture(GL_TEXTURE_2D, color_buffer_.id);
+        hdr_shader_->Set(tone_map_uniforms::hdr, hdr_state_);
+        hdr_shader_->Set(tone_map_uniforms::exposure, exposure_);
         renderQuad();
+        profiler.EndPass();
 
-        glBindVertexArray(0);
+        GlState::BindVertexArray(0);
     }
 
     void HDR::OnEvent(const SDL_Event& event)
@@ -175,7 +202,7 @@ namespace gpr5300
     void HDR::UpdateCamera(const float dt)
     {
         // Get keyboard state
-        const Uint8* state = SDL_GetKeyboardState(NULL);
+        const Uint8* state = input_->GetKeyboardState();
 
         // Camera controls
         if (state[SDL_SCANCODE_W])
@@ -204,7 +231,7 @@ namespace gpr5300
         }
 
         int mouseX, mouseY;
-        const Uint32 mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
+        const Uint32 mouseState = input_->GetRelativeMouseState(&mouseX, &mouseY);
         if (mouseState & SDL_BUTTON(SDL_BUTTON_LEFT) && !ImGui::GetIO().WantCaptureMouse)
         {
             camera_->Update(mouseX, mouseY);
@@ -229,11 +256,15 @@ namespace gpr5300
 }
 
 
+#ifdef GPR5300_SCENE_HOST
+static gpr5300::SceneRegistration registration("hdr", [] { return std::make_unique<gpr5300::HDR>(); });
+#else
 int main(int argc, char* argv[])
 {
     gpr5300::HDR scene;
-    gpr5300::Engine engine(&scene);
+    gpr5300::Engine engine(&scene, gpr5300::EngineSettings::FromArgs(argc, argv));
     engine.Run();
 
     return EXIT_SUCCESS;
 }
+#endif
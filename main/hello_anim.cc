@@ -1,6 +1,7 @@
 ﻿#include <fstream>
 #include <imgui.h>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -12,26 +13,43 @@
 #include "engine.h"
 #include "file_utility.h"
 #include "free_camera.h"
+#include "gl_state.h"
+#include "input.h"
+#include "late_latch.h"
 #include "model_anim.h"
+#include "render_target_pool.h"
+#include "render_thread.h"
+#include "resource_cache.h"
 #include "scene.h"
+#include "scene_registry.h"
 #include "shader.h"
+#include "shaders/hello_anim.h"
 
 namespace gpr5300
 {
+    namespace anim_uniforms = shaders::hello_anim::uniforms;
+
     class HelloAnim final : public Scene
     {
     public:
         void Begin() override;
         void End() override;
         void Update(float dt) override;
+        bool SupportsFixedUpdate() const override { return true; }
+        void FixedUpdate(float fixed_dt) override;
+        void Render(float alpha) override;
+        bool SupportsRenderThread() const override { return true; }
+        bool SupportsLateLatch() const override { return true; }
         void OnEvent(const SDL_Event& event) override;
         void DrawImGui() override;
         void UpdateCamera(const float dt) override;
 
     private:
-        Shader shader_ = {};
+        std::shared_ptr<const Shader> shader_;
+        UniformHandle<glm::mat4> bones_uniform_;
+        unsigned int bones_revision_ = 0;
 
-        ModelAnim model_;
+        std::shared_ptr<ModelAnim> model_;
         Animation animation_ = {};
         Animator animator_ = {};
         float animation_speed_ = 1.0f;
@@ -40,65 +58,84 @@ namespace gpr5300
 
         float model_scale_ = 1;
 
-        FreeCamera* camera_ = nullptr;
+        std::unique_ptr<FreeCamera> camera_;
+        bool mouse_look_ = false;
     };
 
     void HelloAnim::Begin()
     {
-        camera_ = new FreeCamera();
+        camera_ = std::make_unique<FreeCamera>();
         // stbi_set_flip_vertically_on_load(true);
-        glEnable(GL_DEPTH_TEST);
+        GlState::Enable(GL_DEPTH_TEST);
 
-        shader_ = Shader("data/shaders/hello_anim/hello_anim.vert", "data/shaders/hello_anim/hello_anim.frag");
-        model_ = ModelAnim("data/Twist_Dance/Twist_Dance.dae");
-        animation_ = Animation("data/Twist_Dance/Twist_Dance.dae", &model_);
-        // model_ = ModelAnim("data/jirachi/Model.dae");
+        shader_ = resources_->LoadShader(shaders::hello_anim::source);
+        bones_uniform_ = shader_->GetUniform(anim_uniforms::finalBonesMatrices);
+        model_ = resources_->LoadModel<ModelAnim>("data/Twist_Dance/Twist_Dance.dae", job_system_);
+        animation_ = Animation("data/Twist_Dance/Twist_Dance.dae", model_.get());
+        // model_ = resources_->LoadModel<ModelAnim>("data/jirachi/Model.dae");
         animator_ = Animator(&animation_);
     }
 
     void HelloAnim::End()
     {
         //Unload program/pipeline
-        shader_.Delete();
+        shader_.reset();
+        model_.reset();
     }
 
     void HelloAnim::Update(const float dt)
     {
-        UpdateCamera(dt);
-        elapsedTime_ += dt;
-
-
-        animator_.UpdateAnimation(animation_speed_ * dt);
+        FixedUpdate(dt);
+        Render(1.0f);
+    }
 
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // also clear the depth buffer
+    void HelloAnim::FixedUpdate(const float fixed_dt)
+    {
+        camera_->StorePreviousState();
+        UpdateCamera(fixed_dt);
+        elapsedTime_ += fixed_dt;
 
-        shader_.Use();
+        animator_.UpdateAnimation(animation_speed_ * fixed_dt, job_system_);
+    }
 
+    void HelloAnim::Render(const float alpha)
+    {
         // Create transformations
-        auto projection = glm::perspective(glm::radians(45.0f), (float)1280 / (float)720, 0.1f, 10000.0f);
-        auto view = camera_->view();
-
-        shader_.SetMat4("projection", projection);
-        shader_.SetMat4("view", view);
-
-        const glm::vec3 view_pos = camera_->camera_position_;
-        shader_.SetVec3("viewPos", glm::vec3(view_pos.x, view_pos.y, view_pos.z));
-
+        auto projection = glm::perspective(glm::radians(45.0f), render_targets_->AspectRatio(), 0.1f, 10000.0f);
+        //The latch starts from the interpolated camera and adds the mouse motion of the meantime on top
+        FreeCamera camera = *camera_;
+        camera.view_ = camera_->InterpolatedView(alpha);
+        camera.camera_position_ = camera_->InterpolatedPosition(alpha);
         auto transforms = animator_.GetFinalBoneMatrices();
-        for (int i = 0; i < transforms.size(); ++i)
-        {
-            shader_.SetMat4("finalBonesMatrices[" + std::to_string(i) + "]", transforms[i]);
-        }
 
-        //Draw model
         auto model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(0.0f, -0.4f, 0.0f));
         model = glm::scale(model, model_scale_ * glm::vec3(1.0f, 1.0f, 1.0f));
 
-        shader_.SetMat4("model", model);
-        model_.Draw(shader_.id_);
+        //Everything the draw needs is captured by value, the simulation moves on to the next frame meanwhile
+        render_thread_->Enqueue([this, projection, camera, mouse_look = mouse_look_,
+                                    transforms = std::move(transforms), model]
+        {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // also clear the depth buffer
+
+            late_latch_->Latch(camera, projection, mouse_look);
+
+            shader_->Use();
+
+            //A hot reload may have moved the uniform
+            if (bones_revision_ != shader_->Revision())
+            {
+                bones_uniform_ = shader_->GetUniform(anim_uniforms::finalBonesMatrices);
+                bones_revision_ = shader_->Revision();
+            }
+            shader_->Set(bones_uniform_, transforms.data(), static_cast<GLsizei>(transforms.size()));
+
+            //Draw model
+            shader_->Set(anim_uniforms::model, model);
+            model_->Draw(shader_->id_);
 
-        glBindVertexArray(0);
+            GlState::BindVertexArray(0);
+        });
     }
 
     void HelloAnim::OnEvent(const SDL_Event& event)
@@ -120,7 +157,7 @@ namespace gpr5300
     void HelloAnim::UpdateCamera(const float dt)
     {
         // Get keyboard state
-        const Uint8* state = SDL_GetKeyboardState(NULL);
+        const Uint8* state = input_->GetKeyboardState();
 
         // Camera controls
         if (state[SDL_SCANCODE_W])
@@ -149,8 +186,9 @@ namespace gpr5300
         }
 
         int mouseX, mouseY;
-        const Uint32 mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
-        if (mouseState & SDL_BUTTON(SDL_BUTTON_LEFT) && !ImGui::GetIO().WantCaptureMouse)
+        const Uint32 mouseState = input_->GetRelativeMouseState(&mouseX, &mouseY);
+        mouse_look_ = mouseState & SDL_BUTTON(SDL_BUTTON_LEFT) && !ImGui::GetIO().WantCaptureMouse;
+        if (mouse_look_)
         {
             camera_->Update(mouseX, mouseY);
         }
@@ -167,11 +205,15 @@ namespace gpr5300
     }
 }
 
+#ifdef GPR5300_SCENE_HOST
+static gpr5300::SceneRegistration registration("hello_anim", [] { return std::make_unique<gpr5300::HelloAnim>(); });
+#else
 int main(int argc, char* argv[])
 {
     gpr5300::HelloAnim scene;
-    gpr5300::Engine engine(&scene);
+    gpr5300::Engine engine(&scene, gpr5300::EngineSettings::FromArgs(argc, argv));
     engine.Run();
 
     return EXIT_SUCCESS;
 }
+#endif
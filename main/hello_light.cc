@@ -1,6 +1,7 @@
 ﻿#include <fstream>
 #include <imgui.h>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -10,7 +11,11 @@
 #include "engine.h"
 #include "file_utility.h"
 #include "free_camera.h"
+#include "gl_state.h"
+#include "input.h"
+#include "render_target_pool.h"
 #include "scene.h"
+#include "scene_registry.h"
 #include "texture_loader.h"
 
 namespace gpr5300
@@ -46,12 +51,12 @@ namespace gpr5300
         glm::vec3 light_position_ = glm::vec3(1.2f, 1.0f, 2.0f);
         glm::vec3 light_colour_ = glm::vec3(1.0f, 1.0f, 1.0f);
 
-        FreeCamera* camera_ = nullptr;
+        std::unique_ptr<FreeCamera> camera_;
     };
 
     void HelloLight::Begin()
     {
-        camera_ = new FreeCamera();
+        camera_ = std::make_unique<FreeCamera>();
         TextureManager texture_manager;
         diffuse_map_ = texture_manager.CreateTexture("data/textures/container2.png");
         specular_map_ = texture_manager.CreateTexture("data/textures/container2_specular.png");
@@ -136,7 +141,7 @@ namespace gpr5300
 
         // configure global opengl state
         // -----------------------------
-        glEnable(GL_DEPTH_TEST);
+        GlState::Enable(GL_DEPTH_TEST);
 
         float vertices[] = {
             // positions          // normals           // texture coords
@@ -211,7 +216,7 @@ namespace gpr5300
         glGenBuffers(1, &ebo_);
 
         // Bind VAO
-        glBindVertexArray(vao_);
+        GlState::BindVertexArray(vao_);
 
 
         // Bind and set VBO
@@ -237,29 +242,32 @@ namespace gpr5300
 
         // Light
         glGenVertexArrays(1, &light_vao_);
-        glBindVertexArray(light_vao_);
+        GlState::BindVertexArray(light_vao_);
 
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(0);
 
         // Unbind VAO (optional)
-        glBindVertexArray(0);
+        GlState::BindVertexArray(0);
     }
 
     void HelloLight::End()
     {
         //Unload program/pipeline
-        glDeleteProgram(program_);
-        glDeleteProgram(light_program_);
+        GlState::DeleteProgram(program_);
+        GlState::DeleteProgram(light_program_);
 
         glDeleteShader(vertexShader_);
         glDeleteShader(fragmentShader_);
         glDeleteShader(light_vertexShader_);
         glDeleteShader(light_fragmentShader_);
 
-        glDeleteVertexArrays(1, &vao_);
-        glDeleteVertexArrays(1, &light_vao_);
+        GlState::DeleteVertexArrays(1, &vao_);
+        GlState::DeleteVertexArrays(1, &light_vao_);
+        glDeleteBuffers(1, &vbo_);
         glDeleteBuffers(1, &ebo_);
+        GlState::DeleteTextures(1, &diffuse_map_);
+        GlState::DeleteTextures(1, &specular_map_);
     }
 
     void HelloLight::Update(const float dt)
@@ -269,10 +277,10 @@ namespace gpr5300
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // also clear the depth buffer now!
 
-        glUseProgram(program_);
+        GlState::UseProgram(program_);
 
         // Create transformations
-        auto projection = glm::perspective(glm::radians(45.0f), (float)1280 / (float)720, 0.1f, 100.0f);
+        auto projection = glm::perspective(glm::radians(45.0f), render_targets_->AspectRatio(), 0.1f, 100.0f);
         auto view = camera_->view();
         auto model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first
 
@@ -355,15 +363,15 @@ namespace gpr5300
 
         //Bind texture maps
         glUniform1i(glGetUniformLocation(program_, "material.diffuse"), 0);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, diffuse_map_);
+        GlState::ActiveTexture(GL_TEXTURE0);
+        GlState::BindTexture(GL_TEXTURE_2D, diffuse_map_);
 
         glUniform1i(glGetUniformLocation(program_, "material.specular"), 1);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, specular_map_);
+        GlState::ActiveTexture(GL_TEXTURE1);
+        GlState::BindTexture(GL_TEXTURE_2D, specular_map_);
 
         //Draw cubes
-        glBindVertexArray(vao_);
+        GlState::BindVertexArray(vao_);
         for (unsigned int i = 0; i < 10; i++)
         {
             // calculate the model matrix for each object and pass it to shader before drawing
@@ -380,7 +388,7 @@ namespace gpr5300
 
         // //TODO: check why putting this after the cubes make them not appear
         //Draw the lamp object
-        glUseProgram(light_program_);
+        GlState::UseProgram(light_program_);
 
         glUniformMatrix4fv(glGetUniformLocation(light_program_, "light_view"), 1, GL_FALSE, glm::value_ptr(view));
         glUniformMatrix4fv(glGetUniformLocation(light_program_, "light_projection"), 1, GL_FALSE,
@@ -388,7 +396,7 @@ namespace gpr5300
         glUniform3f(glGetUniformLocation(light_program_, "lightColour"), light_colour_.r, light_colour_.g,
                     light_colour_.b);
 
-        glBindVertexArray(light_vao_);
+        GlState::BindVertexArray(light_vao_);
         for (auto pointLightPosition : pointLightPositions)
         {
             auto light_model = glm::mat4(1.0f);
@@ -400,7 +408,7 @@ namespace gpr5300
 
             glDrawArrays(GL_TRIANGLES, 0, 36);
         }
-        glBindVertexArray(0);
+        GlState::BindVertexArray(0);
     }
 
     void HelloLight::OnEvent(const SDL_Event& event)
@@ -411,7 +419,7 @@ namespace gpr5300
     void HelloLight::UpdateCamera(const float dt)
     {
         // Get keyboard state
-        const Uint8* state = SDL_GetKeyboardState(NULL);
+        const Uint8* state = input_->GetKeyboardState();
 
         // Camera controls
         if (state[SDL_SCANCODE_W])
@@ -440,7 +448,7 @@ namespace gpr5300
         }
 
         int mouseX, mouseY;
-        const Uint32 mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
+        const Uint32 mouseState = input_->GetRelativeMouseState(&mouseX, &mouseY);
         if (mouseState & SDL_BUTTON(SDL_BUTTON_LEFT) && !ImGui::GetIO().WantCaptureMouse)
         {
             camera_->Update(mouseX, mouseY);
@@ -458,11 +466,15 @@ namespace gpr5300
     }
 }
 
+#ifdef GPR5300_SCENE_HOST
+static gpr5300::SceneRegistration registration("hello_light", [] { return std::make_unique<gpr5300::HelloLight>(); });
+#else
 int main(int argc, char* argv[])
 {
     gpr5300::HelloLight scene;
-    gpr5300::Engine engine(&scene);
+    gpr5300::Engine engine(&scene, gpr5300::EngineSettings::FromArgs(argc, argv));
     engine.Run();
 
     return EXIT_SUCCESS;
 }
+#endif
@@ -1,6 +1,7 @@
 ﻿#include <fstream>
 #include <imgui.h>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -10,8 +11,12 @@
 #include "engine.h"
 #include "file_utility.h"
 #include "free_camera.h"
+#include "gl_state.h"
+#include "input.h"
 #include "model.h"
+#include "render_target_pool.h"
 #include "scene.h"
+#include "scene_registry.h"
 #include "texture_loader.h"
 
 namespace gpr5300
@@ -52,18 +57,18 @@ namespace gpr5300
 
         float model_scale_ = 1;
 
-        FreeCamera* camera_ = nullptr;
+        std::unique_ptr<FreeCamera> camera_;
     };
 
     void HelloModel::Begin()
     {
-        camera_ = new FreeCamera();
+        camera_ = std::make_unique<FreeCamera>();
         // TODO: find why this broke everything with the fbx
         stbi_set_flip_vertically_on_load(true);
 
         // model_ = Model("data/backpack/backpack.obj");
         // model_ = Model("data/pickle_fbx/Pickle_uishdjrva_Mid.fbx");
-        model_ = Model("data/pickle_gltf/Pickle_uishdjrva_Mid.gltf");
+        model_ = Model("data/pickle_gltf/Pickle_uishdjrva_Mid.gltf", job_system_);
         // model_ = Model("data/pickle_gltf_ue/uishdjrva_tier_2.gltf");
         // model_ = Model("data/matilda/source/sketchfab_v002.fbx");
         // model_ = Model("data/Alduin/Alduin.obj");
@@ -155,7 +160,7 @@ namespace gpr5300
 
         // configure global opengl state
         // -----------------------------
-        glEnable(GL_DEPTH_TEST);
+        GlState::Enable(GL_DEPTH_TEST);
 
         float vertices[] = {
             // positions          // normals           // texture coords
@@ -230,7 +235,7 @@ namespace gpr5300
         glGenBuffers(1, &ebo_);
 
         // Bind VAO
-        glBindVertexArray(vao_);
+        GlState::BindVertexArray(vao_);
 
 
         // Bind and set VBO
@@ -256,29 +261,31 @@ namespace gpr5300
 
         // Light
         glGenVertexArrays(1, &light_vao_);
-        glBindVertexArray(light_vao_);
+        GlState::BindVertexArray(light_vao_);
 
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(0);
 
         // Unbind VAO (optional)
-        glBindVertexArray(0);
+        GlState::BindVertexArray(0);
     }
 
     void HelloModel::End()
     {
         //Unload program/pipeline
-        glDeleteProgram(program_);
-        glDeleteProgram(light_program_);
+        GlState::DeleteProgram(program_);
+        GlState::DeleteProgram(light_program_);
 
         glDeleteShader(vertexShader_);
         glDeleteShader(fragmentShader_);
         glDeleteShader(light_vertexShader_);
         glDeleteShader(light_fragmentShader_);
 
-        glDeleteVertexArrays(1, &vao_);
-        glDeleteVertexArrays(1, &light_vao_);
+        GlState::DeleteVertexArrays(1, &vao_);
+        GlState::DeleteVertexArrays(1, &light_vao_);
+        glDeleteBuffers(1, &vbo_);
         glDeleteBuffers(1, &ebo_);
+        model_ = Model();
     }
 
     void HelloModel::Update(const float dt)
@@ -288,10 +295,10 @@ namespace gpr5300
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // also clear the depth buffer
 
-        glUseProgram(program_);
+        GlState::UseProgram(program_);
 
         // Create transformations
-        auto projection = glm::perspective(glm::radians(45.0f), (float)1280 / (float)720, 0.1f, 100.0f);
+        auto projection = glm::perspective(glm::radians(45.0f), render_targets_->AspectRatio(), 0.1f, 100.0f);
         auto view = camera_->view();
         auto model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first
 
@@ -373,11 +380,11 @@ namespace gpr5300
         glUniform1f(glGetUniformLocation(program_, "material.shininess"), 32.0f);
 
 
-        glBindVertexArray(vao_);
+        GlState::BindVertexArray(vao_);
         //Draw model
         glUniform1i(glGetUniformLocation(program_, "material.diffuse"), 0);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, diffuse_map_);
+        GlState::ActiveTexture(GL_TEXTURE0);
+        GlState::BindTexture(GL_TEXTURE_2D, diffuse_map_);
         model = glm::translate(model, glm::vec3(1.0f, 0.0f, 0.0f));
         // model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
         // translate it down so it's at the center of the scene
@@ -388,15 +395,15 @@ namespace gpr5300
 
         //Bind texture maps
         glUniform1i(glGetUniformLocation(program_, "material.diffuse"), 1);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, diffuse_map_);
+        GlState::ActiveTexture(GL_TEXTURE1);
+        GlState::BindTexture(GL_TEXTURE_2D, diffuse_map_);
 
         glUniform1i(glGetUniformLocation(program_, "material.specular"), 2);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, specular_map_);
+        GlState::ActiveTexture(GL_TEXTURE2);
+        GlState::BindTexture(GL_TEXTURE_2D, specular_map_);
 
 
-        glBindVertexArray(vao_);
+        GlState::BindVertexArray(vao_);
         //Draw cubes
          for (unsigned int i = 0; i < 10; i++)
          {
@@ -413,7 +420,7 @@ namespace gpr5300
 
 
         //Draw the lamp objects
-        glUseProgram(light_program_);
+        GlState::UseProgram(light_program_);
 
         glUniformMatrix4fv(glGetUniformLocation(light_program_, "light_view"), 1, GL_FALSE, glm::value_ptr(view));
         glUniformMatrix4fv(glGetUniformLocation(light_program_, "light_projection"), 1, GL_FALSE,
@@ -421,7 +428,7 @@ namespace gpr5300
         glUniform3f(glGetUniformLocation(light_program_, "lightColour"), light_colour_.r, light_colour_.g,
                     light_colour_.b);
 
-        glBindVertexArray(light_vao_);
+        GlState::BindVertexArray(light_vao_);
         for (unsigned int i = 0; i < 4; i++)
         {
             glm::mat4 light_model = glm::mat4(1.0f);
@@ -434,7 +441,7 @@ namespace gpr5300
             glDrawArrays(GL_TRIANGLES, 0, 36);
         }
 
-        glBindVertexArray(0);
+        GlState::BindVertexArray(0);
     }
 
     void HelloModel::OnEvent(const SDL_Event& event)
@@ -456,7 +463,7 @@ namespace gpr5300
     void HelloModel::UpdateCamera(const float dt)
     {
         // Get keyboard state
-        const Uint8* state = SDL_GetKeyboardState(NULL);
+        const Uint8* state = input_->GetKeyboardState();
 
         // Camera controls
         if (state[SDL_SCANCODE_W])
@@ -485,7 +492,7 @@ namespace gpr5300
         }
 
         int mouseX, mouseY;
-        const Uint32 mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
+        const Uint32 mouseState = input_->GetRelativeMouseState(&mouseX, &mouseY);
         if (mouseState & SDL_BUTTON(SDL_BUTTON_LEFT) && !ImGui::GetIO().WantCaptureMouse)
         {
             camera_->Update(mouseX, mouseY);
@@ -503,11 +510,15 @@ namespace gpr5300
     }
 }
 
+#ifdef GPR5300_SCENE_HOST
+static gpr5300::SceneRegistration registration("hello_model", [] { return std::make_unique<gpr5300::HelloModel>(); });
+#else
 int main(int argc, char* argv[])
 {
     gpr5300::HelloModel scene;
-    gpr5300::Engine engine(&scene);
+    gpr5300::Engine engine(&scene, gpr5300::EngineSettings::FromArgs(argc, argv));
     engine.Run();
 
     return EXIT_SUCCESS;
 }
+#endif
@@ -1,6 +1,7 @@
 ﻿#include <fstream>
 #include <imgui.h>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -10,13 +11,23 @@
 #include "engine.h"
 #include "file_utility.h"
 #include "free_camera.h"
+#include "gl_state.h"
+#include "indirect_renderer.h"
+#include "input.h"
 #include "model.h"
+#include "render_target_pool.h"
+#include "resource_cache.h"
 #include "scene.h"
+#include "scene_registry.h"
 #include "shader.h"
+#include "shaders/model.h"
+#include "shaders/model_indirect.h"
 #include "texture_loader.h"
 
 namespace gpr5300
 {
+    namespace model_uniforms = shaders::model::uniforms;
+
     class HelloModelClean final : public Scene
     {
     public:
@@ -28,31 +39,45 @@ namespace gpr5300
         void UpdateCamera(const float dt) override;
 
     private:
-        Shader shader_ = {};
+        std::shared_ptr<const Shader> shader_;
 
-        Model model_;
+        std::shared_ptr<Model> model_;
+        //Meshes drawn with glMultiDrawElementsIndirect when the driver has gl_DrawIDARB, one by one otherwise
+        IndirectRenderer indirect_renderer_;
+        bool indirect_ = false;
 
         float elapsedTime_ = 0.0f;
 
         float model_scale_ = 1;
 
-        FreeCamera* camera_ = nullptr;
+        std::unique_ptr<FreeCamera> camera_;
     };
 
     void HelloModelClean::Begin()
     {
-        camera_ = new FreeCamera();
+        camera_ = std::make_unique<FreeCamera>();
         // stbi_set_flip_vertically_on_load(true);
-        glEnable(GL_DEPTH_TEST);
+        GlState::Enable(GL_DEPTH_TEST);
 
-        shader_ = Shader("data/shaders/model/model.vert", "data/shaders/model/model.frag");
-        model_ = Model("data/pickle_gltf/Pickle_uishdjrva_Mid.gltf");
+        indirect_ = IndirectRenderer::Supported();
+        if (indirect_)
+        {
+            indirect_renderer_.Create();
+            shader_ = resources_->LoadShader(shaders::model_indirect::source);
+        }
+        else
+        {
+            shader_ = resources_->LoadShader(shaders::model::source);
+        }
+        model_ = resources_->LoadModel<Model>("data/pickle_gltf/Pickle_uishdjrva_Mid.gltf", job_system_);
     }
 
     void HelloModelClean::End()
     {
         //Unload program/pipeline
-        shader_.Delete();
+        shader_.reset();
+        model_.reset();
+        indirect_renderer_.Destroy();
     }
 
     void HelloModelClean::Update(const float dt)
@@ -62,27 +87,33 @@ namespace gpr5300
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // also clear the depth buffer
 
-        shader_.Use();
+        shader_->Use();
 
         // Create transformations
-        auto projection = glm::perspective(glm::radians(45.0f), (float)1280 / (float)720, 0.1f, 10000.0f);
+        auto projection = glm::perspective(glm::radians(45.0f), render_targets_->AspectRatio(), 0.1f, 10000.0f);
         auto view = camera_->view();
 
-        shader_.SetMat4("projection", projection);
-        shader_.SetMat4("view", view);
-
-        const glm::vec3 view_pos = camera_->camera_position_;
-        shader_.SetVec3("viewPos", view_pos);
+        //Both programs declare them
+        shader_->Set(model_uniforms::projection, projection);
+        shader_->Set(model_uniforms::view, view);
 
         //Draw model
         auto model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(1.0f, 0.0f, 0.0f));
         model = glm::scale(model, model_scale_ * glm::vec3(1.0f, 1.0f, 1.0f));
 
-        shader_.SetMat4("model", model);
-        model_.Draw(shader_.id_);
+        if (indirect_)
+        {
+            model_->Draw(indirect_renderer_, model);
+            indirect_renderer_.Submit(shader_->id_);
+        }
+        else
+        {
+            shader_->Set(model_uniforms::model, model);
+            model_->Draw(shader_->id_);
+        }
 
-        glBindVertexArray(0);
+        GlState::BindVertexArray(0);
     }
 
     void HelloModelClean::OnEvent(const SDL_Event& event)
@@ -104,7 +135,7 @@ namespace gpr5300
     void HelloModelClean::UpdateCamera(const float dt)
     {
         // Get keyboard state
-        const Uint8* state = SDL_GetKeyboardState(NULL);
+        const Uint8* state = input_->GetKeyboardState();
 
         // Camera controls
         if (state[SDL_SCANCODE_W])
@@ -133,7 +164,7 @@ namespace gpr5300
         }
 
         int mouseX, mouseY;
-        const Uint32 mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
+        const Uint32 mouseState = input_->GetRelativeMouseState(&mouseX, &mouseY);
         if (mouseState & SDL_BUTTON(SDL_BUTTON_LEFT) && !ImGui::GetIO().WantCaptureMouse)
         {
             camera_->Update(mouseX, mouseY);
@@ -145,16 +176,25 @@ namespace gpr5300
         ImGui::Begin("My Window"); // Start a new window
         //ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
         ImGui::SliderFloat("Model Size", &model_scale_, 0.01f, 1.0f, "%.1f");
+        if (indirect_)
+        {
+            ImGui::Text("Indirect: %zu meshes in %zu draw calls", indirect_renderer_.DrawCount(),
+                        indirect_renderer_.CallCount());
+        }
         static ImVec4 LightColour = ImVec4(1.0f, 1.0f, 1.0f, 1.0f); // Default color
         ImGui::End(); // End the window
     }
 }
 
+#ifdef GPR5300_SCENE_HOST
+static gpr5300::SceneRegistration registration("hello_model_nolight", [] { return std::make_unique<gpr5300::HelloModelClean>(); });
+#else
 int main(int argc, char* argv[])
 {
     gpr5300::HelloModelClean scene;
-    gpr5300::Engine engine(&scene);
+    gpr5300::Engine engine(&scene, gpr5300::EngineSettings::FromArgs(argc, argv));
     engine.Run();
 
     return EXIT_SUCCESS;
 }
+#endif
@@ -1,6 +1,7 @@
 #include <fstream>
 #include <imgui.h>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -10,7 +11,11 @@
 #include "engine.h"
 #include "file_utility.h"
 #include "free_camera.h"
+#include "gl_state.h"
+#include "input.h"
+#include "render_target_pool.h"
 #include "scene.h"
+#include "scene_registry.h"
 #include "texture_loader.h"
 
 namespace gpr5300
@@ -38,12 +43,12 @@ namespace gpr5300
 
         glm::vec3 cubePositions[10] = {};
 
-        FreeCamera* camera_ = nullptr;
+        std::unique_ptr<FreeCamera> camera_;
     };
 
     void HelloTriangle::Begin()
     {
-        camera_ = new FreeCamera();
+        camera_ = std::make_unique<FreeCamera>();
         TextureManager texture_manager;
         texture_ = texture_manager.CreateTexture("data/textures/container.jpg");
 
@@ -87,7 +92,7 @@ namespace gpr5300
 
         // configure global opengl state
         // -----------------------------
-        glEnable(GL_DEPTH_TEST);
+        GlState::Enable(GL_DEPTH_TEST);
 
         float vertices[] = {
             -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
@@ -155,7 +160,7 @@ namespace gpr5300
         glGenBuffers(1, &ebo_);
 
         // Bind VAO
-        glBindVertexArray(vao_);
+        GlState::BindVertexArray(vao_);
 
         // Bind and set VBO
         glBindBuffer(GL_ARRAY_BUFFER, vbo_);
@@ -174,19 +179,21 @@ namespace gpr5300
         glEnableVertexAttribArray(1);
 
         // Unbind VAO (optional)
-        glBindVertexArray(0);
+        GlState::BindVertexArray(0);
     }
 
     void HelloTriangle::End()
     {
         //Unload program/pipeline
-        glDeleteProgram(program_);
+        GlState::DeleteProgram(program_);
 
         glDeleteShader(vertexShader_);
         glDeleteShader(fragmentShader_);
 
-        glDeleteVertexArrays(1, &vao_);
+        GlState::DeleteVertexArrays(1, &vao_);
+        glDeleteBuffers(1, &vbo_);
         glDeleteBuffers(1, &ebo_);
+        GlState::DeleteTextures(1, &texture_);
     }
 
     void HelloTriangle::Update(const float dt)
@@ -203,7 +210,7 @@ namespace gpr5300
         model = glm::rotate(model, elapsedTime_, glm::vec3(0.5f, 1.0f, 0.0f));
         view = camera_->view();
 
-        projection = glm::perspective(glm::radians(45.0f), (float)1280 / (float)720, 0.1f, 100.0f);
+        projection = glm::perspective(glm::radians(45.0f), render_targets_->AspectRatio(), 0.1f, 100.0f);
         // retrieve the matrix uniform locations
 
         // Pass transformations to shaders
@@ -214,10 +221,10 @@ namespace gpr5300
         glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
 
         //Draw program
-        glUseProgram(program_);
-        glBindTexture(GL_TEXTURE_2D, texture_);
+        GlState::UseProgram(program_);
+        GlState::BindTexture(GL_TEXTURE_2D, texture_);
         //glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(vao_);
+        GlState::BindVertexArray(vao_);
         //glDrawArrays(GL_TRIANGLES, 0, 36);
         for (unsigned int i = 0; i < 10; i++)
         {
@@ -231,7 +238,7 @@ namespace gpr5300
 
             glDrawArrays(GL_TRIANGLES, 0, 36);
         }
-        glBindVertexArray(0);
+        GlState::BindVertexArray(0);
     }
 
     void HelloTriangle::OnEvent(const SDL_Event& event)
@@ -242,7 +249,7 @@ namespace gpr5300
     void HelloTriangle::UpdateCamera(const float dt)
     {
         // Get keyboard state
-        const Uint8* state = SDL_GetKeyboardState(NULL);
+        const Uint8* state = input_->GetKeyboardState();
 
         // Camera controls
         if (state[SDL_SCANCODE_W])
@@ -271,7 +278,7 @@ namespace gpr5300
         }
 
         int mouseX, mouseY;
-        const Uint32 mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
+        const Uint32 mouseState = input_->GetRelativeMouseState(&mouseX, &mouseY);
         if (mouseState & SDL_BUTTON(SDL_BUTTON_LEFT) && !ImGui::GetIO().WantCaptureMouse)
         {
             camera_->Update(mouseX, mouseY);
@@ -286,11 +293,15 @@ namespace gpr5300
     }
 }
 
+#ifdef GPR5300_SCENE_HOST
+static gpr5300::SceneRegistration registration("hello_triangle", [] { return std::make_unique<gpr5300::HelloTriangle>(); });
+#else
 int main(int argc, char* argv[])
 {
     gpr5300::HelloTriangle scene;
-    gpr5300::Engine engine(&scene);
+    gpr5300::Engine engine(&scene, gpr5300::EngineSettings::FromArgs(argc, argv));
     engine.Run();
 
     return EXIT_SUCCESS;
 }
+#endif
@@ -1,8 +1,11 @@
-﻿#include <fstream>
+﻿#include <cstdint>
+#include <fstream>
 #include <imgui.h>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <sstream>
+#include <vector>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -11,13 +14,42 @@
 #include "engine.h"
 #include "file_utility.h"
 #include "free_camera.h"
+#include "gl_resources.h"
+#include "gl_state.h"
+#include "gpu_profiler.h"
+#include "input.h"
+#include "late_latch.h"
 #include "model.h"
+#include "render_target_pool.h"
+#include "render_thread.h"
+#include "resource_cache.h"
 #include "scene.h"
+#include "scene_registry.h"
 #include "shader.h"
+#include "shaders/instancing_asteroid.h"
+#include "shaders/instancing_planet.h"
+#include "shaders/instancing_skybox.h"
 #include "texture_loader.h"
 
 namespace gpr5300
 {
+    namespace asteroid_uniforms = shaders::instancing_asteroid::uniforms;
+    namespace planet_uniforms = shaders::instancing_planet::uniforms;
+    namespace skybox_uniforms = shaders::instancing_skybox::uniforms;
+
+    namespace
+    {
+        //SplitMix64: every asteroid draws from its own stream so the field is the same whatever thread
+        //generates which matrix
+        std::uint64_t NextRandom(std::uint64_t& state)
+        {
+            std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+    }
+
     class Instancing final : public Scene
     {
     public:
@@ -27,16 +59,18 @@ namespace gpr5300
         void OnEvent(const SDL_Event& event) override;
         void DrawImGui() override;
         void UpdateCamera(const float dt) override;
+        bool SupportsRenderThread() const override { return true; }
+        bool SupportsLateLatch() const override { return true; }
 
     private:
-        Shader planet_shader_ = {};
-        Shader asteroid_shader_ = {};
+        std::shared_ptr<const Shader> planet_shader_;
+        std::shared_ptr<const Shader> asteroid_shader_;
 
-        Shader skybox_program_ = {};
+        std::shared_ptr<const Shader> skybox_program_;
         GLuint skybox_vao_ = 0;
         GLuint skybox_vbo_ = 0;
 
-        unsigned int skybox_texture_ = -1;
+        std::shared_ptr<const SharedTexture> skybox_texture_;
 
         float elapsedTime_ = 0.0f;
 
@@ -44,34 +78,50 @@ namespace gpr5300
         float quad_vertices_[30] = {};
 
         glm::mat4 *modelMatrices = nullptr;
-        Model planet_;
-        Model asteroid_;
+        std::shared_ptr<Model> planet_;
+        std::shared_ptr<Model> asteroid_;
         unsigned int asteroid_amount_ = 100000;
         GLuint asteroid_buffer_ = 0;
+        //Arena layout plus the instance matrices, one per asteroid mesh
+        std::vector<GLuint> asteroid_vaos_;
 
-        FreeCamera* camera_ = nullptr;
+        std::unique_ptr<FreeCamera> camera_;
+        bool mouse_look_ = false;
     };
 
     void Instancing::Begin()
     {
-        camera_ = new FreeCamera();
+        camera_ = std::make_unique<FreeCamera>();
 
         // stbi_set_flip_vertically_on_load(true);
-        planet_ = Model("data/planet/planet.obj");
-        asteroid_ = Model("data/rock/rock.obj");
+        //Import both models on the job system while the main thread compiles shaders and builds the asteroid field
+        //Models still in the resource cache from a previous visit of the scene host are not imported again
+        planet_ = resources_->Find<Model>("data/planet/planet.obj");
+        asteroid_ = resources_->Find<Model>("data/rock/rock.obj");
+        ModelData planet_data;
+        ModelData asteroid_data;
+        JobCounter imports;
+        if (planet_ == nullptr)
+        {
+            job_system_->Schedule([this, &planet_data] { planet_data = Model::Import("data/planet/planet.obj", job_system_); }, &imports);
+        }
+        if (asteroid_ == nullptr)
+        {
+            job_system_->Schedule([this, &asteroid_data] { asteroid_data = Model::Import("data/rock/rock.obj", job_system_); }, &imports);
+        }
 
 
         //Main program(s)
-        planet_shader_ = Shader("data/shaders/instancing/planet.vert", "data/shaders/instancing/planet.frag");
-        asteroid_shader_ = Shader("data/shaders/instancing/instancing.vert", "data/shaders/instancing/instancing.frag");
-        skybox_program_ = Shader("data/shaders/cubemaps/cubemaps.vert", "data/shaders/cubemaps/cubemaps.frag");
+        planet_shader_ = resources_->LoadShader(shaders::instancing_planet::source);
+        asteroid_shader_ = resources_->LoadShader(shaders::instancing_asteroid::source);
+        skybox_program_ = resources_->LoadShader(shaders::instancing_skybox::source);
 
         // Configure global opengl state
         // -----------------------------
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LESS);
-        // glEnable(GL_CULL_FACE);
-        // glCullFace(GL_FRONT);
+        GlState::Enable(GL_DEPTH_TEST);
+        GlState::DepthFunc(GL_LESS);
+        // GlState::Enable(GL_CULL_FACE);
+        // GlState::CullFace(GL_FRONT);
 
         float skyboxVertices[] = {
             // positions
@@ -120,64 +170,70 @@ namespace gpr5300
         std::ranges::copy(skyboxVertices, skybox_vertices_);
 
         modelMatrices = new glm::mat4[asteroid_amount_];
-        srand(15678); // initialize random seed
-        float radius = 150.0f;
-        float offset = 25.0f;
-        for(unsigned int i = 0; i < asteroid_amount_; i++)
+        constexpr std::uint64_t seed = 15678;
+        const float radius = 150.0f;
+        const float offset = 25.0f;
+        job_system_->ParallelFor(asteroid_amount_, 4096, [this, radius, offset](const std::size_t begin, const std::size_t end)
+        {
+            for(std::size_t i = begin; i < end; i++)
+            {
+                std::uint64_t random_state = seed ^ (i * 0xD1B54A32D192ED03ull);
+                const auto random = [&random_state](const int range) { return static_cast<int>(NextRandom(random_state) % range); };
+                glm::mat4 model = glm::mat4(1.0f);
+                // 1. translation: displace along circle with 'radius' in range [-offset, offset]
+                float angle = (float)i / (float)asteroid_amount_ * 360.0f;
+                float displacement = random((int)(2 * offset * 100)) / 100.0f - offset;
+                float x = sin(angle) * radius + displacement;
+                displacement = random((int)(2 * offset * 100)) / 100.0f - offset;
+                float y = displacement * 0.4f; // keep height of field smaller compared to width of x and z
+                displacement = random((int)(2 * offset * 100)) / 100.0f - offset;
+                float z = cos(angle) * radius + displacement;
+                model = glm::translate(model, glm::vec3(x, y, z));
+
+                // 2. scale: scale between 0.05 and 0.25f
+                float scale = random(20) / 100.0f + 0.05;
+                model = glm::scale(model, glm::vec3(scale));
+
+                // 3. rotation: add random rotation around a (semi)randomly picked rotation axis vector
+                float rotAngle = random(360);
+                model = glm::rotate(model, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
+
+                // 4. now add to list of matrices
+                modelMatrices[i] = model;
+            }
+        });
+
+        job_system_->Wait(imports);
+        if (planet_ == nullptr)
+        {
+            planet_ = resources_->Add("data/planet/planet.obj", std::make_shared<Model>(std::move(planet_data)));
+        }
+        if (asteroid_ == nullptr)
         {
-            glm::mat4 model = glm::mat4(1.0f);
-            // 1. translation: displace along circle with 'radius' in range [-offset, offset]
-            float angle = (float)i / (float)asteroid_amount_ * 360.0f;
-            float displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-            float x = sin(angle) * radius + displacement;
-            displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-            float y = displacement * 0.4f; // keep height of field smaller compared to width of x and z
-            displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-            float z = cos(angle) * radius + displacement;
-            model = glm::translate(model, glm::vec3(x, y, z));
-
-            // 2. scale: scale between 0.05 and 0.25f
-            float scale = (rand() % 20) / 100.0f + 0.05;
-            model = glm::scale(model, glm::vec3(scale));
-
-            // 3. rotation: add random rotation around a (semi)randomly picked rotation axis vector
-            float rotAngle = (rand() % 360);
-            model = glm::rotate(model, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
-
-            // 4. now add to list of matrices
-            modelMatrices[i] = model;
+            asteroid_ = resources_->Add("data/rock/rock.obj", std::make_shared<Model>(std::move(asteroid_data)));
         }
 
         //Asteroid VBO
-        glGenBuffers(1, &asteroid_buffer_);
-        glBindBuffer(GL_ARRAY_BUFFER, asteroid_buffer_);
-        glBufferData(GL_ARRAY_BUFFER, asteroid_amount_ * sizeof(glm::mat4), &modelMatrices[0], GL_STATIC_DRAW);
-        for(unsigned int i = 0; i < asteroid_.meshes().size(); i++)
+        asteroid_buffer_ = GlResources::CreateBuffer(asteroid_amount_ * sizeof(glm::mat4), &modelMatrices[0]);
+        //The arena vertex arrays are shared with every other model, the instance matrices get vertex arrays of
+        //their own reading the same page, at binding point 1
+        for (const Mesh& mesh : asteroid_->meshes())
         {
-            unsigned int VAO = asteroid_.meshes()[i].VAO();
-            glBindVertexArray(VAO);
-            // vertex attributes
-            std::size_t vec4Size = sizeof(glm::vec4);
-            glEnableVertexAttribArray(3);
-            glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 4 * vec4Size, (void*)0);
-            glEnableVertexAttribArray(4);
-            glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, 4 * vec4Size, (void*)(1 * vec4Size));
-            glEnableVertexAttribArray(5);
-            glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, 4 * vec4Size, (void*)(2 * vec4Size));
-            glEnableVertexAttribArray(6);
-            glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, 4 * vec4Size, (void*)(3 * vec4Size));
-
-            glVertexAttribDivisor(3, 1);
-            glVertexAttribDivisor(4, 1);
-            glVertexAttribDivisor(5, 1);
-            glVertexAttribDivisor(6, 1);
-
-            glBindVertexArray(0);
+            const GLuint vao = Mesh::Arena().CreateVertexArray(mesh.Range().page);
+            glVertexArrayVertexBuffer(vao, 1, asteroid_buffer_, 0, sizeof(glm::mat4));
+            glVertexArrayBindingDivisor(vao, 1, 1);
+            for (GLuint column = 0; column < 4; column++)
+            {
+                glEnableVertexArrayAttrib(vao, 3 + column);
+                glVertexArrayAttribFormat(vao, 3 + column, 4, GL_FLOAT, GL_FALSE, column * sizeof(glm::vec4));
+                glVertexArrayAttribBinding(vao, 3 + column, 1);
+            }
+            asteroid_vaos_.push_back(vao);
         }
 
         //skybox VAO
         glGenVertexArrays(1, &skybox_vao_);
-        glBindVertexArray(skybox_vao_);
+        GlState::BindVertexArray(skybox_vao_);
         glGenBuffers(1, &skybox_vbo_);
         glBindBuffer(GL_ARRAY_BUFFER, skybox_vbo_);
         glBufferData(GL_ARRAY_BUFFER, sizeof(skybox_vertices_), &skybox_vertices_, GL_STATIC_DRAW);
@@ -198,15 +254,15 @@ namespace gpr5300
         // load textures
         // -------------
         // cubeTexture = TextureFromFile("container.jpg", "data/textures");
-        skybox_texture_ = CubemapFromVec(faces);
+        skybox_texture_ = resources_->LoadCubemap(faces, job_system_);
 
 
         // shader configuration
         // --------------------
-        planet_shader_.Use();
+        planet_shader_->Use();
 
-        skybox_program_.Use();
-        skybox_program_.SetInt("skybox", 0);
+        skybox_program_->Use();
+        skybox_program_->Set(skybox_uniforms::skybox, 0);
 
         // TODO: add draw as wireframe in imgui
         //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -215,9 +271,18 @@ namespace gpr5300
     void Instancing::End()
     {
         //Unload program/pipeline
-        planet_shader_.Delete();
-        asteroid_shader_.Delete();
-        skybox_program_.Delete();
+        planet_shader_.reset();
+        asteroid_shader_.reset();
+        skybox_program_.reset();
+        skybox_texture_.reset();
+        planet_.reset();
+        asteroid_.reset();
+        GlState::DeleteVertexArrays(static_cast<GLsizei>(asteroid_vaos_.size()), asteroid_vaos_.data());
+        asteroid_vaos_.clear();
+        glDeleteBuffers(1, &asteroid_buffer_);
+        asteroid_buffer_ = 0;
+        GlState::DeleteVertexArrays(1, &skybox_vao_);
+        glDeleteBuffers(1, &skybox_vbo_);
     }
 
     void Instancing::Update(const float dt)
@@ -226,52 +291,57 @@ namespace gpr5300
         elapsedTime_ += dt;
 
 
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
         //Configure transformation matrices
-        auto projection = glm::perspective(glm::radians(45.0f), (float)1280 / (float)720, 0.1f, 1000.0f);
-        auto view = camera_->view();
-
-        asteroid_shader_.Use();
-        asteroid_shader_.SetMat4("projection", projection);
-        asteroid_shader_.SetMat4("view", view);
-        planet_shader_.Use();
-        planet_shader_.SetMat4("projection", projection);
-        planet_shader_.SetMat4("view", view);
-
-        // draw planet
-        auto model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first
-        model = glm::translate(model, glm::vec3(0.0f, -3.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(4.0f, 4.0f, 4.0f));
-        planet_shader_.SetMat4("model", model);
-        planet_.Draw(planet_shader_.id_);
-
-        // draw meteorites
-        asteroid_shader_.Use();
-        asteroid_shader_.SetInt("texture_diffuse1", 0);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, asteroid_.get_textures_loaded()[0].id);
-        for(unsigned int i = 0; i < asteroid_.meshes().size(); i++)
-        {
-            glBindVertexArray(asteroid_.meshes()[i].VAO());
-            glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(asteroid_.meshes()[i].indices_.size()), GL_UNSIGNED_INT, 0, asteroid_amount_);
-            glBindVertexArray(0);
-        }
+        auto projection = glm::perspective(glm::radians(45.0f), render_targets_->AspectRatio(), 0.1f, 1000.0f);
 
-        //Draw skybox
-        glDepthFunc(GL_LEQUAL);
-        skybox_program_.Use();
-        view = glm::mat4(glm::mat3(camera_->view()));
-        skybox_program_.SetMat4("view", view);
-        skybox_program_.SetMat4("projection", projection);
-        //Skybox cube
-        glBindVertexArray(skybox_vao_);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, skybox_texture_);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
-        glDepthFunc(GL_LESS);
+        //View and projection reach the shaders through the ViewData block, written at the last moment
+        render_thread_->Enqueue([this, projection, camera = *camera_, mouse_look = mouse_look_]
+        {
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            late_latch_->Latch(camera, projection, mouse_look);
+
+            planet_shader_->Use();
+
+            // draw planet
+            auto model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first
+            model = glm::translate(model, glm::vec3(0.0f, -3.0f, 0.0f));
+            model = glm::scale(model, glm::vec3(4.0f, 4.0f, 4.0f));
+            planet_shader_->Set(planet_uniforms::model, model);
+            planet_->Draw(planet_shader_->id_);
+
+            // draw meteorites
+            auto& profiler = GpuProfiler::Get();
+            profiler.BeginPass("Asteroids");
+            asteroid_shader_->Use();
+            asteroid_shader_->Set(asteroid_uniforms::texture_diffuse1, 0);
+            GlState::ActiveTexture(GL_TEXTURE0);
+            GlState::BindTexture(GL_TEXTURE_2D, asteroid_->get_textures_loaded()[0].id);
+            const std::vector<Mesh> asteroid_meshes = asteroid_->meshes();
+            for(std::size_t i = 0; i < asteroid_meshes.size(); i++)
+            {
+                const auto& range = asteroid_meshes[i].Range();
+                GlState::BindVertexArray(asteroid_vaos_[i]);
+                glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.index_count, GL_UNSIGNED_INT,
+                                                  reinterpret_cast<const void*>(range.first_index * sizeof(unsigned int)),
+                                                  asteroid_amount_, range.base_vertex);
+            }
+            profiler.EndPass();
+
+            //Draw skybox
+            profiler.BeginPass("Skybox");
+            GlState::DepthFunc(GL_LEQUAL);
+            skybox_program_->Use();
+            //Skybox cube
+            GlState::BindVertexArray(skybox_vao_);
+            GlState::ActiveTexture(GL_TEXTURE0);
+            GlState::BindTexture(GL_TEXTURE_CUBE_MAP, skybox_texture_->id);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+            GlState::BindVertexArray(0);
+            GlState::DepthFunc(GL_LESS);
+            profiler.EndPass();
+        });
     }
 
     void Instancing::OnEvent(const SDL_Event& event)
@@ -282,7 +352,7 @@ namespace gpr5300
     void Instancing::UpdateCamera(const float dt)
     {
         // Get keyboard state
-        const Uint8* state = SDL_GetKeyboardState(NULL);
+        const Uint8* state = input_->GetKeyboardState();
 
         // Camera controls
         if (state[SDL_SCANCODE_W])
@@ -311,8 +381,9 @@ namespace gpr5300
         }
 
         int mouseX, mouseY;
-        const Uint32 mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
-        if (mouseState & SDL_BUTTON(SDL_BUTTON_LEFT) && !ImGui::GetIO().WantCaptureMouse)
+        const Uint32 mouseState = input_->GetRelativeMouseState(&mouseX, &mouseY);
+        mouse_look_ = mouseState & SDL_BUTTON(SDL_BUTTON_LEFT) && !ImGui::GetIO().WantCaptureMouse;
+        if (mouse_look_)
         {
             camera_->Update(mouseX, mouseY);
         }
@@ -328,11 +399,15 @@ namespace gpr5300
     }
 }
 
+#ifdef GPR5300_SCENE_HOST
+static gpr5300::SceneRegistration registration("instancing", [] { return std::make_unique<gpr5300::Instancing>(); });
+#else
 int main(int argc, char* argv[])
 {
     gpr5300::Instancing scene;
-    gpr5300::Engine engine(&scene);
+    gpr5300::Engine engine(&scene, gpr5300::EngineSettings::FromArgs(argc, argv));
     engine.Run();
 
     return EXIT_SUCCESS;
 }
+#endif
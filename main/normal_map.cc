@@ -1,6 +1,7 @@
 ﻿#include <fstream>
 #include <imgui.h>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -10,14 +11,23 @@
 #include "engine.h"
 #include "file_utility.h"
 #include "free_camera.h"
+#include "gl_state.h"
 #include "global_utility.h"
+#include "input.h"
 #include "model.h"
+#include "render_target_pool.h"
+#include "resource_cache.h"
 #include "scene.h"
+#include "scene_registry.h"
 #include "shader.h"
+#include "shaders/hello_light.h"
+#include "shaders/normal_map.h"
 #include "texture_loader.h"
 
 namespace gpr5300
 {
+    namespace normal_map_uniforms = shaders::normal_map::uniforms;
+
     class NormalMap final : public Scene
     {
     public:
@@ -29,15 +39,15 @@ namespace gpr5300
         void UpdateCamera(const float dt) override;
 
     private:
-        Shader shader_ = {};
-        Shader light_shader_ = {};
+        std::shared_ptr<const Shader> shader_;
+        std::shared_ptr<const Shader> light_shader_;
 
         GLuint wall_vao_ = 0;
         GLuint wall_vbo_ = 0;
         GLuint light_vao_ = 0;
 
-        unsigned int wall_texture_ = 0;
-        unsigned int wall_normal_ = 0;
+        std::shared_ptr<const SharedTexture> wall_texture_;
+        std::shared_ptr<const SharedTexture> wall_normal_;
 
         float elapsedTime_ = 0.0f;
 
@@ -45,36 +55,38 @@ namespace gpr5300
         glm::vec3 light_position_ = glm::vec3(0.5f, 1.0f, 0.3f);
         glm::vec3 light_colour_ = glm::vec3(1.0f, 1.0f, 1.0f);
 
-        FreeCamera* camera_ = nullptr;
+        std::unique_ptr<FreeCamera> camera_;
     };
 
     void NormalMap::Begin()
     {
         // configure global opengl state
         // -----------------------------
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LESS);
-        // glEnable(GL_CULL_FACE);
-        // glCullFace(GL_FRONT);
+        GlState::Enable(GL_DEPTH_TEST);
+        GlState::DepthFunc(GL_LESS);
+        // GlState::Enable(GL_CULL_FACE);
+        // GlState::CullFace(GL_FRONT);
 
-        camera_ = new FreeCamera();
+        camera_ = std::make_unique<FreeCamera>();
 
-        wall_texture_ = TextureFromFile("brickwall.jpg", "data/textures");
-        wall_normal_ = TextureFromFile("brickwall_normal.jpg", "data/textures");
+        wall_texture_ = resources_->LoadTexture("brickwall.jpg", "data/textures");
+        wall_normal_ = resources_->LoadTexture("brickwall_normal.jpg", "data/textures");
 
         //Main program(s)
-        shader_ = Shader("data/shaders/normal_map/normal_map.vert", "data/shaders/normal_map/normal_map.frag");
-        light_shader_ = Shader("data/shaders/hello_light/light.vert", "data/shaders/hello_light/light.frag");
+        shader_ = resources_->LoadShader(shaders::normal_map::source);
+        light_shader_ = resources_->LoadShader(shaders::hello_light::source);
 
-        shader_.Use();
-        shader_.SetInt("diffuseMap", 0);
-        shader_.SetInt("normalMap", 1);
+        shader_->Use();
+        shader_->Set(normal_map_uniforms::diffuseMap, 0);
+        shader_->Set(normal_map_uniforms::normalMap, 1);
     }
 
     void NormalMap::End()
     {
-        shader_.Delete();
-        light_shader_.Delete();
+        shader_.reset();
+        light_shader_.reset();
+        wall_texture_.reset();
+        wall_normal_.reset();
     }
 
     void NormalMap::Update(const float dt)
@@ -86,33 +98,33 @@ namespace gpr5300
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         //Configure transformation matrices
-        auto projection = glm::perspective(glm::radians(45.0f), (float)1280 / (float)720, 0.1f, 1000.0f);
+        auto projection = glm::perspective(glm::radians(45.0f), render_targets_->AspectRatio(), 0.1f, 1000.0f);
         auto view = camera_->view();
 
-        shader_.Use();
-        shader_.SetMat4("projection", projection);
-        shader_.SetMat4("view", view);
+        shader_->Use();
+        shader_->Set(normal_map_uniforms::projection, projection);
+        shader_->Set(normal_map_uniforms::view, view);
 
         // render wall
         auto model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first
         model = glm::rotate(model, glm::radians(elapsedTime_ * -10.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0))); // rotate the quad to show normal mapping from multiple directions
-        shader_.SetMat4("model", model);
-        shader_.SetVec3("viewPos", camera_->camera_position_);
-        shader_.SetVec3("lightPos", light_position_);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, wall_texture_);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, wall_normal_);
+        shader_->Set(normal_map_uniforms::model, model);
+        shader_->Set(normal_map_uniforms::viewPos, camera_->camera_position_);
+        shader_->Set(normal_map_uniforms::lightPos, light_position_);
+        GlState::ActiveTexture(GL_TEXTURE0);
+        GlState::BindTexture(GL_TEXTURE_2D, wall_texture_->id);
+        GlState::ActiveTexture(GL_TEXTURE1);
+        GlState::BindTexture(GL_TEXTURE_2D, wall_normal_->id);
         normal_renderQuad();
 
         // render light source (simply re-renders a smaller plane at the light's position for debugging/visualization)
         model = glm::mat4(1.0f);
         model = glm::translate(model, light_position_);
         model = glm::scale(model, glm::vec3(0.1f));
-        shader_.SetMat4("model", model);
+        shader_->Set(normal_map_uniforms::model, model);
         normal_renderQuad();
 
-        glBindVertexArray(0);
+        GlState::BindVertexArray(0);
     }
 
     void NormalMap::OnEvent(const SDL_Event& event)
@@ -123,7 +135,7 @@ namespace gpr5300
     void NormalMap::UpdateCamera(const float dt)
     {
         // Get keyboard state
-        const Uint8* state = SDL_GetKeyboardState(NULL);
+        const Uint8* state = input_->GetKeyboardState();
 
         // Camera controls
         if (state[SDL_SCANCODE_W])
@@ -152,7 +164,7 @@ namespace gpr5300
         }
 
         int mouseX, mouseY;
-        const Uint32 mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
+        const Uint32 mouseState = input_->GetRelativeMouseState(&mouseX, &mouseY);
         if (mouseState & SDL_BUTTON(SDL_BUTTON_LEFT) && !ImGui::GetIO().WantCaptureMouse)
         {
             camera_->Update(mouseX, mouseY);
@@ -172,11 +184,15 @@ namespace gpr5300
 
 
 
+#ifdef GPR5300_SCENE_HOST
+static gpr5300::SceneRegistration registration("normal_map", [] { return std::make_unique<gpr5300::NormalMap>(); });
+#else
 int main(int argc, char* argv[])
 {
     gpr5300::NormalMap scene;
-    gpr5300::Engine engine(&scene);
+    gpr5300::Engine engine(&scene, gpr5300::EngineSettings::FromArgs(argc, argv));
     engine.Run();
 
     return EXIT_SUCCESS;
 }
+#endif
@@ -1,6 +1,7 @@
 ﻿#include <fstream>
 #include <imgui.h>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -10,14 +11,33 @@
 #include "engine.h"
 #include "file_utility.h"
 #include "free_camera.h"
+#include "gl_resources.h"
+#include "gl_state.h"
+#include "gpu_profiler.h"
 #include "global_utility.h"
+#include "input.h"
 #include "model.h"
+#include "render_target_pool.h"
+#include "resource_cache.h"
 #include "scene.h"
+#include "scene_registry.h"
 #include "shader.h"
+#include "shaders/pbr.h"
+#include "shaders/pbr_background.h"
+#include "shaders/pbr_brdf.h"
+#include "shaders/pbr_equirectangular_to_cubemap.h"
+#include "shaders/pbr_irradiance.h"
+#include "shaders/pbr_prefilter.h"
 #include "texture_loader.h"
 
 namespace gpr5300
 {
+    namespace pbr_uniforms = shaders::pbr::uniforms;
+    namespace background_uniforms = shaders::pbr_background::uniforms;
+    namespace equirectangular_uniforms = shaders::pbr_equirectangular_to_cubemap::uniforms;
+    namespace irradiance_uniforms = shaders::pbr_irradiance::uniforms;
+    namespace prefilter_uniforms = shaders::pbr_prefilter::uniforms;
+
     class PBR final : public Scene
     {
     public:
@@ -29,12 +49,14 @@ namespace gpr5300
         void UpdateCamera(const float dt) override;
 
     private:
-        Shader pbr_shader_ = {};
-        Shader equirectangular_to_cubemap_shader_ = {};
-        Shader irradiance_shader_ = {};
-        Shader prefilter_shader_ = {};
-        Shader brdf_shader_ = {};
-        Shader background_shader_ = {};
+        void ResolveLightUniforms();
+
+        std::shared_ptr<const Shader> pbr_shader_;
+        std::shared_ptr<const Shader> equirectangular_to_cubemap_shader_;
+        std::shared_ptr<const Shader> irradiance_shader_;
+        std::shared_ptr<const Shader> prefilter_shader_;
+        std::shared_ptr<const Shader> brdf_shader_;
+        std::shared_ptr<const Shader> background_shader_;
 
         unsigned int irradiance_map_ = 0;
         unsigned int env_cubemap_ = 0;
@@ -45,49 +67,73 @@ namespace gpr5300
         int nr_columns_ = 7;
         float spacing_ = 2.5;
 
-        glm::vec3 light_positions_[4] = {};
-        glm::vec3 light_colors_[4] = {};
+        //Also the LIGHT_COUNT of the pbr program
+        static constexpr int light_count = 4;
+        glm::vec3 light_positions_[light_count] = {};
+        glm::vec3 light_colors_[light_count] = {};
+        UniformHandle<glm::vec3> light_position_uniforms_[light_count] = {};
+        UniformHandle<glm::vec3> light_color_uniforms_[light_count] = {};
+        unsigned int light_uniforms_revision_ = 0;
 
         float elapsedTime_ = 0.0f;
 
-        FreeCamera* camera_ = nullptr;
+        std::unique_ptr<FreeCamera> camera_;
     };
 
+    void PBR::ResolveLightUniforms()
+    {
+        for (int i = 0; i < light_count; ++i)
+        {
+            const std::string element = "[" + std::to_string(i) + "]";
+            light_position_uniforms_[i] = pbr_shader_->GetUniform<glm::vec3>(
+                std::string(pbr_uniforms::lightPositions.name) + element);
+            light_color_uniforms_[i] = pbr_shader_->GetUniform<glm::vec3>(
+                std::string(pbr_uniforms::lightColors.name) + element);
+        }
+        light_uniforms_revision_ = pbr_shader_->Revision();
+    }
+
     void PBR::Begin()
     {
-        camera_ = new FreeCamera();
+        camera_ = std::make_unique<FreeCamera>();
         // stbi_set_flip_vertically_on_load(true);
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
-
-        pbr_shader_ = Shader("data/shaders/pbr/pbr.vert", "data/shaders/pbr/pbr.frag");
-        equirectangular_to_cubemap_shader_ = Shader("data/shaders/pbr/cubemap.vert",
-                                                    "data/shaders/pbr/equirectangular_to_cubemap.frag");
-        irradiance_shader_ = Shader("data/shaders/pbr/cubemap.vert", "data/shaders/pbr/irradiance.frag");
-        prefilter_shader_ = Shader("data/shaders/pbr/cubemap.vert", "data/shaders/pbr/prefilter.frag");
-        brdf_shader_ = Shader("data/shaders/pbr/brdf.vert", "data/shaders/pbr/brdf.frag");
-        background_shader_ = Shader("data/shaders/pbr/background.vert", "data/shaders/pbr/background.frag");
-
-        pbr_shader_.Use();
-        pbr_shader_.SetInt("irradianceMap", 0);
-        pbr_shader_.SetInt("prefilterMap", 1);
-        pbr_shader_.SetInt("brdfLUT", 2);
-        pbr_shader_.SetVec3("albedo", 0.5f, 0.0f, 0.0f);
-        pbr_shader_.SetFloat("ao", 1.0f);
+        GlState::Enable(GL_DEPTH_TEST);
+        GlState::DepthFunc(GL_LEQUAL);
+
+        pbr_shader_ = resources_->LoadShader(shaders::pbr::source, {{"LIGHT_COUNT", std::to_string(light_count)}});
+        //cubemap.vert is compiled once for the three cubemap passes
+        equirectangular_to_cubemap_shader_ = resources_->LoadPipeline(
+            shaders::pbr_equirectangular_to_cubemap::source.vertex_path,
+            shaders::pbr_equirectangular_to_cubemap::source.fragment_path);
+        irradiance_shader_ = resources_->LoadPipeline(shaders::pbr_irradiance::source.vertex_path,
+                                                      shaders::pbr_irradiance::source.fragment_path);
+        prefilter_shader_ = resources_->LoadPipeline(shaders::pbr_prefilter::source.vertex_path,
+                                                     shaders::pbr_prefilter::source.fragment_path);
+        brdf_shader_ = resources_->LoadShader(shaders::pbr_brdf::source);
+        background_shader_ = resources_->LoadShader(shaders::pbr_background::source);
+
+        //Reflection waits on the link, only once every program of the scene is compiling
+        ResolveLightUniforms();
+        pbr_shader_->Use();
+        pbr_shader_->Set(pbr_uniforms::irradianceMap, 0);
+        pbr_shader_->Set(pbr_uniforms::prefilterMap, 1);
+        pbr_shader_->Set(pbr_uniforms::brdfLUT, 2);
+        pbr_shader_->Set(pbr_uniforms::albedo, glm::vec3(0.5f, 0.0f, 0.0f));
+        pbr_shader_->Set(pbr_uniforms::ao, 1.0f);
 
         // with Textures
-        // pbr_shader_.Use();
-        // pbr_shader_.SetInt("irradianceMap", 0);
-        // pbr_shader_.SetInt("prefilterMap", 1);
-        // pbr_shader_.SetInt("brdfLUT", 2);
-        // pbr_shader_.SetInt("albedoMap", 3);
-        // pbr_shader_.SetInt("normalMap", 4);
-        // pbr_shader_.SetInt("metallicMap", 5);
-        // pbr_shader_.SetInt("roughnessMap", 6);
-        // pbr_shader_.SetInt("aoMap", 7);
-
-        background_shader_.Use();
-        background_shader_.SetInt("environmentMap", 0);
+        // pbr_shader_->Use();
+        // pbr_shader_->SetInt("irradianceMap", 0);
+        // pbr_shader_->SetInt("prefilterMap", 1);
+        // pbr_shader_->SetInt("brdfLUT", 2);
+        // pbr_shader_->SetInt("albedoMap", 3);
+        // pbr_shader_->SetInt("normalMap", 4);
+        // pbr_shader_->SetInt("metallicMap", 5);
+        // pbr_shader_->SetInt("roughnessMap", 6);
+        // pbr_shader_->SetInt("aoMap", 7);
+
+        background_shader_->Use();
+        background_shader_->Set(background_uniforms::environmentMap, 0);
 
         // you would load PBR material textures here
         // rusted iron
@@ -117,32 +163,22 @@ namespace gpr5300
 
         // pbr: setup framebuffer
         // ----------------------
-        unsigned int captureFBO;
-        unsigned int captureRBO;
-        glGenFramebuffers(1, &captureFBO);
-        glGenRenderbuffers(1, &captureRBO);
-
-        glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-        glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
+        //The depth renderbuffer is resized for each capture, renderbuffer storage is not immutable
+        const unsigned int captureFBO = GlResources::CreateFramebuffer();
+        const unsigned int captureRBO = GlResources::CreateRenderbuffer(GL_DEPTH_COMPONENT24, 512, 512);
+        glNamedFramebufferRenderbuffer(captureFBO, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
 
         // pbr: load the HDR environment map
         // ---------------------------------
         stbi_set_flip_vertically_on_load(true);
         int width, height, nrComponents;
         float* data = stbi_loadf("data/textures/newport_loft.hdr", &width, &height, &nrComponents, 0);
-        unsigned int hdrTexture;
+        unsigned int hdrTexture = 0;
         if (data)
         {
-            glGenTextures(1, &hdrTexture);
-            glBindTexture(GL_TEXTURE_2D, hdrTexture);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, data);
-
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            hdrTexture = GlResources::CreateTexture2D(GL_RGB16F, width, height);
+            glTextureSubImage2D(hdrTexture, 0, 0, 0, width, height, GL_RGB, GL_FLOAT, data);
+            GlResources::SetSampling(hdrTexture, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE);
 
             stbi_image_free(data);
         }
@@ -153,18 +189,9 @@ namespace gpr5300
 
         // pbr: setup cubemap to render to and attach to framebuffer
         // ---------------------------------------------------------
-        glGenTextures(1, &env_cubemap_);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, env_cubemap_);
-        for (unsigned int i = 0; i < 6; ++i)
-        {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 512, 512, 0, GL_RGB, GL_FLOAT, nullptr);
-        }
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-        // glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); //TODO should use this for the prefilter but it makes the cubemap disappear
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        env_cubemap_ = GlResources::CreateTextureCube(GL_RGB16F, 512);
+        // GL_LINEAR_MIPMAP_LINEAR //TODO should use this for the prefilter but it makes the cubemap disappear
+        GlResources::SetSampling(env_cubemap_, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE);
 
         // pbr: set up projection and view matrices for capturing data onto the 6 cubemap face directions
         // ----------------------------------------------------------------------------------------------
@@ -181,157 +208,151 @@ namespace gpr5300
 
         // pbr: convert HDR equirectangular environment map to cubemap equivalent
         // ----------------------------------------------------------------------
-        equirectangular_to_cubemap_shader_.Use();
-        equirectangular_to_cubemap_shader_.SetInt("equirectangularMap", 0);
-        equirectangular_to_cubemap_shader_.SetMat4("projection", captureProjection);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, hdrTexture);
+        auto& profiler = GpuProfiler::Get();
+        profiler.BeginPass("IBL equirect to cubemap");
+        equirectangular_to_cubemap_shader_->Use();
+        equirectangular_to_cubemap_shader_->Set(equirectangular_uniforms::equirectangularMap, 0);
+        equirectangular_to_cubemap_shader_->Set(equirectangular_uniforms::projection, captureProjection);
+        GlState::ActiveTexture(GL_TEXTURE0);
+        GlState::BindTexture(GL_TEXTURE_2D, hdrTexture);
 
         glViewport(0, 0, 512, 512); // don't forget to configure the viewport to the capture dimensions.
-        glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+        GlState::BindFramebuffer(GL_FRAMEBUFFER, captureFBO);
         for (unsigned int i = 0; i < 6; ++i)
         {
-            equirectangular_to_cubemap_shader_.SetMat4("view", captureViews[i]);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-                                   env_cubemap_, 0);
+            equirectangular_to_cubemap_shader_->Set(equirectangular_uniforms::view, captureViews[i]);
+            glNamedFramebufferTextureLayer(captureFBO, GL_COLOR_ATTACHMENT0, env_cubemap_, 0, i);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
             renderCube();
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        GlState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.EndPass();
 
         // pbr: create an irradiance cubemap, and re-scale capture FBO to irradiance scale.
         // --------------------------------------------------------------------------------
-        glGenTextures(1, &irradiance_map_);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, irradiance_map_);
-        for (unsigned int i = 0; i < 6; ++i)
-        {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 32, 32, 0, GL_RGB, GL_FLOAT, nullptr);
-        }
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        irradiance_map_ = GlResources::CreateTextureCube(GL_RGB16F, 32);
+        GlResources::SetSampling(irradiance_map_, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-        glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 32, 32);
+        glNamedRenderbufferStorage(captureRBO, GL_DEPTH_COMPONENT24, 32, 32);
 
             // pbr: solve diffuse integral by convolution to create an irradiance (cube)map.
     // -----------------------------------------------------------------------------
-    irradiance_shader_.Use();
-    irradiance_shader_.SetInt("environmentMap", 0);
-    irradiance_shader_.SetMat4("projection", captureProjection);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, env_cubemap_);
+    profiler.BeginPass("IBL irradiance");
+    irradiance_shader_->Use();
+    irradiance_shader_->Set(irradiance_uniforms::environmentMap, 0);
+    irradiance_shader_->Set(irradiance_uniforms::projection, captureProjection);
+    GlState::ActiveTexture(GL_TEXTURE0);
+    GlState::BindTexture(GL_TEXTURE_CUBE_MAP, env_cubemap_);
 
     glViewport(0, 0, 32, 32); // don't forget to configure the viewport to the capture dimensions.
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+    GlState::BindFramebuffer(GL_FRAMEBUFFER, captureFBO);
     for (unsigned int i = 0; i < 6; ++i)
     {
-        irradiance_shader_.SetMat4("view", captureViews[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradiance_map_, 0);
+        irradiance_shader_->Set(irradiance_uniforms::view, captureViews[i]);
+        glNamedFramebufferTextureLayer(captureFBO, GL_COLOR_ATTACHMENT0, irradiance_map_, 0, i);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         renderCube();
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GlState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+    profiler.EndPass();
 
     // pbr: create a pre-filter cubemap, and re-scale capture FBO to pre-filter scale.
     // --------------------------------------------------------------------------------
-    glGenTextures(1, &prefilter_map_);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, prefilter_map_);
-    for (unsigned int i = 0; i < 6; ++i)
-    {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 128, 128, 0, GL_RGB, GL_FLOAT, nullptr);
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // be sure to set minification filter to mip_linear 
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // generate mipmaps for the cubemap so OpenGL automatically allocates the required memory.
-    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    // the storage of every mip level the prefilter renders to is allocated up front
+    constexpr unsigned int maxMipLevels = 5;
+    prefilter_map_ = GlResources::CreateTextureCube(GL_RGB16F, 128, maxMipLevels);
+    // be sure to set minification filter to mip_linear
+    GlResources::SetSampling(prefilter_map_, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE);
 
     // pbr: run a quasi monte-carlo simulation on the environment lighting to create a prefilter (cube)map.
     // ----------------------------------------------------------------------------------------------------
-    prefilter_shader_.Use();
-    prefilter_shader_.SetInt("environmentMap", 0);
-    prefilter_shader_.SetMat4("projection", captureProjection);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, env_cubemap_);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    unsigned int maxMipLevels = 5;
+    profiler.BeginPass("IBL prefilter");
+    prefilter_shader_->Use();
+    prefilter_shader_->Set(prefilter_uniforms::environmentMap, 0);
+    prefilter_shader_->Set(prefilter_uniforms::projection, captureProjection);
+    GlState::ActiveTexture(GL_TEXTURE0);
+    GlState::BindTexture(GL_TEXTURE_CUBE_MAP, env_cubemap_);
+
+    GlState::BindFramebuffer(GL_FRAMEBUFFER, captureFBO);
     for (unsigned int mip = 0; mip < maxMipLevels; ++mip)
     {
         // reisze framebuffer according to mip-level size.
         unsigned int mipWidth  = static_cast<unsigned int>(128 * std::pow(0.5, mip));
         unsigned int mipHeight = static_cast<unsigned int>(128 * std::pow(0.5, mip));
-        glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
+        glNamedRenderbufferStorage(captureRBO, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
         glViewport(0, 0, mipWidth, mipHeight);
 
         float roughness = (float)mip / (float)(maxMipLevels - 1);
-        prefilter_shader_.SetFloat("roughness", roughness);
+        prefilter_shader_->Set(prefilter_uniforms::roughness, roughness);
         for (unsigned int i = 0; i < 6; ++i)
         {
-            prefilter_shader_.SetMat4("view", captureViews[i]);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefilter_map_, mip);
+            prefilter_shader_->Set(prefilter_uniforms::view, captureViews[i]);
+            glNamedFramebufferTextureLayer(captureFBO, GL_COLOR_ATTACHMENT0, prefilter_map_, mip, i);
 
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             renderCube();
         }
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GlState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+    profiler.EndPass();
 
     // pbr: generate a 2D LUT from the BRDF equations used.
     // ----------------------------------------------------
-    glGenTextures(1, &brdf_lut_texture_);
-
     // pre-allocate enough memory for the LUT texture.
-    glBindTexture(GL_TEXTURE_2D, brdf_lut_texture_);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, 512, 512, 0, GL_RG, GL_FLOAT, 0);
+    brdf_lut_texture_ = GlResources::CreateTexture2D(GL_RG16F, 512, 512);
     // be sure to set wrapping mode to GL_CLAMP_TO_EDGE
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    GlResources::SetSampling(brdf_lut_texture_, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE);
 
     // then re-configure capture framebuffer object and render screen-space quad with BRDF shader.
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdf_lut_texture_, 0);
+    glNamedRenderbufferStorage(captureRBO, GL_DEPTH_COMPONENT24, 512, 512);
+    glNamedFramebufferTexture(captureFBO, GL_COLOR_ATTACHMENT0, brdf_lut_texture_, 0);
+    GlState::BindFramebuffer(GL_FRAMEBUFFER, captureFBO);
 
     glViewport(0, 0, 512, 512);
-    brdf_shader_.Use();
+    profiler.BeginPass("IBL BRDF LUT");
+    brdf_shader_->Use();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     renderQuad();
+    profiler.EndPass();
+
+    GlState::BindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    //Only the maps are sampled from now on
+    GlState::DeleteFramebuffers(1, &captureFBO);
+    glDeleteRenderbuffers(1, &captureRBO);
+    GlState::DeleteTextures(1, &hdrTexture);
 
         // initialize static shader uniforms before rendering
         // --------------------------------------------------
-        auto projection = glm::perspective(glm::radians(45.0f), 1280.0f / 720.0f, 0.1f, 100.0f);
-        pbr_shader_.Use();
-        pbr_shader_.SetMat4("projection", projection);
-        background_shader_.Use();
-        background_shader_.SetMat4("projection", projection);
+        auto projection = glm::perspective(glm::radians(45.0f), render_targets_->AspectRatio(), 0.1f, 100.0f);
+        pbr_shader_->Use();
+        pbr_shader_->Set(pbr_uniforms::projection, projection);
+        background_shader_->Use();
+        background_shader_->Set(background_uniforms::projection, projection);
 
         // then before rendering, configure the viewport to the original framebuffer's screen dimensions
 
-        glViewport(0, 0, 1280, 720);
+        glViewport(0, 0, render_targets_->Width(), render_targets_->Height());
     }
 
     void PBR::End()
     {
         //Unload program/pipeline
-        pbr_shader_.Delete();
-        equirectangular_to_cubemap_shader_.Delete();
-        irradiance_shader_.Delete();
-        background_shader_.Delete();
+        pbr_shader_.reset();
+        equirectangular_to_cubemap_shader_.reset();
+        irradiance_shader_.reset();
+        background_shader_.reset();
+        prefilter_shader_.reset();
+        brdf_shader_.reset();
+
+        const GLuint maps[] = {env_cubemap_, irradiance_map_, prefilter_map_, brdf_lut_texture_};
+        GlState::DeleteTextures(4, maps);
+        env_cubemap_ = 0;
+        irradiance_map_ = 0;
+        prefilter_map_ = 0;
+        brdf_lut_texture_ = 0;
     }
 
     void PBR::Update(const float dt)
@@ -344,34 +365,42 @@ namespace gpr5300
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        auto& profiler = GpuProfiler::Get();
+
         // render scene, supplying the convoluted irradiance map to the final shader.
         // ------------------------------------------------------------------------------------------
-        pbr_shader_.Use();
+        profiler.BeginPass("Spheres");
+        pbr_shader_->Use();
         auto view = camera_->view();
-        pbr_shader_.SetMat4("view", view);
+        pbr_shader_->Set(pbr_uniforms::view, view);
         const glm::vec3 view_pos = camera_->camera_position_;
-        pbr_shader_.SetVec3("camPos", view_pos);
+        pbr_shader_->Set(pbr_uniforms::camPos, view_pos);
+        //A hot reload may have moved the light uniforms
+        if (light_uniforms_revision_ != pbr_shader_->Revision())
+        {
+            ResolveLightUniforms();
+        }
 
         // bind pre-computed IBL data
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, irradiance_map_);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, prefilter_map_);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, brdf_lut_texture_);
+        GlState::ActiveTexture(GL_TEXTURE0);
+        GlState::BindTexture(GL_TEXTURE_CUBE_MAP, irradiance_map_);
+        GlState::ActiveTexture(GL_TEXTURE1);
+        GlState::BindTexture(GL_TEXTURE_CUBE_MAP, prefilter_map_);
+        GlState::ActiveTexture(GL_TEXTURE2);
+        GlState::BindTexture(GL_TEXTURE_2D, brdf_lut_texture_);
 
         // // With textures, render each sphere with a different material
         // // rusted iron
-        // glActiveTexture(GL_TEXTURE3);
-        // glBindTexture(GL_TEXTURE_2D, ironAlbedoMap);
-        // glActiveTexture(GL_TEXTURE4);
-        // glBindTexture(GL_TEXTURE_2D, ironNormalMap);
-        // glActiveTexture(GL_TEXTURE5);
-        // glBindTexture(GL_TEXTURE_2D, ironMetallicMap);
-        // glActiveTexture(GL_TEXTURE6);
-        // glBindTexture(GL_TEXTURE_2D, ironRoughnessMap);
-        // glActiveTexture(GL_TEXTURE7);
-        // glBindTexture(GL_TEXTURE_2D, ironAOMap);
+        // GlState::ActiveTexture(GL_TEXTURE3);
+        // GlState::BindTexture(GL_TEXTURE_2D, ironAlbedoMap);
+        // GlState::ActiveTexture(GL_TEXTURE4);
+        // GlState::BindTexture(GL_TEXTURE_2D, ironNormalMap);
+        // GlState::ActiveTexture(GL_TEXTURE5);
+        // GlState::BindTexture(GL_TEXTURE_2D, ironMetallicMap);
+        // GlState::ActiveTexture(GL_TEXTURE6);
+        // GlState::BindTexture(GL_TEXTURE_2D, ironRoughnessMap);
+        // GlState::ActiveTexture(GL_TEXTURE7);
+        // GlState::BindTexture(GL_TEXTURE_2D, ironAOMap);
         //
         // model = glm::mat4(1.0f);
         // model = glm::translate(model, glm::vec3(-5.0, 0.0, 2.0));
@@ -380,16 +409,16 @@ namespace gpr5300
         // renderSphere();
         //
         // // gold
-        // glActiveTexture(GL_TEXTURE3);
-        // glBindTexture(GL_TEXTURE_2D, goldAlbedoMap);
-        // glActiveTexture(GL_TEXTURE4);
-        // glBindTexture(GL_TEXTURE_2D, goldNormalMap);
-        // glActiveTexture(GL_TEXTURE5);
-        // glBindTexture(GL_TEXTURE_2D, goldMetallicMap);
-        // glActiveTexture(GL_TEXTURE6);
-        // glBindTexture(GL_TEXTURE_2D, goldRoughnessMap);
-        // glActiveTexture(GL_TEXTURE7);
-        // glBindTexture(GL_TEXTURE_2D, goldAOMap);
+        // GlState::ActiveTexture(GL_TEXTURE3);
+        // GlState::BindTexture(GL_TEXTURE_2D, goldAlbedoMap);
+        // GlState::ActiveTexture(GL_TEXTURE4);
+        // GlState::BindTexture(GL_TEXTURE_2D, goldNormalMap);
+        // GlState::ActiveTexture(GL_TEXTURE5);
+        // GlState::BindTexture(GL_TEXTURE_2D, goldMetallicMap);
+        // GlState::ActiveTexture(GL_TEXTURE6);
+        // GlState::BindTexture(GL_TEXTURE_2D, goldRoughnessMap);
+        // GlState::ActiveTexture(GL_TEXTURE7);
+        // GlState::BindTexture(GL_TEXTURE_2D, goldAOMap);
         //
         // model = glm::mat4(1.0f);
         // model = glm::translate(model, glm::vec3(-3.0, 0.0, 2.0));
@@ -402,12 +431,12 @@ namespace gpr5300
         glm::mat4 model = glm::mat4(1.0f);
         for (int row = 0; row < nr_rows_; ++row)
         {
-            pbr_shader_.SetFloat("metallic", (float)row / (float)nr_rows_);
+            pbr_shader_->Set(pbr_uniforms::metallic, (float)row / (float)nr_rows_);
             for (int col = 0; col < nr_columns_; ++col)
             {
                 // we clamp the roughness to 0.025 - 1.0 as perfectly smooth surfaces (roughness of 0.0) tend to look a bit off
                 // on direct lighting.
-                pbr_shader_.SetFloat("roughness", glm::clamp((float)col / (float)nr_columns_, 0.05f, 1.0f));
+                pbr_shader_->Set(pbr_uniforms::roughness, glm::clamp((float)col / (float)nr_columns_, 0.05f, 1.0f));
 
                 model = glm::mat4(1.0f);
                 model = glm::translate(model, glm::vec3(
@@ -415,8 +444,8 @@ namespace gpr5300
                                            (float)(row - (nr_rows_ / 2)) * spacing_,
                                            -2.0f
                                        ));
-                pbr_shader_.SetMat4("model", model);
-                pbr_shader_.SetMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(model))));
+                pbr_shader_->Set(pbr_uniforms::model, model);
+                pbr_shader_->Set(pbr_uniforms::normalMatrix, glm::transpose(glm::inverse(glm::mat3(model))));
                 renderSphere();
             }
         }
@@ -429,28 +458,32 @@ namespace gpr5300
         {
             glm::vec3 newPos = light_positions_[i] + glm::vec3(sin(elapsedTime_ * 5.0) * 5.0, 0.0, 0.0);
             newPos = light_positions_[i];
-            pbr_shader_.SetVec3("lightPositions[" + std::to_string(i) + "]", newPos);
-            pbr_shader_.SetVec3("lightColors[" + std::to_string(i) + "]", light_colors_[i]);
+            pbr_shader_->Set(light_position_uniforms_[i], newPos);
+            pbr_shader_->Set(light_color_uniforms_[i], light_colors_[i]);
 
             model = glm::mat4(1.0f);
             model = glm::translate(model, newPos);
             model = glm::scale(model, glm::vec3(0.5f));
-            pbr_shader_.SetMat4("model", model);
-            pbr_shader_.SetMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(model))));
+            pbr_shader_->Set(pbr_uniforms::model, model);
+            pbr_shader_->Set(pbr_uniforms::normalMatrix, glm::transpose(glm::inverse(glm::mat3(model))));
             renderSphere();
         }
 
+        profiler.EndPass();
+
         // render skybox (render as last to prevent overdraw)
-        background_shader_.Use();
-        background_shader_.SetMat4("view", view);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, env_cubemap_);
-        // glBindTexture(GL_TEXTURE_CUBE_MAP, irradiance_map_); // display irradiance map
-        // glBindTexture(GL_TEXTURE_CUBE_MAP, prefilter_map_); // display prefilter map
+        profiler.BeginPass("Skybox");
+        background_shader_->Use();
+        background_shader_->Set(background_uniforms::view, view);
+        GlState::ActiveTexture(GL_TEXTURE0);
+        GlState::BindTexture(GL_TEXTURE_CUBE_MAP, env_cubemap_);
+        // GlState::BindTexture(GL_TEXTURE_CUBE_MAP, irradiance_map_); // display irradiance map
+        // GlState::BindTexture(GL_TEXTURE_CUBE_MAP, prefilter_map_); // display prefilter map
         renderCube();
+        profiler.EndPass();
 
         // render BRDF map to screen
-        //brdf_shader_.Use();
+        //brdf_shader_->Use();
         //renderQuad();
     }
 
@@ -473,7 +506,7 @@ namespace gpr5300
     void PBR::UpdateCamera(const float dt)
     {
         // Get keyboard state
-        const Uint8* state = SDL_GetKeyboardState(NULL);
+        const Uint8* state = input_->GetKeyboardState();
 
         // Camera controls
         if (state[SDL_SCANCODE_W])
@@ -502,7 +535,7 @@ namespace gpr5300
         }
 
         int mouseX, mouseY;
-        const Uint32 mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
+        const Uint32 mouseState = input_->GetRelativeMouseState(&mouseX, &mouseY);
         if (mouseState & SDL_BUTTON(SDL_BUTTON_LEFT) && !ImGui::GetIO().WantCaptureMouse)
         {
             camera_->Update(mouseX, mouseY);
@@ -519,11 +552,15 @@ namespace gpr5300
     }
 }
 
+#ifdef GPR5300_SCENE_HOST
+static gpr5300::SceneRegistration registration("pbr", [] { return std::make_unique<gpr5300::PBR>(); });
+#else
 int main(int argc, char* argv[])
 {
     gpr5300::PBR scene;
-    gpr5300::Engine engine(&scene);
+    gpr5300::Engine engine(&scene, gpr5300::EngineSettings::FromArgs(argc, argv));
     engine.Run();
 
     return EXIT_SUCCESS;
 }
+#endif
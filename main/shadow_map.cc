@@ -1,6 +1,7 @@
 ﻿#include <fstream>
 #include <imgui.h>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -10,14 +11,28 @@
 #include "engine.h"
 #include "file_utility.h"
 #include "free_camera.h"
+#include "gl_resources.h"
+#include "gl_state.h"
+#include "gpu_profiler.h"
 #include "global_utility.h"
+#include "input.h"
 #include "model.h"
+#include "render_target_pool.h"
+#include "resource_cache.h"
 #include "scene.h"
+#include "scene_registry.h"
 #include "shader.h"
+#include "shaders/shadow_debug_quad.h"
+#include "shaders/shadow_depth.h"
+#include "shaders/shadow_map.h"
 #include "texture_loader.h"
 
 namespace gpr5300
 {
+    namespace map_uniforms = shaders::shadow_map::uniforms;
+    namespace depth_uniforms = shaders::shadow_depth::uniforms;
+    namespace quad_uniforms = shaders::shadow_debug_quad::uniforms;
+
     class ShadowMap final : public Scene
     {
     public:
@@ -29,9 +44,13 @@ namespace gpr5300
         void UpdateCamera(const float dt) override;
 
     private:
-        Shader shader_ = {};
-        Shader shader_depth_ = {};
-        Shader shader_quad_ = {};
+        [[nodiscard]] std::shared_ptr<const Shader> LoadSceneShader() const;
+
+        std::shared_ptr<const Shader> shader_;
+        std::shared_ptr<const Shader> shader_depth_;
+        std::shared_ptr<const Shader> shader_quad_;
+        //Variant picked in the UI, the current program keeps drawing until it linked
+        std::shared_ptr<const Shader> next_shader_;
 
         GLuint plane_vao_ = 0;
         GLuint plane_vbo_ = 0;
@@ -39,33 +58,34 @@ namespace gpr5300
         GLuint depth_map_fbo_ = 0;
         GLuint depth_map_texture_ = 0;
 
-        unsigned int ground_texture_ = 0;
-        unsigned int box_texture_ = 0;
+        std::shared_ptr<const SharedTexture> ground_texture_;
+        std::shared_ptr<const SharedTexture> box_texture_;
 
         float elapsedTime_ = 0.0f;
 
         const unsigned int SHADOW_WIDTH = 1024, SHADOW_HEIGHT = 1024;
         glm::vec3 light_position_ = glm::vec3(-2.0f, 4.0f, -1.0f);
+        //PCF kernel of (2 * radius + 1)^2 taps, 0 is a single tap
+        int pcf_radius_ = 1;
 
-        FreeCamera* camera_ = nullptr;
+        std::unique_ptr<FreeCamera> camera_;
     };
 
     void ShadowMap::Begin()
     {
         // configure global opengl state
         // -----------------------------
-        glEnable(GL_DEPTH_TEST);
-        // glDepthFunc(GL_LESS);
-        // glEnable(GL_CULL_FACE);
-        // glCullFace(GL_FRONT);
+        GlState::Enable(GL_DEPTH_TEST);
+        // GlState::DepthFunc(GL_LESS);
+        // GlState::Enable(GL_CULL_FACE);
+        // GlState::CullFace(GL_FRONT);
 
-        camera_ = new FreeCamera();
+        camera_ = std::make_unique<FreeCamera>();
 
         //Build shaders
-        shader_ = Shader("data/shaders/shadow_map/shadow_map.vert", "data/shaders/shadow_map/shadow_map.frag");
-        shader_depth_ = Shader("data/shaders/shadow_map/shadow_depth.vert",
-                               "data/shaders/shadow_map/shadow_depth.frag");
-        shader_quad_ = Shader("data/shaders/shadow_map/debug_quad.vert", "data/shaders/shadow_map/debug_quad.frag");
+        shader_ = LoadSceneShader();
+        shader_depth_ = resources_->LoadShader(shaders::shadow_depth::source);
+        shader_quad_ = resources_->LoadShader(shaders::shadow_debug_quad::source);
 
         // set up vertex data (and buffer(s)) and configure vertex attributes
         // ------------------------------------------------------------------
@@ -82,7 +102,7 @@ namespace gpr5300
         // plane VAO
         glGenVertexArrays(1, &plane_vao_);
         glGenBuffers(1, &plane_vbo_);
-        glBindVertexArray(plane_vao_);
+        GlState::BindVertexArray(plane_vao_);
         glBindBuffer(GL_ARRAY_BUFFER, plane_vbo_);
         glBufferData(GL_ARRAY_BUFFER, sizeof(planeVertices), planeVertices, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
@@ -91,50 +111,51 @@ namespace gpr5300
         glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
         glEnableVertexAttribArray(2);
         glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-        glBindVertexArray(0);
+        GlState::BindVertexArray(0);
 
 
         //load textures
-        ground_texture_ = TextureFromFile("wood.png", "data/textures");
-        box_texture_ = TextureFromFile("container2.png", "data/textures");
+        ground_texture_ = resources_->LoadTexture("wood.png", "data/textures");
+        box_texture_ = resources_->LoadTexture("container2.png", "data/textures");
 
 
         // configure depth map FBO
         // -----------------------
-        glGenFramebuffers(1, &depth_map_fbo_);
+        depth_map_fbo_ = GlResources::CreateFramebuffer();
         // create depth texture
-        glGenTextures(1, &depth_map_texture_);
-        glBindTexture(GL_TEXTURE_2D, depth_map_texture_);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT,
-                     NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        depth_map_texture_ = GlResources::CreateTexture2D(GL_DEPTH_COMPONENT24, SHADOW_WIDTH, SHADOW_HEIGHT);
+        GlResources::SetSampling(depth_map_texture_, GL_NEAREST, GL_NEAREST, GL_CLAMP_TO_BORDER);
         float borderColor[] = { 1.0, 1.0, 1.0, 1.0 };
-        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+        glTextureParameterfv(depth_map_texture_, GL_TEXTURE_BORDER_COLOR, borderColor);
         // attach depth texture as FBO's depth buffer
-        glBindFramebuffer(GL_FRAMEBUFFER, depth_map_fbo_);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth_map_texture_, 0);
-        glDrawBuffer(GL_NONE);
-        glReadBuffer(GL_NONE);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glNamedFramebufferTexture(depth_map_fbo_, GL_DEPTH_ATTACHMENT, depth_map_texture_, 0);
+        glNamedFramebufferDrawBuffer(depth_map_fbo_, GL_NONE);
+        glNamedFramebufferReadBuffer(depth_map_fbo_, GL_NONE);
+        GlResources::CheckFramebuffer(depth_map_fbo_, "shadow map");
 
 
         // shader configuration
         // --------------------
-        shader_.Use();
-        shader_.SetInt("diffuseTexture", 0);
-        shader_.SetInt("shadowMap", 1);
-        shader_quad_.Use();
-        shader_quad_.SetInt("depthMap", 0);
+        shader_->Use();
+        shader_->Set(map_uniforms::diffuseTexture, 0);
+        shader_->Set(map_uniforms::shadowMap, 1);
+        shader_quad_->Use();
+        shader_quad_->Set(quad_uniforms::depthMap, 0);
     }
 
     void ShadowMap::End()
     {
-        shader_.Delete();
-        shader_quad_.Delete();
-        shader_depth_.Delete();
+        shader_.reset();
+        next_shader_.reset();
+        shader_quad_.reset();
+        shader_depth_.reset();
+        ground_texture_.reset();
+        box_texture_.reset();
+
+        GlState::DeleteVertexArrays(1, &plane_vao_);
+        glDeleteBuffers(1, &plane_vbo_);
+        GlState::DeleteFramebuffers(1, &depth_map_fbo_);
+        GlState::DeleteTextures(1, &depth_map_texture_);
     }
 
     void ShadowMap::Update(const float dt)
@@ -142,11 +163,22 @@ namespace gpr5300
         UpdateCamera(dt);
         elapsedTime_ += dt;
 
+        if (next_shader_ != nullptr && next_shader_->IsReady())
+        {
+            next_shader_->Use();
+            next_shader_->Set(map_uniforms::diffuseTexture, 0);
+            next_shader_->Set(map_uniforms::shadowMap, 1);
+            shader_ = std::move(next_shader_);
+        }
+
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        auto& profiler = GpuProfiler::Get();
+
         // 1. render depth of scene to texture (from light's perspective)
         // --------------------------------------------------------------
+        profiler.BeginPass("Shadow");
         glm::mat4 lightProjection, lightView;
         glm::mat4 lightSpaceMatrix;
         float near_plane = 1.0f, far_plane = 7.5f;
@@ -154,48 +186,51 @@ namespace gpr5300
         lightView = glm::lookAt(light_position_, glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
         lightSpaceMatrix = lightProjection * lightView;
         // render scene from light's point of view
-        shader_depth_.Use();
-        shader_depth_.SetMat4("lightSpaceMatrix", lightSpaceMatrix);
+        shader_depth_->Use();
+        shader_depth_->Set(depth_uniforms::lightSpaceMatrix, lightSpaceMatrix);
 
         glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-        glBindFramebuffer(GL_FRAMEBUFFER, depth_map_fbo_);
+        GlState::BindFramebuffer(GL_FRAMEBUFFER, depth_map_fbo_);
             glClear(GL_DEPTH_BUFFER_BIT);
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, ground_texture_);
-            renderScene(shader_depth_, plane_vao_);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            GlState::ActiveTexture(GL_TEXTURE0);
+            GlState::BindTexture(GL_TEXTURE_2D, ground_texture_->id);
+            renderScene(*shader_depth_, plane_vao_);
+        GlState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.EndPass();
 
         // reset viewport
-        glViewport(0, 0, 1280, 720);
+        glViewport(0, 0, render_targets_->Width(), render_targets_->Height());
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // 2. render scene as normal using the generated depth/shadow map
         // --------------------------------------------------------------
-        shader_.Use();
-        auto projection = glm::perspective(glm::radians(45.0f), (float)1280 / (float)720, 0.1f, 1000.0f);
+        profiler.BeginPass("Scene");
+        shader_->Use();
+        auto projection = glm::perspective(glm::radians(45.0f), render_targets_->AspectRatio(), 0.1f, 1000.0f);
         auto view = camera_->view();
-        shader_.SetMat4("projection", projection);
-        shader_.SetMat4("view", view);
+        shader_->Set(map_uniforms::projection, projection);
+        shader_->Set(map_uniforms::view, view);
         // set light uniforms
-        shader_.SetVec3("viewPos", camera_->camera_position_);
-        shader_.SetVec3("lightPos", light_position_);
-        shader_.SetMat4("lightSpaceMatrix", lightSpaceMatrix);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, ground_texture_);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, depth_map_texture_);
-        renderScene(shader_, plane_vao_);
+        shader_->Set(map_uniforms::viewPos, camera_->camera_position_);
+        shader_->Set(map_uniforms::lightPos, light_position_);
+        shader_->Set(map_uniforms::lightSpaceMatrix, lightSpaceMatrix);
+        GlState::ActiveTexture(GL_TEXTURE0);
+        GlState::BindTexture(GL_TEXTURE_2D, ground_texture_->id);
+        GlState::ActiveTexture(GL_TEXTURE1);
+        GlState::BindTexture(GL_TEXTURE_2D, depth_map_texture_);
+        renderScene(*shader_, plane_vao_);
+        profiler.EndPass();
 
         // render Depth map to quad for visual debugging
         // ---------------------------------------------
-        shader_quad_.Use();
-        shader_quad_.SetFloat("near_plane", near_plane);
-        shader_quad_.SetFloat("far_plane", far_plane);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, depth_map_texture_);
+        shader_quad_->Use();
+        shader_quad_->Set(quad_uniforms::near_plane, near_plane);
+        shader_quad_->Set(quad_uniforms::far_plane, far_plane);
+        GlState::ActiveTexture(GL_TEXTURE0);
+        GlState::BindTexture(GL_TEXTURE_2D, depth_map_texture_);
         //renderQuad();
 
-        glBindVertexArray(0);
+        GlState::BindVertexArray(0);
     }
 
     void ShadowMap::OnEvent(const SDL_Event& event)
@@ -206,7 +241,7 @@ namespace gpr5300
     void ShadowMap::UpdateCamera(const float dt)
     {
         // Get keyboard state
-        const Uint8* state = SDL_GetKeyboardState(NULL);
+        const Uint8* state = input_->GetKeyboardState();
 
         // Camera controls
         if (state[SDL_SCANCODE_W])
@@ -235,7 +270,7 @@ namespace gpr5300
         }
 
         int mouseX, mouseY;
-        const Uint32 mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
+        const Uint32 mouseState = input_->GetRelativeMouseState(&mouseX, &mouseY);
         if (mouseState & SDL_BUTTON(SDL_BUTTON_LEFT) && !ImGui::GetIO().WantCaptureMouse)
         {
             camera_->Update(mouseX, mouseY);
@@ -243,10 +278,20 @@ namespace gpr5300
     }
 
 
+    std::shared_ptr<const Shader> ShadowMap::LoadSceneShader() const
+    {
+        return resources_->LoadShader(shaders::shadow_map::source, {{"PCF_RADIUS", std::to_string(pcf_radius_)}});
+    }
+
     void ShadowMap::DrawImGui()
     {
         ImGui::Begin("My Window"); // Start a new window
 
+        if (ImGui::SliderInt("PCF radius", &pcf_radius_, 0, 2))
+        {
+            next_shader_ = LoadSceneShader();
+        }
+
         //ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
 
         // ImGui::Checkbox("Enable Bloom", &bloom_state_);
@@ -260,11 +305,15 @@ namespace gpr5300
 }
 
 
+#ifdef GPR5300_SCENE_HOST
+static gpr5300::SceneRegistration registration("shadow_map", [] { return std::make_unique<gpr5300::ShadowMap>(); });
+#else
 int main(int argc, char* argv[])
 {
     gpr5300::ShadowMap scene;
-    gpr5300::Engine engine(&scene);
+    gpr5300::Engine engine(&scene, gpr5300::EngineSettings::FromArgs(argc, argv));
     engine.Run();
 
     return EXIT_SUCCESS;
 }
+#endif
@@ -0,0 +1,172 @@
+#include "cpu_tracer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace gpr5300::CpuTracer
+{
+    namespace
+    {
+        //Zone as stored in a ring, read by the dump while its thread keeps writing
+        struct RingZone
+        {
+            std::atomic<const char*> name{nullptr};
+            std::atomic<std::int64_t> start_ns{0};
+            std::atomic<std::int64_t> end_ns{0};
+        };
+
+        struct ThreadBuffer
+        {
+            std::unique_ptr<RingZone[]> zones = std::make_unique<RingZone[]>(ring_capacity);
+            //Only the owning thread writes. head counts the complete zones, writing the zones started: a reader
+            //that saw any field of zone n sees writing > n, every zone older than writing - ring_capacity may
+            //have been overwritten under it.
+            std::atomic<std::uint64_t> head{0};
+            std::atomic<std::uint64_t> writing{0};
+            std::uint32_t thread_id = 0;
+            std::string thread_name;
+        };
+
+        struct TraceRegistry
+        {
+            std::mutex mutex;
+            std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+            std::uint32_t next_thread_id = 1;
+            std::atomic<bool> enabled{true};
+            const std::int64_t origin_ns = Now();
+        };
+
+        TraceRegistry& GetTraceRegistry()
+        {
+            static TraceRegistry registry;
+            return registry;
+        }
+
+        ThreadBuffer& GetThreadBuffer()
+        {
+            //The registry keeps the buffer alive after the thread exits so its zones can still be dumped
+            thread_local const std::shared_ptr<ThreadBuffer> buffer = []
+            {
+                auto& registry = GetTraceRegistry();
+                auto new_buffer = std::make_shared<ThreadBuffer>();
+                std::scoped_lock lock(registry.mutex);
+                new_buffer->thread_id = registry.next_thread_id++;
+                new_buffer->thread_name = "Thread " + std::to_string(new_buffer->thread_id);
+                registry.buffers.push_back(new_buffer);
+                return new_buffer;
+            }();
+            return *buffer;
+        }
+
+        void WriteJsonString(std::ostream& out, const std::string_view text)
+        {
+            out << '"';
+            for (const char c : text)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    out << '\\';
+                }
+                out << c;
+            }
+            out << '"';
+        }
+    }
+
+    void Record(const char* name, const std::int64_t start_ns, const std::int64_t end_ns)
+    {
+        if (!GetTraceRegistry().enabled.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        auto& buffer = GetThreadBuffer();
+        const std::uint64_t head = buffer.head.load(std::memory_order_relaxed);
+        buffer.writing.store(head + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        RingZone& zone = buffer.zones[head % ring_capacity];
+        zone.name.store(name, std::memory_order_relaxed);
+        zone.start_ns.store(start_ns, std::memory_order_relaxed);
+        zone.end_ns.store(end_ns, std::memory_order_relaxed);
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    void SetThreadName(const std::string_view name)
+    {
+        auto& buffer = GetThreadBuffer();
+        std::scoped_lock lock(GetTraceRegistry().mutex);
+        buffer.thread_name = name;
+    }
+
+    void SetEnabled(const bool enabled)
+    {
+        GetTraceRegistry().enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool IsEnabled()
+    {
+        return GetTraceRegistry().enabled.load(std::memory_order_relaxed);
+    }
+
+    bool WriteChromeTrace(const std::string_view path)
+    {
+        std::ofstream file(std::string(path).c_str());
+        if (!file)
+        {
+            std::cerr << "Failed to write CPU trace to " << path << '\n';
+            return false;
+        }
+
+        auto& registry = GetTraceRegistry();
+        std::scoped_lock lock(registry.mutex);
+        //Chrome expects microseconds, keep nanosecond precision with decimals
+        file << std::fixed << std::setprecision(3);
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first = true;
+        std::size_t zone_count = 0;
+        std::vector<Zone> snapshot;
+        for (const auto& buffer : registry.buffers)
+        {
+            file << (first ? "" : ",\n") << R"({"name":"thread_name","ph":"M","pid":1,"tid":)"
+                 << buffer->thread_id << R"(,"args":{"name":)";
+            WriteJsonString(file, buffer->thread_name);
+            file << "}}";
+            first = false;
+
+            //Copy the ring first, then drop the oldest zones its thread overwrote while they were copied
+            const std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+            const std::uint64_t count = std::min<std::uint64_t>(head, ring_capacity);
+            snapshot.resize(count);
+            for (std::uint64_t i = 0; i < count; i++)
+            {
+                const RingZone& zone = buffer->zones[(head - count + i) % ring_capacity];
+                snapshot[i] = {zone.name.load(std::memory_order_relaxed),
+                               zone.start_ns.load(std::memory_order_relaxed),
+                               zone.end_ns.load(std::memory_order_relaxed)};
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const std::uint64_t writing = buffer->writing.load(std::memory_order_relaxed);
+            const std::uint64_t oldest_intact = writing > ring_capacity ? writing - ring_capacity : 0;
+            const std::uint64_t skipped = std::min(count, oldest_intact - std::min(oldest_intact, head - count));
+            for (std::uint64_t i = skipped; i < count; i++)
+            {
+                const Zone& zone = snapshot[i];
+                file << ",\n{\"name\":";
+                WriteJsonString(file, zone.name);
+                file << R"(,"cat":"cpu","ph":"X","pid":1,"tid":)" << buffer->thread_id
+                     << ",\"ts\":" << static_cast<double>(zone.start_ns - registry.origin_ns) / 1000.0
+                     << ",\"dur\":" << static_cast<double>(zone.end_ns - zone.start_ns) / 1000.0 << '}';
+            }
+            zone_count += count - skipped;
+        }
+        file << "\n]}\n";
+        std::cout << "CPU trace (" << zone_count << " zones) written to " << path << '\n';
+        return true;
+    }
+} // namespace gpr5300::CpuTracer
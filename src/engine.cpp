@@ -6,103 +6,541 @@
 #include <imgui_impl_sdl2.h>
 #include <imgui_impl_opengl3.h>
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "cpu_tracer.h"
+#include "frame_statistics.h"
+#include "gl_state.h"
+#include "gpu_profiler.h"
+#include "mesh.h"
+#include "mesh_cache.h"
+#include "program_cache.h"
 
 namespace gpr5300
 {
+    namespace
+    {
+        //ImGui rebuilds its draw lists every NewFrame, the render thread replays a copy while the next frame is built
+        class ImGuiDrawSnapshot
+        {
+        public:
+            explicit ImGuiDrawSnapshot(const ImDrawData* draw_data) : data_(*draw_data)
+            {
+                for (ImDrawList*& list : data_.CmdLists)
+                {
+                    list = list->CloneOutput();
+                }
+            }
+
+            ~ImGuiDrawSnapshot()
+            {
+                for (ImDrawList* list : data_.CmdLists)
+                {
+                    IM_DELETE(list);
+                }
+            }
+
+            ImGuiDrawSnapshot(const ImGuiDrawSnapshot&) = delete;
+            ImGuiDrawSnapshot& operator=(const ImGuiDrawSnapshot&) = delete;
+
+            ImDrawData* Get() { return &data_; }
+
+        private:
+            ImDrawData data_;
+        };
+    }
+
+    EngineSettings EngineSettings::FromArgs(const int argc, char* argv[])
+    {
+        EngineSettings settings;
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string_view arg = argv[i];
+            const bool has_value = i + 1 < argc;
+            if (arg == "--headless")
+            {
+                settings.headless = true;
+            }
+            else if (arg == "--frames" && has_value)
+            {
+                settings.benchmark_frames = std::max(1, std::atoi(argv[++i]));
+            }
+            else if (arg == "--warmup" && has_value)
+            {
+                settings.warmup_frames = std::max(0, std::atoi(argv[++i]));
+            }
+            else if (arg == "--present" && has_value)
+            {
+                const std::string_view mode = argv[++i];
+                if (mode == "vsync")
+                {
+                    settings.present_mode = PresentMode::Vsync;
+                }
+                else if (mode == "adaptive")
+                {
+                    settings.present_mode = PresentMode::AdaptiveVsync;
+                }
+                else if (mode == "uncapped")
+                {
+                    settings.present_mode = PresentMode::Uncapped;
+                }
+            }
+            else if (arg == "--no-vsync")
+            {
+                settings.present_mode = PresentMode::Uncapped;
+            }
+            else if (arg == "--fps-cap" && has_value)
+            {
+                settings.frame_cap_hz = std::max(0, std::atoi(argv[++i]));
+            }
+            else if (arg == "--frames-in-flight" && has_value)
+            {
+                settings.max_frames_in_flight = std::max(0, std::atoi(argv[++i]));
+            }
+            else if (arg == "--fixed-rate" && has_value)
+            {
+                settings.fixed_update_rate = std::max(0, std::atoi(argv[++i]));
+            }
+            else if (arg == "--jobs" && has_value)
+            {
+                settings.job_threads = std::max(0, std::atoi(argv[++i]));
+            }
+            else if (arg == "--no-render-thread")
+            {
+                settings.render_thread = false;
+            }
+            else if (arg == "--trace" && has_value)
+            {
+                settings.trace_path = argv[++i];
+            }
+            else if (arg == "--record" && has_value)
+            {
+                settings.record_path = argv[++i];
+            }
+            else if (arg == "--replay" && has_value)
+            {
+                settings.replay_path = argv[++i];
+            }
+            else if (arg == "--program-cache" && has_value)
+            {
+                settings.program_cache_dir = argv[++i];
+            }
+            else if (arg == "--no-program-cache")
+            {
+                settings.program_cache_dir.clear();
+            }
+            else if (arg == "--mesh-cache" && has_value)
+            {
+                settings.mesh_cache_dir = argv[++i];
+            }
+            else if (arg == "--no-mesh-cache")
+            {
+                settings.mesh_cache_dir.clear();
+            }
+            else if (arg == "--no-hot-reload")
+            {
+                settings.shader_watch_dir.clear();
+            }
+        }
+        return settings;
+    }
+
     Engine::Engine(Scene* scene) : scene_(scene)
     {
     }
 
+    Engine::Engine(Scene* scene, const EngineSettings& settings) : settings_(settings), scene_(scene)
+    {
+    }
+
     void Engine::Run()
     {
+        const auto begin_start = std::chrono::steady_clock::now();
         Begin();
+        if (settings_.headless)
+        {
+            using milliseconds = std::chrono::duration<double, std::milli>;
+            const auto begin_time = std::chrono::duration_cast<milliseconds>(
+                std::chrono::steady_clock::now() - begin_start);
+            std::printf("Startup (context + Scene::Begin): %.1f ms, program cache %zu hits, %zu misses, "
+                        "mesh cache %zu hits, %zu misses\n", begin_time.count(), ProgramCache::Hits(),
+                        ProgramCache::Misses(), MeshCache::Hits(), MeshCache::Misses());
+            RunBenchmark();
+            End();
+            return;
+        }
         bool isOpen = true;
 
-        std::chrono::time_point<std::chrono::system_clock> clock = std::chrono::system_clock::now();
+        //steady_clock is monotonic, wall clock adjustments never produce negative or huge frame times
+        auto clock = std::chrono::steady_clock::now();
         while (isOpen)
         {
-            const auto start = std::chrono::system_clock::now();
+            const auto start = std::chrono::steady_clock::now();
             using seconds = std::chrono::duration<float, std::ratio<1, 1>>;
-            const auto dt = std::chrono::duration_cast<seconds>(start - clock);
+            float dt = std::chrono::duration_cast<seconds>(start - clock).count();
             clock = start;
 
-            //Manage SDL event
-            SDL_Event event;
-            while (SDL_PollEvent(&event))
+            ScopedZone frame_zone("Frame");
+            //Cap and fence waits before the input is polled, whichever thread runs the GL side
+            frame_pacer_.WaitForFrameSlot();
+            render_thread_.Enqueue([this] { frame_pacer_.BeginFrame(); });
+            //A replay substitutes the recorded dt
+            isOpen = PollEvents(dt);
+            RenderFrame(dt);
+            render_thread_.Enqueue([this] { EndFrame(); });
+            SubmitFrame();
+        }
+        End();
+    }
+
+    void Engine::RunBenchmark()
+    {
+        //A fixed step keeps the rendered content identical between runs and builds
+        constexpr float fixed_dt = 1.0f / 60.0f;
+        //GPU timestamps are read back this many frames late so the readback never stalls the pipeline,
+        //they are queried and read on the render thread, gpu_times is only read after the final flush
+        constexpr int query_latency = 4;
+
+        GLuint queries[query_latency][2];
+        std::string renderer;
+        render_thread_.Execute([&queries, &renderer]
+        {
+            glGenQueries(2 * query_latency, &queries[0][0]);
+            renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+        });
+
+        FrameStatistics cpu_times;
+        FrameStatistics gpu_times;
+        cpu_times.Reserve(settings_.benchmark_frames);
+        gpu_times.Reserve(settings_.benchmark_frames);
+
+        const auto readGpuTime = [&](const int frame)
+        {
+            GLuint64 begin = 0;
+            GLuint64 end = 0;
+            glGetQueryObjectui64v(queries[frame % query_latency][0], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(queries[frame % query_latency][1], GL_QUERY_RESULT, &end);
+            if (frame >= settings_.warmup_frames)
+            {
+                gpu_times.Add(static_cast<double>(end - begin) / 1.0e6);
+            }
+        };
+
+        const int total_frames = settings_.warmup_frames + settings_.benchmark_frames;
+        int frame = 0;
+        for (; frame < total_frames; frame++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            ScopedZone frame_zone("Frame");
+            frame_pacer_.WaitForFrameSlot();
+            render_thread_.Enqueue([this] { frame_pacer_.BeginFrame(); });
+            //Replaying a recording benchmarks its frames with their recorded dt
+            float dt = fixed_dt;
+            if (!PollEvents(dt))
+            {
+                break;
+            }
+            render_thread_.Enqueue([&queries, frame]
+            {
+                glQueryCounter(queries[frame % query_latency][0], GL_TIMESTAMP);
+            });
+            RenderFrame(dt);
+            render_thread_.Enqueue([this, &queries, &readGpuTime, frame]
             {
-                switch (event.type)
+                glQueryCounter(queries[frame % query_latency][1], GL_TIMESTAMP);
+                EndFrame();
+                if (frame >= query_latency - 1)
                 {
-                case SDL_QUIT:
-                    isOpen = false;
-                    break;
-                case SDL_WINDOWEVENT:
-                    {
-                        switch (event.window.event)
-                        {
-                        case SDL_WINDOWEVENT_CLOSE:
-                            isOpen = false;
-                            break;
-                        case SDL_WINDOWEVENT_RESIZED:
-                            {
-                                glm::uvec2 newWindowSize;
-                                newWindowSize.x = event.window.data1;
-                                newWindowSize.y = event.window.data2;
-                                //TODO do something with the new size
-                                break;
-                            }
-                        default:
-                            break;
-                        }
-                        break;
-                    }
-                case SDL_KEYDOWN:
-                    if (event.key.keysym.sym == SDLK_ESCAPE)
+                    readGpuTime(frame - (query_latency - 1));
+                }
+            });
+            SubmitFrame();
+
+            using milliseconds = std::chrono::duration<double, std::milli>;
+            const auto cpu_time = std::chrono::duration_cast<milliseconds>(std::chrono::steady_clock::now() - start);
+            if (frame >= settings_.warmup_frames)
+            {
+                cpu_times.Add(cpu_time.count());
+            }
+        }
+        //Drain the frames still in flight
+        render_thread_.Execute([&queries, &readGpuTime, frame]
+        {
+            for (int pending = std::max(0, frame - (query_latency - 1)); pending < frame; pending++)
+            {
+                readGpuTime(pending);
+            }
+            glDeleteQueries(2 * query_latency, &queries[0][0]);
+        });
+
+        std::printf("Benchmark: %zu frames (%d warm-up) at %dx%d on %s\n",
+                    cpu_times.Count(), settings_.warmup_frames, settings_.width, settings_.height,
+                    renderer.c_str());
+        FrameStatistics::PrintHeader();
+        cpu_times.PrintRow("cpu (ms)");
+        gpu_times.PrintRow("gpu (ms)");
+        GpuProfiler::Get().PrintStatistics();
+        if (frame > 0)
+        {
+            //Includes the warm-up, the GL calls of a frame do not depend on the timing
+            const GlState::Counters gl_calls = GlState::Total();
+            std::printf("GL state: %.1f calls issued, %.1f skipped per frame\n",
+                        static_cast<double>(gl_calls.issued) / frame, static_cast<double>(gl_calls.skipped) / frame);
+        }
+    }
+
+    bool Engine::PollEvents(float& dt)
+    {
+        ScopedZone zone("Engine::PollEvents");
+        events_.clear();
+        SDL_Event polled;
+        while (SDL_PollEvent(&polled))
+        {
+            events_.push_back(polled);
+        }
+        //Recording saves this frame input, replaying swaps it with the recorded frame
+        bool isOpen = input_.BeginFrame(events_, dt);
+
+        //Manage SDL event
+        for (const SDL_Event& event : events_)
+        {
+            switch (event.type)
+            {
+            case SDL_QUIT:
+                isOpen = false;
+                break;
+            case SDL_WINDOWEVENT:
+                {
+                    switch (event.window.event)
                     {
+                    case SDL_WINDOWEVENT_CLOSE:
                         isOpen = false;
+                        break;
+                    default:
+                        break;
                     }
                     break;
-                case SDL_MOUSEBUTTONDOWN:
+                }
+            case SDL_KEYDOWN:
+                if (event.key.keysym.sym == SDLK_ESCAPE)
+                {
+                    isOpen = false;
+                }
+                if (event.key.keysym.sym == SDLK_F1)
+                {
+                    GpuProfiler::Get().visible_ = !GpuProfiler::Get().visible_;
+                }
+                if (event.key.keysym.sym == SDLK_F2)
+                {
+                    CpuTracer::WriteChromeTrace(settings_.trace_path.empty() ? "trace.json" : settings_.trace_path);
+                }
+                break;
+            case SDL_MOUSEBUTTONDOWN:
+                if (event.button.button == SDL_BUTTON_LEFT)
+                {
+                    SDL_ShowCursor(SDL_DISABLE);
+                    SDL_SetRelativeMouseMode(SDL_TRUE);
+                }
+                break;
+                case SDL_MOUSEBUTTONUP:
                     if (event.button.button == SDL_BUTTON_LEFT)
                     {
-                        SDL_ShowCursor(SDL_DISABLE);
-                        SDL_SetRelativeMouseMode(SDL_TRUE);
+                        SDL_ShowCursor(SDL_ENABLE);
+                        SDL_SetRelativeMouseMode(SDL_FALSE);
                     }
-                    break;
-                    case SDL_MOUSEBUTTONUP:
-                        if (event.button.button == SDL_BUTTON_LEFT)
-                        {
-                            SDL_ShowCursor(SDL_ENABLE);
-                            SDL_SetRelativeMouseMode(SDL_FALSE);
-                        }
-                    break;
-                default:
-                    break;
-                }
-                scene_->OnEvent(event);
+                break;
+            default:
+                break;
+            }
+            scene_->OnEvent(event);
+            if (window_ != nullptr)
+            {
                 ImGui_ImplSDL2_ProcessEvent(&event);
             }
+        }
+        ResizeIfNeeded();
+        return isOpen;
+    }
+
+    void Engine::ResizeIfNeeded()
+    {
+        //Polled rather than read from SDL_WINDOWEVENT_SIZE_CHANGED, a replay drops the live window events.
+        //The drawable size is the one in pixels, larger than the window size on high DPI displays.
+        if (window_ == nullptr)
+        {
+            return;
+        }
+        int width = 0;
+        int height = 0;
+        SDL_GL_GetDrawableSize(window_, &width, &height);
+        const std::uint32_t generation = render_targets_.Generation();
+        render_targets_.Resize(width, height);
+        if (render_targets_.Generation() != generation)
+        {
+            render_thread_.Enqueue([width, height] { glViewport(0, 0, width, height); });
+        }
+    }
+
+    void Engine::RenderFrame(const float dt)
+    {
+        auto& profiler = GpuProfiler::Get();
+        //Saved shaders are rebuilt before the scene draws, the swap happens between two frames
+        render_thread_.Enqueue([this, changed_files = shader_watcher_.TakeChanges()]
+        {
+            resource_cache_.ReloadShaders(changed_files);
+        });
+        elapsed_time_ += dt;
+        const FrameData frame{static_cast<float>(elapsed_time_), dt,
+                              glm::vec2(render_targets_.Width(), render_targets_.Height())};
+        render_thread_.Enqueue([this, &profiler, frame]
+        {
+            profiler.BeginFrame();
+            frame_uniforms_.BeginFrame(frame);
             glClearColor(0, 0, 0, 0);
             glClear(GL_COLOR_BUFFER_BIT);
+        });
 
-            scene_->Update(dt.count());
+        UpdateScene(dt);
 
-            //Generate new ImGui frame
-            ImGui_ImplOpenGL3_NewFrame();
+        //Generate new ImGui frame, it lives on the simulation thread, only its draw data goes to the render thread
+        ScopedZone imgui_zone("ImGui");
+        if (window_ != nullptr)
+        {
             ImGui_ImplSDL2_NewFrame();
-            ImGui::NewFrame();
+        }
+        else
+        {
+            //No platform backend without a window, feed ImGui the offscreen size ourselves
+            ImGuiIO& io = ImGui::GetIO();
+            io.DisplaySize = ImVec2(static_cast<float>(render_targets_.Width()),
+                                    static_cast<float>(render_targets_.Height()));
+            io.DeltaTime = dt;
+        }
+        ImGui::NewFrame();
+
+        scene_->DrawImGui();
+        profiler.DrawImGui();
+        ImGui::Render();
+        auto draw_data = std::make_shared<ImGuiDrawSnapshot>(ImGui::GetDrawData());
+        render_thread_.Enqueue([&profiler, draw_data]
+        {
+            profiler.BeginPass("ImGui");
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplOpenGL3_RenderDrawData(draw_data->Get());
+            profiler.EndPass();
+            profiler.EndFrame();
+        });
+    }
+
+    void Engine::SubmitFrame()
+    {
+        if (render_thread_.IsThreaded() && scene_->SupportsLateLatch())
+        {
+            //As late as possible for the latch of this frame: once the previous frame replayed, its latch read
+            //the last sample, and right before the render thread picks this one up
+            render_thread_.WaitForReplay();
+            late_latch_.Sample();
+        }
+        render_thread_.Submit();
+    }
+
+    void Engine::UpdateScene(const float dt)
+    {
+        if (settings_.fixed_update_rate <= 0 || !scene_->SupportsFixedUpdate())
+        {
+            ScopedZone zone("Scene::Update");
+            scene_->Update(dt);
+            return;
+        }
+
+        //Drop long hitches (loading, breakpoints) instead of catching up on them step by step
+        constexpr double max_frame_time = 0.25;
+        constexpr int max_steps_per_frame = 8;
+        const double step = 1.0 / settings_.fixed_update_rate;
+        fixed_update_accumulator_ += std::min(static_cast<double>(dt), max_frame_time);
+
+        int steps = 0;
+        {
+            ScopedZone zone("Scene::FixedUpdate");
+            while (fixed_update_accumulator_ >= step && steps < max_steps_per_frame)
+            {
+                scene_->FixedUpdate(static_cast<float>(step));
+                fixed_update_accumulator_ -= step;
+                steps++;
+            }
+        }
+        if (steps == max_steps_per_frame)
+        {
+            fixed_update_accumulator_ = std::min(fixed_update_accumulator_, step);
+        }
 
-            scene_->DrawImGui();
-            ImGui::Render();
-            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        ScopedZone zone("Scene::Render");
+        scene_->Render(static_cast<float>(fixed_update_accumulator_ / step));
+    }
+
+    void Engine::EndFrame()
+    {
+        frame_uniforms_.EndFrame();
+        Present();
+        render_targets_.Collect();
+        GlState::EndFrame();
+        frame_pacer_.EndFrame();
+    }
 
+    void Engine::Present()
+    {
+        ScopedZone zone("Engine::Present");
+        if (window_ != nullptr)
+        {
             SDL_GL_SwapWindow(window_);
         }
-        End();
+        else
+        {
+            headless_context_.Present();
+        }
     }
 
-    void Engine::Begin()
+    void Engine::MakeContextCurrent(const bool current)
+    {
+        if (window_ != nullptr)
+        {
+            SDL_GL_MakeCurrent(window_, current ? glRenderContext_ : nullptr);
+        }
+        else
+        {
+            headless_context_.MakeCurrent(current);
+        }
+    }
+
+    bool Engine::BeginHeadless()
+    {
+        //Events only, scenes still poll keyboard and mouse state through SDL
+        SDL_Init(SDL_INIT_EVENTS);
+        if (!headless_context_.Create(settings_.width, settings_.height))
+        {
+            std::cerr << "Headless: no EGL context, falling back to a hidden SDL window\n";
+            return false;
+        }
+
+        //glewInit() insists on a GLX display, only resolve the GL entry points for the EGL context
+        glewExperimental = GL_TRUE;
+        if (GLEW_OK != glewContextInit())
+        {
+            assert(false && "Failed to initialize OpenGL context");
+        }
+        return true;
+    }
+
+    void Engine::BeginWindow()
     {
         SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER);
         // Set our OpenGL version.
@@ -118,23 +556,62 @@ namespace gpr5300
 
         SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
         SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
-        constexpr auto windowSize = glm::ivec2(1280, 720);
+        const auto windowSize = glm::ivec2(settings_.width, settings_.height);
+        const Uint32 windowFlags = settings_.headless ? SDL_WINDOW_HIDDEN | SDL_WINDOW_OPENGL
+                                                      : SDL_WINDOW_RESIZABLE | SDL_WINDOW_OPENGL;
         window_ = SDL_CreateWindow(
             "GPR5300",
             SDL_WINDOWPOS_UNDEFINED,
             SDL_WINDOWPOS_UNDEFINED,
             windowSize.x,
             windowSize.y,
-            SDL_WINDOW_RESIZABLE | SDL_WINDOW_OPENGL
+            windowFlags
         );
         glRenderContext_ = SDL_GL_CreateContext(window_);
-        //setting vsync
-        SDL_GL_SetSwapInterval(1);
+        //setting vsync, the hidden benchmark window never waits on the display
+        FramePacer::ApplyPresentMode(settings_.headless ? PresentMode::Uncapped : settings_.present_mode);
 
         if (GLEW_OK != glewInit())
         {
             assert(false && "Failed to initialize OpenGL context");
         }
+    }
+
+    void Engine::Begin()
+    {
+        CpuTracer::SetThreadName("Main");
+        ScopedZone zone("Engine::Begin");
+        job_system_.Create(settings_.job_threads);
+        scene_->SetJobSystem(&job_system_);
+        scene_->SetRenderThread(&render_thread_);
+        scene_->SetLateLatch(&late_latch_);
+        scene_->SetInput(&input_);
+        scene_->SetResourceCache(&resource_cache_);
+        scene_->SetRenderTargetPool(&render_targets_);
+        scene_->SetFrameUniforms(&frame_uniforms_);
+        ProgramCache::SetDirectory(settings_.program_cache_dir);
+        MeshCache::SetDirectory(settings_.mesh_cache_dir);
+        if (!settings_.headless && !settings_.shader_watch_dir.empty())
+        {
+            if (shader_watcher_.Start(settings_.shader_watch_dir))
+            {
+                resource_cache_.SetShaderSourceDirectory(settings_.shader_watch_dir);
+            }
+        }
+        if (!settings_.replay_path.empty())
+        {
+            input_.StartReplay(settings_.replay_path);
+        }
+        else if (!settings_.record_path.empty())
+        {
+            input_.StartRecording(settings_.record_path);
+        }
+        if (!settings_.headless || !BeginHeadless())
+        {
+            BeginWindow();
+        }
+        render_targets_.Resize(settings_.width, settings_.height);
+        ResizeIfNeeded();
 
         // Setup Dear ImGui context
         IMGUI_CHECKVERSION();
@@ -149,21 +626,82 @@ namespace gpr5300
         // Setup Dear ImGui style
         //ImGui::StyleColorsDark();
         ImGui::StyleColorsClassic();
-        ImGui_ImplSDL2_InitForOpenGL(window_, glRenderContext_);
+        if (window_ != nullptr)
+        {
+            ImGui_ImplSDL2_InitForOpenGL(window_, glRenderContext_);
+        }
         ImGui_ImplOpenGL3_Init("#version 300 es");
+        //Create the backend objects while the context is still current here
+        ImGui_ImplOpenGL3_NewFrame();
+
+        //The benchmark measures throughput, a software cap would only hide it
+        frame_pacer_.Create(settings_.headless ? 0 : settings_.frame_cap_hz, settings_.max_frames_in_flight);
+
+        auto& profiler = GpuProfiler::Get();
+        profiler.Create();
+        profiler.SetCollectStatistics(settings_.headless);
+
+        const bool threaded = settings_.render_thread && scene_->SupportsRenderThread();
+        frame_uniforms_.Create(settings_.max_frames_in_flight);
+        late_latch_.Create(&input_, &frame_uniforms_, !threaded);
+
+        //Let the driver compile the async programs of Scene::Begin on as many threads as it likes
+        if (GLEW_KHR_parallel_shader_compile)
+        {
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        }
 
-        scene_->Begin();
+        //From here on the context belongs to the render thread, the engine thread only records commands
+        render_thread_.Create(threaded, [this](const bool current) { MakeContextCurrent(current); });
+
+        //Scene::Begin is profiled as the first frame so load-time passes (IBL precompute...) show up
+        render_thread_.Execute([this, &profiler]
+        {
+            profiler.BeginFrame();
+            {
+                ScopedZone zone("Scene::Begin");
+                scene_->Begin();
+            }
+            profiler.EndFrame();
+        });
     }
 
     void Engine::End()
     {
-        scene_->End();
+        render_thread_.Execute([this]
+        {
+            scene_->End();
+            resource_cache_.Clear();
+            render_targets_.Clear();
+            //Ranges released later, by models a scene still holds, are ignored
+            Mesh::Arena().Destroy();
+        });
+        render_thread_.Destroy();
+        shader_watcher_.Stop();
+        job_system_.Destroy();
+        late_latch_.Destroy();
+        frame_uniforms_.Destroy();
+        input_.Stop();
 
+        GpuProfiler::Get().Destroy();
+        frame_pacer_.Destroy();
         ImGui_ImplOpenGL3_Shutdown();
-        ImGui_ImplSDL2_Shutdown();
+        if (window_ != nullptr)
+        {
+            ImGui_ImplSDL2_Shutdown();
+        }
         ImGui::DestroyContext();
-        SDL_GL_DeleteContext(glRenderContext_);
-        SDL_DestroyWindow(window_);
+        if (window_ != nullptr)
+        {
+            SDL_GL_DeleteContext(glRenderContext_);
+            SDL_DestroyWindow(window_);
+        }
+        headless_context_.Destroy();
         SDL_Quit();
+
+        if (!settings_.trace_path.empty())
+        {
+            CpuTracer::WriteChromeTrace(settings_.trace_path);
+        }
     }
 } // namespace gpr5300
@@ -1,5 +1,13 @@
 #include "file_utility.h"
 #include <fstream>
+#include <utility>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace gpr5300
 {
@@ -16,4 +24,84 @@ std::string LoadFile(std::string_view path)
         std::istreambuf_iterator<char>());
     return content;
 }
+
+MappedFile::MappedFile(const std::string& path)
+{
+#if defined(__linux__)
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return;
+    }
+    struct stat status{};
+    if (fstat(fd, &status) == 0 && status.st_size > 0)
+    {
+        const auto size = static_cast<std::size_t>(status.st_size);
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            //Read ahead, the whole file is about to be used
+            madvise(data, size, MADV_WILLNEED);
+            data_ = static_cast<const std::byte*>(data);
+            size_ = size;
+            mapped_ = true;
+        }
+    }
+    //The mapping outlives the descriptor
+    close(fd);
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        return;
+    }
+    buffer_.resize(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    if (buffer_.empty() || !file.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size())))
+    {
+        buffer_.clear();
+        return;
+    }
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+#endif
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        //A moved vector keeps its storage, data_ stays valid
+        buffer_ = std::move(other.buffer_);
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        mapped_ = std::exchange(other.mapped_, false);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+void MappedFile::Close()
+{
+#if defined(__linux__)
+    if (mapped_)
+    {
+        munmap(const_cast<std::byte*>(data_), size_);
+    }
+#endif
+    buffer_.clear();
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+}
 } // namespace gpr5300
@@ -0,0 +1,129 @@
+#include "frame_pacer.h"
+
+#include <SDL.h>
+
+#include <iostream>
+#include <thread>
+
+#include "cpu_tracer.h"
+
+namespace gpr5300
+{
+    void FramePacer::ApplyPresentMode(const PresentMode mode)
+    {
+        switch (mode)
+        {
+        case PresentMode::Vsync:
+            SDL_GL_SetSwapInterval(1);
+            break;
+        case PresentMode::AdaptiveVsync:
+            if (SDL_GL_SetSwapInterval(-1) != 0)
+            {
+                std::cerr << "Adaptive vsync not supported, falling back to vsync\n";
+                SDL_GL_SetSwapInterval(1);
+            }
+            break;
+        case PresentMode::Uncapped:
+            SDL_GL_SetSwapInterval(0);
+            break;
+        }
+    }
+
+    void FramePacer::Create(const int frame_cap_hz, const int max_frames_in_flight)
+    {
+        fences_.assign(max_frames_in_flight > 0 ? max_frames_in_flight : 0, nullptr);
+        frame_index_ = 0;
+        requested_frames_ = 0;
+        begun_frames_ = 0;
+        frame_period_ = frame_cap_hz > 0
+                            ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                std::chrono::duration<double>(1.0 / frame_cap_hz))
+                            : std::chrono::steady_clock::duration::zero();
+        next_frame_ = std::chrono::steady_clock::now();
+    }
+
+    void FramePacer::Destroy()
+    {
+        for (auto& fence : fences_)
+        {
+            if (fence != nullptr)
+            {
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+    }
+
+    void FramePacer::WaitForFrameSlot()
+    {
+        WaitForFrameCap();
+        std::unique_lock lock(mutex_);
+        //Single threaded the previous BeginFrame already ran, threaded it is the first command the render thread
+        //replays after the last Submit, so this never waits on a frame the simulation still has to submit
+        if (begun_frames_ < requested_frames_)
+        {
+            ScopedZone zone("FramePacer::WaitRenderThread");
+            frame_begun_.wait(lock, [this] { return begun_frames_ >= requested_frames_; });
+        }
+        requested_frames_++;
+    }
+
+    void FramePacer::BeginFrame()
+    {
+        if (!fences_.empty())
+        {
+            GLsync& fence = fences_[frame_index_ % fences_.size()];
+            if (fence != nullptr)
+            {
+                ScopedZone zone("FramePacer::WaitGpu");
+                //The flush bit guarantees the fence gets submitted, one second is only a safety net against a lost GPU
+                constexpr GLuint64 timeout_ns = 1'000'000'000;
+                glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns);
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+        {
+            std::scoped_lock lock(mutex_);
+            begun_frames_++;
+        }
+        frame_begun_.notify_one();
+    }
+
+    void FramePacer::EndFrame()
+    {
+        if (!fences_.empty())
+        {
+            fences_[frame_index_ % fences_.size()] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        frame_index_++;
+    }
+
+    void FramePacer::WaitForFrameCap()
+    {
+        if (frame_period_ == std::chrono::steady_clock::duration::zero())
+        {
+            return;
+        }
+        ScopedZone zone("FramePacer::FrameCap");
+        next_frame_ += frame_period_;
+        const auto now = std::chrono::steady_clock::now();
+        //Too late to hit this slot: restart the schedule instead of rushing several frames out
+        if (now > next_frame_)
+        {
+            next_frame_ = now;
+            return;
+        }
+
+        //The OS may oversleep by a scheduler tick, sleep most of the way then spin the last stretch
+        constexpr auto spin_margin = std::chrono::microseconds(1500);
+        if (next_frame_ - now > spin_margin)
+        {
+            std::this_thread::sleep_for(next_frame_ - now - spin_margin);
+        }
+        while (std::chrono::steady_clock::now() < next_frame_)
+        {
+            std::this_thread::yield();
+        }
+    }
+} // namespace gpr5300
@@ -0,0 +1,50 @@
+#include "frame_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <string>
+
+namespace gpr5300
+{
+    FrameTimeSummary FrameStatistics::Summarize() const
+    {
+        FrameTimeSummary summary;
+        if (samples_.empty())
+        {
+            return summary;
+        }
+
+        std::vector<double> sorted = samples_;
+        std::ranges::sort(sorted);
+
+        //Nearest-rank percentile on the sorted samples
+        const auto percentile = [&sorted](const double p)
+        {
+            const auto rank = static_cast<std::size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+            return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+        };
+
+        summary.min = sorted.front();
+        summary.max = sorted.back();
+        summary.mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / static_cast<double>(sorted.size());
+        summary.p50 = percentile(50.0);
+        summary.p95 = percentile(95.0);
+        summary.p99 = percentile(99.0);
+        return summary;
+    }
+
+    void FrameStatistics::PrintHeader()
+    {
+        std::printf("%-16s %9s %9s %9s %9s %9s %9s\n", "", "min", "mean", "p50", "p95", "p99", "max");
+    }
+
+    void FrameStatistics::PrintRow(const std::string_view label) const
+    {
+        const auto summary = Summarize();
+        const std::string name(label);
+        std::printf("%-16s %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f\n",
+                    name.c_str(), summary.min, summary.mean, summary.p50, summary.p95, summary.p99, summary.max);
+    }
+} // namespace gpr5300
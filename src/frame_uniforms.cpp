@@ -0,0 +1,131 @@
+#include "frame_uniforms.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "cpu_tracer.h"
+#include "gl_resources.h"
+
+namespace gpr5300
+{
+    namespace
+    {
+        //Room for a few hundred blocks a frame at the usual 256 bytes offset alignment
+        constexpr std::size_t segment_size = 64 * 1024;
+
+        struct UniformBlock
+        {
+            const char* name;
+            GLuint binding;
+        };
+
+        constexpr UniformBlock uniform_blocks[] = {
+            {"ViewData", FrameUniforms::view_binding},
+            {"FrameData", FrameUniforms::frame_binding},
+            {"LightData", FrameUniforms::light_binding},
+        };
+    }
+
+    void FrameUniforms::Create(const int frames_in_flight)
+    {
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        alignment_ = std::max<std::size_t>(alignment, 16);
+        //One more segment than the frames the GPU may be reading, the one the CPU writes
+        fences_.assign(std::max(frames_in_flight, 1) + 1, nullptr);
+        segment_ = 0;
+        offset_ = 0;
+
+        const auto size = static_cast<GLsizeiptr>(segment_size * fences_.size());
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        buffer_ = GlResources::CreateBuffer(size, nullptr, flags);
+        mapped_ = static_cast<std::byte*>(glMapNamedBufferRange(buffer_, 0, size, flags));
+    }
+
+    void FrameUniforms::Destroy()
+    {
+        for (auto& fence : fences_)
+        {
+            if (fence != nullptr)
+            {
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+        if (buffer_ != 0)
+        {
+            glUnmapNamedBuffer(buffer_);
+            glDeleteBuffers(1, &buffer_);
+        }
+        buffer_ = 0;
+        mapped_ = nullptr;
+    }
+
+    void FrameUniforms::BindBlocks(const GLuint program)
+    {
+        for (const auto& [name, binding] : uniform_blocks)
+        {
+            const GLuint index = glGetUniformBlockIndex(program, name);
+            if (index != GL_INVALID_INDEX)
+            {
+                glUniformBlockBinding(program, index, binding);
+            }
+        }
+    }
+
+    void FrameUniforms::BeginFrame(const FrameData& frame)
+    {
+        segment_ = (segment_ + 1) % fences_.size();
+        offset_ = 0;
+        GLsync& fence = fences_[segment_];
+        if (fence != nullptr)
+        {
+            ScopedZone zone("FrameUniforms::WaitGpu");
+            constexpr GLuint64 timeout_ns = 1'000'000'000;
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns);
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+        Write(&frame, sizeof(frame), frame_binding);
+    }
+
+    void FrameUniforms::EndFrame()
+    {
+        fences_[segment_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    void FrameUniforms::SetView(const ViewData& view)
+    {
+        Write(&view, sizeof(view), view_binding);
+    }
+
+    void FrameUniforms::SetLights(const LightData& lights)
+    {
+        Write(&lights, sizeof(lights), light_binding);
+    }
+
+    void FrameUniforms::Write(const void* data, const std::size_t size, const GLuint binding)
+    {
+        if (mapped_ == nullptr)
+        {
+            return;
+        }
+        const std::size_t aligned_size = (size + alignment_ - 1) / alignment_ * alignment_;
+        if (offset_ + aligned_size > segment_size)
+        {
+            //Keeps the blocks already bound rather than writing over a range still in use
+            if (!overflow_reported_)
+            {
+                std::cerr << "FrameUniforms: more than " << segment_size << " bytes of uniform blocks in a frame\n";
+                overflow_reported_ = true;
+            }
+            return;
+        }
+        const std::size_t offset = segment_ * segment_size + offset_;
+        std::memcpy(mapped_ + offset, data, size);
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer_, static_cast<GLintptr>(offset),
+                          static_cast<GLsizeiptr>(size));
+        offset_ += aligned_size;
+    }
+} // namespace gpr5300
@@ -0,0 +1,181 @@
+#include "geometry_arena.h"
+
+#include <algorithm>
+
+#include "gl_state.h"
+
+namespace gpr5300
+{
+    namespace
+    {
+        //A few scenes worth of models per page, a mesh larger than that gets a page of its own size
+        constexpr std::size_t page_vertices = 256 * 1024;
+        constexpr std::size_t page_indices = 1024 * 1024;
+        //Index of FindSpace for the end of the page
+        constexpr std::size_t page_end = static_cast<std::size_t>(-1);
+
+        //First free block of at least count elements, else page_end when the end of the page has room. False when
+        //neither has.
+        bool FindSpace(const std::vector<GeometryArena::Block>& blocks, const std::size_t used,
+                       const std::size_t capacity, const std::size_t count, std::size_t& found)
+        {
+            const auto block = std::find_if(blocks.begin(), blocks.end(), [count](const GeometryArena::Block& free)
+            {
+                return free.count >= count;
+            });
+            if (count > 0 && block != blocks.end())
+            {
+                found = static_cast<std::size_t>(block - blocks.begin());
+                return true;
+            }
+            found = page_end;
+            return used + count <= capacity;
+        }
+
+        //Offset of count elements taken from the space found by FindSpace
+        std::size_t TakeSpace(std::vector<GeometryArena::Block>& blocks, std::size_t& used, const std::size_t found,
+                              const std::size_t count)
+        {
+            if (found == page_end)
+            {
+                const std::size_t offset = used;
+                used += count;
+                return offset;
+            }
+            GeometryArena::Block& block = blocks[found];
+            const std::size_t offset = block.offset;
+            block.offset += count;
+            block.count -= count;
+            if (block.count == 0)
+            {
+                blocks.erase(blocks.begin() + static_cast<std::ptrdiff_t>(found));
+            }
+            return offset;
+        }
+
+        //Inserts the block in order and merges it with its neighbours, a block reaching the end of the used part
+        //shortens it instead
+        void FreeSpace(std::vector<GeometryArena::Block>& blocks, std::size_t& used, const std::size_t offset,
+                       const std::size_t count)
+        {
+            if (count == 0)
+            {
+                return;
+            }
+            auto block = std::lower_bound(blocks.begin(), blocks.end(), offset,
+                                          [](const GeometryArena::Block& free, const std::size_t value)
+                                          {
+                                              return free.offset < value;
+                                          });
+            block = blocks.insert(block, {offset, count});
+            if (const auto next = block + 1; next != blocks.end() && block->offset + block->count == next->offset)
+            {
+                block->count += next->count;
+                blocks.erase(next);
+            }
+            if (block != blocks.begin())
+            {
+                if (const auto previous = block - 1; previous->offset + previous->count == block->offset)
+                {
+                    previous->count += block->count;
+                    block = blocks.erase(block) - 1;
+                }
+            }
+            if (block->offset + block->count == used)
+            {
+                used = block->offset;
+                blocks.erase(block);
+            }
+        }
+    }
+
+    GeometryArena::GeometryArena(const GLsizei stride,
+                                 const std::initializer_list<GlResources::VertexAttribute> attributes)
+        : stride_(stride), attributes_(attributes)
+    {
+    }
+
+    GeometryArena::Range GeometryArena::Allocate(const void* vertices, const std::size_t vertex_count,
+                                                 const std::span<const unsigned int> indices)
+    {
+        std::size_t page_index = 0;
+        std::size_t vertex_space = page_end;
+        std::size_t index_space = page_end;
+        while (page_index < pages_.size())
+        {
+            const Page& page = pages_[page_index];
+            if (FindSpace(page.free_vertices, page.vertex_count, page.vertex_capacity, vertex_count, vertex_space) &&
+                FindSpace(page.free_indices, page.index_count, page.index_capacity, indices.size(), index_space))
+            {
+                break;
+            }
+            page_index++;
+        }
+        if (page_index == pages_.size())
+        {
+            Page page;
+            page.vertex_capacity = std::max(vertex_count, page_vertices);
+            page.index_capacity = std::max(indices.size(), page_indices);
+            page.vertex_buffer = GlResources::CreateBuffer(
+                static_cast<GLsizeiptr>(page.vertex_capacity * stride_), nullptr, GL_DYNAMIC_STORAGE_BIT);
+            page.index_buffer = GlResources::CreateBuffer(
+                static_cast<GLsizeiptr>(page.index_capacity * sizeof(unsigned int)), nullptr,
+                GL_DYNAMIC_STORAGE_BIT);
+            pages_.push_back(page);
+            pages_.back().vertex_array = CreateVertexArray(page_index);
+            vertex_space = page_end;
+            index_space = page_end;
+        }
+
+        Page& page = pages_[page_index];
+        const std::size_t vertex_offset = TakeSpace(page.free_vertices, page.vertex_count, vertex_space,
+                                                    vertex_count);
+        const std::size_t index_offset = TakeSpace(page.free_indices, page.index_count, index_space, indices.size());
+        Range range;
+        range.page = page_index;
+        range.base_vertex = static_cast<GLint>(vertex_offset);
+        range.vertex_count = static_cast<GLsizei>(vertex_count);
+        range.first_index = static_cast<GLuint>(index_offset);
+        range.index_count = static_cast<GLsizei>(indices.size());
+        if (vertex_count > 0)
+        {
+            glNamedBufferSubData(page.vertex_buffer, static_cast<GLintptr>(vertex_offset * stride_),
+                                 static_cast<GLsizeiptr>(vertex_count * stride_), vertices);
+        }
+        if (!indices.empty())
+        {
+            glNamedBufferSubData(page.index_buffer, static_cast<GLintptr>(index_offset * sizeof(unsigned int)),
+                                 static_cast<GLsizeiptr>(indices.size_bytes()), indices.data());
+        }
+        return range;
+    }
+
+    void GeometryArena::Release(const Range& range)
+    {
+        if (range.page >= pages_.size())
+        {
+            return;
+        }
+        Page& page = pages_[range.page];
+        FreeSpace(page.free_vertices, page.vertex_count, static_cast<std::size_t>(range.base_vertex),
+                  static_cast<std::size_t>(range.vertex_count));
+        FreeSpace(page.free_indices, page.index_count, range.first_index, static_cast<std::size_t>(range.index_count));
+    }
+
+    GLuint GeometryArena::CreateVertexArray(const std::size_t page) const
+    {
+        return GlResources::CreateVertexArray(pages_[page].vertex_buffer, stride_, attributes_,
+                                              pages_[page].index_buffer);
+    }
+
+    void GeometryArena::Destroy()
+    {
+        for (Page& page : pages_)
+        {
+            GlState::DeleteVertexArrays(1, &page.vertex_array);
+            glDeleteBuffers(1, &page.vertex_buffer);
+            glDeleteBuffers(1, &page.index_buffer);
+        }
+        pages_.clear();
+    }
+} // namespace gpr5300
@@ -0,0 +1,122 @@
+#include "gl_resources.h"
+
+#include <algorithm>
+#include <bit>
+#include <iostream>
+
+namespace gpr5300::GlResources
+{
+    GLuint CreateBuffer(const GLsizeiptr size, const void* data, const GLbitfield flags)
+    {
+        GLuint buffer = 0;
+        glCreateBuffers(1, &buffer);
+        if (size > 0)
+        {
+            glNamedBufferStorage(buffer, size, data, flags);
+        }
+        return buffer;
+    }
+
+    GLuint CreateVertexArray(const GLuint vertex_buffer, const GLsizei stride,
+                             const std::initializer_list<VertexAttribute> attributes, const GLuint element_buffer)
+    {
+        return CreateVertexArray(vertex_buffer, stride, std::span(attributes.begin(), attributes.size()),
+                                 element_buffer);
+    }
+
+    GLuint CreateVertexArray(const GLuint vertex_buffer, const GLsizei stride,
+                             const std::span<const VertexAttribute> attributes, const GLuint element_buffer)
+    {
+        GLuint vertex_array = 0;
+        glCreateVertexArrays(1, &vertex_array);
+        glVertexArrayVertexBuffer(vertex_array, 0, vertex_buffer, 0, stride);
+        if (element_buffer != 0)
+        {
+            glVertexArrayElementBuffer(vertex_array, element_buffer);
+        }
+        for (const VertexAttribute& attribute : attributes)
+        {
+            glEnableVertexArrayAttrib(vertex_array, attribute.index);
+            if (attribute.integer)
+            {
+                glVertexArrayAttribIFormat(vertex_array, attribute.index, attribute.size, attribute.type,
+                                           attribute.offset);
+            }
+            else
+            {
+                glVertexArrayAttribFormat(vertex_array, attribute.index, attribute.size, attribute.type, GL_FALSE,
+                                          attribute.offset);
+            }
+            glVertexArrayAttribBinding(vertex_array, attribute.index, 0);
+        }
+        return vertex_array;
+    }
+
+    GLsizei MipLevels(const GLsizei width, const GLsizei height)
+    {
+        const auto largest = static_cast<unsigned>(std::max({width, height, 1}));
+        return static_cast<GLsizei>(std::bit_width(largest));
+    }
+
+    GLuint CreateTexture2D(const GLenum internal_format, const GLsizei width, const GLsizei height,
+                           const GLsizei levels)
+    {
+        GLuint texture = 0;
+        glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+        glTextureStorage2D(texture, levels, internal_format, width, height);
+        return texture;
+    }
+
+    GLuint CreateTexture2DMultisample(const GLenum internal_format, const GLsizei width, const GLsizei height,
+                                      const GLsizei samples)
+    {
+        GLuint texture = 0;
+        glCreateTextures(GL_TEXTURE_2D_MULTISAMPLE, 1, &texture);
+        glTextureStorage2DMultisample(texture, samples, internal_format, width, height, GL_TRUE);
+        return texture;
+    }
+
+    GLuint CreateTextureCube(const GLenum internal_format, const GLsizei size, const GLsizei levels)
+    {
+        GLuint texture = 0;
+        glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &texture);
+        glTextureStorage2D(texture, levels, internal_format, size, size);
+        return texture;
+    }
+
+    void SetSampling(const GLuint texture, const GLenum min_filter, const GLenum mag_filter, const GLenum wrap)
+    {
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, static_cast<GLint>(min_filter));
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, static_cast<GLint>(mag_filter));
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_S, static_cast<GLint>(wrap));
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_T, static_cast<GLint>(wrap));
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_R, static_cast<GLint>(wrap));
+    }
+
+    GLuint CreateRenderbuffer(const GLenum internal_format, const GLsizei width, const GLsizei height,
+                              const GLsizei samples)
+    {
+        GLuint renderbuffer = 0;
+        glCreateRenderbuffers(1, &renderbuffer);
+        glNamedRenderbufferStorageMultisample(renderbuffer, samples, internal_format, width, height);
+        return renderbuffer;
+    }
+
+    GLuint CreateFramebuffer()
+    {
+        GLuint framebuffer = 0;
+        glCreateFramebuffers(1, &framebuffer);
+        return framebuffer;
+    }
+
+    bool CheckFramebuffer(const GLuint framebuffer, const std::string_view name)
+    {
+        const GLenum status = glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER);
+        if (status == GL_FRAMEBUFFER_COMPLETE)
+        {
+            return true;
+        }
+        std::cerr << "Framebuffer " << name << " not complete, status 0x" << std::hex << status << std::dec << '\n';
+        return false;
+    }
+} // namespace gpr5300::GlResources
@@ -0,0 +1,318 @@
+#include "gl_state.h"
+
+#include <array>
+#include <atomic>
+#include <unordered_map>
+
+namespace gpr5300::GlState
+{
+    namespace
+    {
+        //Value of a binding the copy does not know, after Invalidate: the next call always reaches GL
+        constexpr GLuint unknown = 0xFFFFFFFF;
+        //Texture units and targets tracked, a bind outside of them always reaches GL
+        constexpr std::size_t tracked_units = 32;
+        constexpr GLenum tracked_targets[] = {
+            GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_MULTISAMPLE, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_3D
+        };
+        constexpr std::size_t target_count = std::size(tracked_targets);
+        using TextureBindings = std::array<std::array<GLuint, target_count>, tracked_units>;
+
+        constexpr TextureBindings UnknownTextures()
+        {
+            TextureBindings textures{};
+            for (auto& unit : textures)
+            {
+                unit.fill(unknown);
+            }
+            return textures;
+        }
+
+        struct TrackedState
+        {
+            GLuint program = unknown;
+            GLuint pipeline = unknown;
+            GLuint vertex_array = unknown;
+            GLenum active_unit = unknown;
+            TextureBindings textures = UnknownTextures();
+            GLuint draw_framebuffer = unknown;
+            GLuint read_framebuffer = unknown;
+            //Missing capabilities are unknown
+            std::unordered_map<GLenum, bool> capabilities;
+            GLenum depth_function = unknown;
+            GLuint depth_mask = unknown;
+            GLenum cull_face = unknown;
+            GLenum blend_source = unknown;
+            GLenum blend_destination = unknown;
+        };
+
+        TrackedState tracked;
+        Counters frame_counters;
+        std::atomic<std::uint64_t> last_issued = 0;
+        std::atomic<std::uint64_t> last_skipped = 0;
+        std::atomic<std::uint64_t> total_issued = 0;
+        std::atomic<std::uint64_t> total_skipped = 0;
+        std::uint64_t program_deletions = 0;
+
+        //Records value, true when the call has to reach GL
+        template <typename T>
+        bool Changed(T& current, const T value)
+        {
+            if (current == value)
+            {
+                frame_counters.skipped++;
+                return false;
+            }
+            current = value;
+            frame_counters.issued++;
+            return true;
+        }
+
+        int TargetIndex(const GLenum target)
+        {
+            for (std::size_t i = 0; i < target_count; i++)
+            {
+                if (tracked_targets[i] == target)
+                {
+                    return static_cast<int>(i);
+                }
+            }
+            return -1;
+        }
+
+        void SetCapability(const GLenum capability, const bool enabled)
+        {
+            const auto [it, inserted] = tracked.capabilities.try_emplace(capability, enabled);
+            if (!inserted && it->second == enabled)
+            {
+                frame_counters.skipped++;
+                return;
+            }
+            it->second = enabled;
+            frame_counters.issued++;
+            if (enabled)
+            {
+                glEnable(capability);
+            }
+            else
+            {
+                glDisable(capability);
+            }
+        }
+    }
+
+    void UseProgram(const GLuint program)
+    {
+        if (Changed(tracked.program, program))
+        {
+            glUseProgram(program);
+        }
+    }
+
+    void BindProgramPipeline(const GLuint pipeline)
+    {
+        if (Changed(tracked.pipeline, pipeline))
+        {
+            glBindProgramPipeline(pipeline);
+        }
+    }
+
+    void BindVertexArray(const GLuint vertex_array)
+    {
+        if (Changed(tracked.vertex_array, vertex_array))
+        {
+            glBindVertexArray(vertex_array);
+        }
+    }
+
+    void ActiveTexture(const GLenum unit)
+    {
+        if (Changed(tracked.active_unit, unit))
+        {
+            glActiveTexture(unit);
+        }
+    }
+
+    void BindTexture(const GLenum target, const GLuint texture)
+    {
+        const std::size_t unit = tracked.active_unit - GL_TEXTURE0;
+        const int target_index = TargetIndex(target);
+        if (tracked.active_unit == unknown || unit >= tracked_units || target_index < 0)
+        {
+            frame_counters.issued++;
+            glBindTexture(target, texture);
+            return;
+        }
+        if (Changed(tracked.textures[unit][target_index], texture))
+        {
+            glBindTexture(target, texture);
+        }
+    }
+
+    void BindFramebuffer(const GLenum target, const GLuint framebuffer)
+    {
+        const bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+        const bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+        if ((!draw || tracked.draw_framebuffer == framebuffer) && (!read || tracked.read_framebuffer == framebuffer))
+        {
+            frame_counters.skipped++;
+            return;
+        }
+        if (draw)
+        {
+            tracked.draw_framebuffer = framebuffer;
+        }
+        if (read)
+        {
+            tracked.read_framebuffer = framebuffer;
+        }
+        frame_counters.issued++;
+        glBindFramebuffer(target, framebuffer);
+    }
+
+    void Enable(const GLenum capability)
+    {
+        SetCapability(capability, true);
+    }
+
+    void Disable(const GLenum capability)
+    {
+        SetCapability(capability, false);
+    }
+
+    void DepthFunc(const GLenum function)
+    {
+        if (Changed(tracked.depth_function, function))
+        {
+            glDepthFunc(function);
+        }
+    }
+
+    void DepthMask(const GLboolean mask)
+    {
+        if (Changed(tracked.depth_mask, static_cast<GLuint>(mask)))
+        {
+            glDepthMask(mask);
+        }
+    }
+
+    void CullFace(const GLenum mode)
+    {
+        if (Changed(tracked.cull_face, mode))
+        {
+            glCullFace(mode);
+        }
+    }
+
+    void BlendFunc(const GLenum source, const GLenum destination)
+    {
+        if (tracked.blend_source == source && tracked.blend_destination == destination)
+        {
+            frame_counters.skipped++;
+            return;
+        }
+        tracked.blend_source = source;
+        tracked.blend_destination = destination;
+        frame_counters.issued++;
+        glBlendFunc(source, destination);
+    }
+
+    void DeleteProgram(const GLuint program)
+    {
+        //A program in use stays current until replaced, only flagged for deletion
+        if (tracked.program == program)
+        {
+            tracked.program = unknown;
+        }
+        program_deletions++;
+        glDeleteProgram(program);
+    }
+
+    std::uint64_t ProgramDeletions()
+    {
+        return program_deletions;
+    }
+
+    void DeleteProgramPipelines(const GLsizei count, const GLuint* pipelines)
+    {
+        for (GLsizei i = 0; i < count; i++)
+        {
+            if (tracked.pipeline == pipelines[i])
+            {
+                tracked.pipeline = 0;
+            }
+        }
+        glDeleteProgramPipelines(count, pipelines);
+    }
+
+    void DeleteVertexArrays(const GLsizei count, const GLuint* vertex_arrays)
+    {
+        for (GLsizei i = 0; i < count; i++)
+        {
+            if (tracked.vertex_array == vertex_arrays[i])
+            {
+                tracked.vertex_array = 0;
+            }
+        }
+        glDeleteVertexArrays(count, vertex_arrays);
+    }
+
+    void DeleteTextures(const GLsizei count, const GLuint* textures)
+    {
+        for (GLsizei i = 0; i < count; i++)
+        {
+            for (auto& unit : tracked.textures)
+            {
+                for (GLuint& binding : unit)
+                {
+                    if (binding == textures[i])
+                    {
+                        binding = 0;
+                    }
+                }
+            }
+        }
+        glDeleteTextures(count, textures);
+    }
+
+    void DeleteFramebuffers(const GLsizei count, const GLuint* framebuffers)
+    {
+        for (GLsizei i = 0; i < count; i++)
+        {
+            if (tracked.draw_framebuffer == framebuffers[i])
+            {
+                tracked.draw_framebuffer = 0;
+            }
+            if (tracked.read_framebuffer == framebuffers[i])
+            {
+                tracked.read_framebuffer = 0;
+            }
+        }
+        glDeleteFramebuffers(count, framebuffers);
+    }
+
+    void Invalidate()
+    {
+        tracked = TrackedState{};
+    }
+
+    void EndFrame()
+    {
+        last_issued = frame_counters.issued;
+        last_skipped = frame_counters.skipped;
+        total_issued += frame_counters.issued;
+        total_skipped += frame_counters.skipped;
+        frame_counters = {};
+        Invalidate();
+    }
+
+    Counters LastFrame()
+    {
+        return {last_issued.load(), last_skipped.load()};
+    }
+
+    Counters Total()
+    {
+        return {total_issued.load(), total_skipped.load()};
+    }
+} // namespace gpr5300::GlState
@@ -0,0 +1,318 @@
+#include "gpu_profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include <imgui.h>
+
+#include "gl_state.h"
+
+namespace gpr5300
+{
+    GpuProfiler& GpuProfiler::Get()
+    {
+        static GpuProfiler profiler;
+        return profiler;
+    }
+
+    void GpuProfiler::Create()
+    {
+        for (auto& frame : frames_)
+        {
+            glGenQueries(1, &frame.frame_begin);
+            glGenQueries(1, &frame.frame_end);
+        }
+        created_ = true;
+    }
+
+    void GpuProfiler::Destroy()
+    {
+        if (!created_)
+        {
+            return;
+        }
+        for (auto& frame : frames_)
+        {
+            glDeleteQueries(1, &frame.frame_begin);
+            glDeleteQueries(1, &frame.frame_end);
+            if (!frame.pool.empty())
+            {
+                glDeleteQueries(static_cast<GLsizei>(frame.pool.size()), frame.pool.data());
+            }
+            frame = {};
+        }
+        created_ = false;
+    }
+
+    void GpuProfiler::BeginFrame()
+    {
+        if (!created_)
+        {
+            return;
+        }
+        auto& frame = frames_[frame_index_ % frames_in_flight];
+        //This slot was last used frames_in_flight frames ago, its queries should be done by now
+        if (frame.pending)
+        {
+            Resolve(frame);
+        }
+        frame.passes.clear();
+        frame.frame_index = frame_index_;
+        frame.pending = true;
+        glQueryCounter(frame.frame_begin, GL_TIMESTAMP);
+    }
+
+    void GpuProfiler::EndFrame()
+    {
+        if (!created_)
+        {
+            return;
+        }
+        if (pass_depth_ > 0)
+        {
+            pass_depth_ = 1;
+            EndPass();
+        }
+        glQueryCounter(frames_[frame_index_ % frames_in_flight].frame_end, GL_TIMESTAMP);
+        std::scoped_lock lock(history_mutex_);
+        frame_index_++;
+    }
+
+    void GpuProfiler::BeginPass(const std::string_view name)
+    {
+        //Nested passes are folded in the outermost one
+        if (!created_ || pass_depth_++ > 0)
+        {
+            return;
+        }
+        auto& frame = frames_[frame_index_ % frames_in_flight];
+        const std::size_t query_index = frame.passes.size();
+        if (query_index >= frame.pool.size())
+        {
+            GLuint query = 0;
+            glGenQueries(1, &query);
+            frame.pool.push_back(query);
+        }
+        const GLuint query = frame.pool[query_index];
+        frame.passes.push_back({FindOrAddPass(name), query});
+        glBeginQuery(GL_TIME_ELAPSED, query);
+    }
+
+    void GpuProfiler::EndPass()
+    {
+        if (!created_ || pass_depth_ == 0 || --pass_depth_ > 0)
+        {
+            return;
+        }
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+
+    std::size_t GpuProfiler::FindOrAddPass(const std::string_view name)
+    {
+        std::scoped_lock lock(history_mutex_);
+        const auto it = std::ranges::find_if(passes_, [name](const PassHistory& pass) { return pass.name == name; });
+        if (it != passes_.end())
+        {
+            return static_cast<std::size_t>(it - passes_.begin());
+        }
+        passes_.push_back({std::string(name)});
+        return passes_.size() - 1;
+    }
+
+    void GpuProfiler::Resolve(FrameQueries& frame)
+    {
+        std::scoped_lock lock(history_mutex_);
+        frame.pending = false;
+        //Queries complete in order, if the last timestamp is ready every pass of that frame is too
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(frame.frame_end, GL_QUERY_RESULT_AVAILABLE, &available);
+        const std::size_t slot = frame.frame_index % history_length;
+        if (!available)
+        {
+            //Never block, this frame is simply missing from the timeline
+            for (auto& pass : passes_)
+            {
+                pass.samples[slot] = 0.0f;
+                pass.valid[slot] = false;
+            }
+            frame_history_.samples[slot] = 0.0f;
+            frame_history_.valid[slot] = false;
+            dropped_frames_++;
+            return;
+        }
+
+        std::vector<float> pass_times(passes_.size(), 0.0f);
+        std::vector<bool> pass_ran(passes_.size(), false);
+        for (const auto& pass : frame.passes)
+        {
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(pass.query, GL_QUERY_RESULT, &elapsed);
+            pass_times[pass.pass_index] += static_cast<float>(static_cast<double>(elapsed) / 1.0e6);
+            pass_ran[pass.pass_index] = true;
+        }
+        for (std::size_t i = 0; i < passes_.size(); i++)
+        {
+            passes_[i].samples[slot] = 0.0f;
+            passes_[i].valid[slot] = false;
+            if (pass_ran[i])
+            {
+                Record(passes_[i], slot, pass_times[i]);
+            }
+        }
+
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(frame.frame_begin, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(frame.frame_end, GL_QUERY_RESULT, &end);
+        Record(frame_history_, slot, static_cast<float>(static_cast<double>(end - begin) / 1.0e6));
+    }
+
+    std::uint64_t GpuProfiler::ResolvedEnd() const
+    {
+        constexpr auto in_flight = static_cast<std::uint64_t>(frames_in_flight);
+        return frame_index_ > in_flight ? frame_index_ - in_flight : 0;
+    }
+
+    void GpuProfiler::Record(PassHistory& history, const std::size_t slot, const float milliseconds) const
+    {
+        history.samples[slot] = milliseconds;
+        history.valid[slot] = true;
+        history.last = milliseconds;
+        if (collect_statistics_)
+        {
+            history.statistics.Add(milliseconds);
+        }
+    }
+
+    void GpuProfiler::DrawImGui()
+    {
+        if (!visible_)
+        {
+            return;
+        }
+        std::unique_lock lock(history_mutex_);
+        ImGui::Begin("GPU Profiler", &visible_);
+        ImGui::Text("Frame: %.3f ms (%d frames in flight, %llu dropped)", frame_history_.last, frames_in_flight,
+                    static_cast<unsigned long long>(dropped_frames_));
+        const GlState::Counters gl_calls = GlState::LastFrame();
+        ImGui::Text("GL state: %llu calls issued, %llu skipped", static_cast<unsigned long long>(gl_calls.issued),
+                    static_cast<unsigned long long>(gl_calls.skipped));
+        const bool export_csv = ImGui::Button("Export CSV");
+
+        //Plot oldest to newest, the newest sample is the one of the last resolved frame
+        const int offset = static_cast<int>(ResolvedEnd() % history_length);
+        const auto drawPass = [offset](const PassHistory& pass)
+        {
+            //Only over the frames in which the pass was measured, conditional passes would read too low otherwise
+            float max = 0.0f;
+            float sum = 0.0f;
+            int count = 0;
+            for (int i = 0; i < history_length; i++)
+            {
+                if (pass.valid[i])
+                {
+                    max = std::max(max, pass.samples[i]);
+                    sum += pass.samples[i];
+                    count++;
+                }
+            }
+            const float avg = count > 0 ? sum / static_cast<float>(count) : 0.0f;
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(pass.name.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", pass.last);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", avg);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", max);
+            ImGui::TableNextColumn();
+            ImGui::PushID(pass.name.c_str());
+            ImGui::PlotLines("##timeline", pass.samples.data(), history_length, offset, nullptr, 0.0f, max,
+                             ImVec2(240.0f, 24.0f));
+            ImGui::PopID();
+        };
+
+        if (ImGui::BeginTable("passes", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Pass");
+            ImGui::TableSetupColumn("Last (ms)");
+            ImGui::TableSetupColumn("Avg (ms)");
+            ImGui::TableSetupColumn("Max (ms)");
+            ImGui::TableSetupColumn("Timeline");
+            ImGui::TableHeadersRow();
+            drawPass(frame_history_);
+            for (const auto& pass : passes_)
+            {
+                drawPass(pass);
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+        lock.unlock();
+
+        if (export_csv)
+        {
+            ExportCsv("gpu_profile.csv");
+        }
+    }
+
+    bool GpuProfiler::ExportCsv(const std::string_view path) const
+    {
+        std::ofstream file(std::string(path).c_str());
+        if (!file)
+        {
+            std::cerr << "Failed to write GPU profile to " << path << '\n';
+            return false;
+        }
+        std::scoped_lock lock(history_mutex_);
+        file << "frame," << frame_history_.name;
+        for (const auto& pass : passes_)
+        {
+            file << ',' << pass.name;
+        }
+        file << '\n';
+
+        //Rolling history, oldest frame first, times in milliseconds
+        const std::uint64_t end = ResolvedEnd();
+        const std::uint64_t first = end > history_length ? end - history_length : 0;
+        for (std::uint64_t frame = first; frame < end; frame++)
+        {
+            //Frames not measured are left empty rather than written as 0 ms
+            const std::size_t slot = frame % history_length;
+            file << frame << ',';
+            if (frame_history_.valid[slot])
+            {
+                file << frame_history_.samples[slot];
+            }
+            for (const auto& pass : passes_)
+            {
+                file << ',';
+                if (pass.valid[slot])
+                {
+                    file << pass.samples[slot];
+                }
+            }
+            file << '\n';
+        }
+        std::cout << "GPU profile written to " << path << '\n';
+        return true;
+    }
+
+    void GpuProfiler::PrintStatistics() const
+    {
+        std::scoped_lock lock(history_mutex_);
+        std::printf("GPU passes (ms)\n");
+        FrameStatistics::PrintHeader();
+        frame_history_.statistics.PrintRow(frame_history_.name);
+        for (const auto& pass : passes_)
+        {
+            if (pass.statistics.Count() > 0)
+            {
+                pass.statistics.PrintRow(pass.name);
+            }
+        }
+    }
+} // namespace gpr5300
@@ -0,0 +1,158 @@
+#include "headless_context.h"
+
+#include <iostream>
+
+#ifdef GPR5300_HEADLESS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+namespace gpr5300
+{
+#ifdef GPR5300_HEADLESS_EGL
+    bool HeadlessContext::Create(const int width, const int height)
+    {
+        EGLDisplay display = EGL_NO_DISPLAY;
+        //Prefer the surfaceless platform so no X11/Wayland connection is ever attempted
+        const auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay)
+        {
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+        if (display == EGL_NO_DISPLAY)
+        {
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+        {
+            std::cerr << "Headless: failed to initialize EGL display\n";
+            return false;
+        }
+        display_ = display;
+
+        if (!eglBindAPI(EGL_OPENGL_API))
+        {
+            std::cerr << "Headless: EGL does not support desktop OpenGL\n";
+            Destroy();
+            return false;
+        }
+
+        constexpr EGLint config_attributes[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_ALPHA_SIZE, 8,
+            EGL_DEPTH_SIZE, 24,
+            EGL_STENCIL_SIZE, 8,
+            EGL_NONE
+        };
+        EGLConfig config = nullptr;
+        EGLint config_count = 0;
+        if (!eglChooseConfig(display, config_attributes, &config, 1, &config_count) || config_count == 0)
+        {
+            std::cerr << "Headless: no EGL config with pbuffer support\n";
+            Destroy();
+            return false;
+        }
+
+        const EGLint surface_attributes[] = {
+            EGL_WIDTH, width,
+            EGL_HEIGHT, height,
+            EGL_NONE
+        };
+        surface_ = eglCreatePbufferSurface(display, config, surface_attributes);
+        if (surface_ == EGL_NO_SURFACE)
+        {
+            std::cerr << "Headless: failed to create pbuffer surface\n";
+            Destroy();
+            return false;
+        }
+
+        constexpr EGLint context_attributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 4,
+            EGL_CONTEXT_MINOR_VERSION, 5,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        context_ = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+        if (context_ == EGL_NO_CONTEXT)
+        {
+            std::cerr << "Headless: failed to create OpenGL 4.5 core context\n";
+            context_ = nullptr;
+            Destroy();
+            return false;
+        }
+
+        if (!eglMakeCurrent(display, surface_, surface_, context_))
+        {
+            std::cerr << "Headless: failed to make context current\n";
+            Destroy();
+            return false;
+        }
+        //Never wait on a display, even if the implementation would honour it for pbuffers
+        eglSwapInterval(display, 0);
+        return true;
+    }
+
+    void HeadlessContext::Destroy()
+    {
+        if (display_ == nullptr)
+        {
+            return;
+        }
+        eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context_ != nullptr)
+        {
+            eglDestroyContext(display_, context_);
+            context_ = nullptr;
+        }
+        if (surface_ != nullptr)
+        {
+            eglDestroySurface(display_, surface_);
+            surface_ = nullptr;
+        }
+        eglTerminate(display_);
+        display_ = nullptr;
+    }
+
+    void HeadlessContext::Present() const
+    {
+        //Swapping a pbuffer shows nothing but still flushes the frame to the GPU, like a real swap would
+        eglSwapBuffers(display_, surface_);
+    }
+
+    void HeadlessContext::MakeCurrent(const bool current) const
+    {
+        if (current)
+        {
+            //The bound client API is per thread state
+            eglBindAPI(EGL_OPENGL_API);
+            eglMakeCurrent(display_, surface_, surface_, context_);
+        }
+        else
+        {
+            eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        }
+    }
+#else
+    bool HeadlessContext::Create(int, int)
+    {
+        return false;
+    }
+
+    void HeadlessContext::Destroy()
+    {
+    }
+
+    void HeadlessContext::Present() const
+    {
+    }
+
+    void HeadlessContext::MakeCurrent(bool) const
+    {
+    }
+#endif
+} // namespace gpr5300
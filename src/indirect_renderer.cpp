@@ -0,0 +1,120 @@
+#include "indirect_renderer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "cpu_tracer.h"
+#include "gl_resources.h"
+#include "gl_state.h"
+
+namespace gpr5300
+{
+    namespace
+    {
+        bool SameTextures(const std::vector<Texture>& a, const std::vector<Texture>& b)
+        {
+            return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const Texture& left, const Texture& right)
+            {
+                return left.id == right.id && left.type == right.type;
+            });
+        }
+    }
+
+    bool IndirectRenderer::Supported()
+    {
+        return GLEW_ARB_shader_draw_parameters != 0;
+    }
+
+    void IndirectRenderer::Create()
+    {
+        GLint alignment = 0;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        alignment_ = std::max<std::size_t>(alignment, 16);
+        //Names only, the storage is specified again by every Submit
+        command_buffer_ = GlResources::CreateBuffer(0, nullptr);
+        draw_buffer_ = GlResources::CreateBuffer(0, nullptr);
+    }
+
+    void IndirectRenderer::Destroy()
+    {
+        if (command_buffer_ != 0)
+        {
+            glDeleteBuffers(1, &command_buffer_);
+            glDeleteBuffers(1, &draw_buffer_);
+            command_buffer_ = 0;
+            draw_buffer_ = 0;
+        }
+        batches_.clear();
+    }
+
+    void IndirectRenderer::Add(const Mesh& mesh, const DrawData& data)
+    {
+        const GeometryArena::Range& range = mesh.Range();
+        auto batch = std::find_if(batches_.begin(), batches_.end(), [&range, &mesh](const Batch& candidate)
+        {
+            return candidate.page == range.page && SameTextures(candidate.textures, mesh.textures_);
+        });
+        if (batch == batches_.end())
+        {
+            batch = batches_.insert(batches_.end(), Batch{range.page, mesh.textures_, {}, {}});
+        }
+        DrawElementsIndirectCommand command;
+        command.count = static_cast<GLuint>(range.index_count);
+        command.instance_count = 1;
+        command.first_index = range.first_index;
+        command.base_vertex = range.base_vertex;
+        batch->commands.push_back(command);
+        batch->draws.push_back(data);
+    }
+
+    void IndirectRenderer::Submit(const GLuint shader)
+    {
+        ScopedZone zone("IndirectRenderer::Submit");
+        draw_count_ = 0;
+        call_count_ = batches_.size();
+        if (batches_.empty())
+        {
+            return;
+        }
+
+        //Commands back to back, the DrawData of each batch from an aligned offset: gl_DrawIDARB restarts at 0 for
+        //every call
+        commands_.clear();
+        draw_data_.clear();
+        std::vector<std::size_t> draw_offsets;
+        draw_offsets.reserve(batches_.size());
+        for (const Batch& batch : batches_)
+        {
+            commands_.insert(commands_.end(), batch.commands.begin(), batch.commands.end());
+            const std::size_t offset = (draw_data_.size() + alignment_ - 1) / alignment_ * alignment_;
+            const std::size_t size = batch.draws.size() * sizeof(DrawData);
+            draw_data_.resize(offset + size);
+            std::memcpy(draw_data_.data() + offset, batch.draws.data(), size);
+            draw_offsets.push_back(offset);
+        }
+        //Respecifying the storage orphans the previous one, the GPU may still read it without stalling the write
+        const std::size_t command_size = commands_.size() * sizeof(DrawElementsIndirectCommand);
+        glNamedBufferData(command_buffer_, static_cast<GLsizeiptr>(command_size), commands_.data(), GL_STREAM_DRAW);
+        glNamedBufferData(draw_buffer_, static_cast<GLsizeiptr>(draw_data_.size()), draw_data_.data(),
+                          GL_STREAM_DRAW);
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer_);
+        std::size_t first_command = 0;
+        for (std::size_t i = 0; i < batches_.size(); i++)
+        {
+            const Batch& batch = batches_[i];
+            Mesh::BindTextures(shader, batch.textures);
+            GlState::BindVertexArray(Mesh::Arena().GetPage(batch.page).vertex_array);
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, draw_data_binding, draw_buffer_,
+                              static_cast<GLintptr>(draw_offsets[i]),
+                              static_cast<GLsizeiptr>(batch.draws.size() * sizeof(DrawData)));
+            const std::size_t command_offset = first_command * sizeof(DrawElementsIndirectCommand);
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const void*>(command_offset),
+                                        static_cast<GLsizei>(batch.commands.size()), 0);
+            first_command += batch.commands.size();
+            draw_count_ += batch.commands.size();
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        batches_.clear();
+    }
+} // namespace gpr5300
@@ -0,0 +1,267 @@
+#include "input.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace gpr5300
+{
+    namespace
+    {
+        constexpr std::uint32_t input_magic = 0x49525047; //"GPRI"
+        constexpr std::uint32_t input_version = 1;
+
+        //Device input only: window events describe the live window and drop/user events carry pointers
+        bool IsReplayable(const SDL_Event& event)
+        {
+            switch (event.type)
+            {
+            case SDL_KEYDOWN:
+            case SDL_KEYUP:
+            case SDL_TEXTINPUT:
+            case SDL_MOUSEMOTION:
+            case SDL_MOUSEBUTTONDOWN:
+            case SDL_MOUSEBUTTONUP:
+            case SDL_MOUSEWHEEL:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        bool IsQuitRequest(const SDL_Event& event)
+        {
+            return event.type == SDL_QUIT ||
+                (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_CLOSE) ||
+                (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE);
+        }
+
+        template <typename T>
+        void WriteValue(std::ofstream& file, const T& value)
+        {
+            file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        bool ReadValue(std::ifstream& file, T& value)
+        {
+            return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+        }
+    }
+
+    bool Input::StartRecording(const std::string_view path)
+    {
+        record_file_.open(std::string(path), std::ios::binary);
+        if (!record_file_)
+        {
+            std::cerr << "Failed to open input recording " << path << '\n';
+            return false;
+        }
+        WriteValue(record_file_, input_magic);
+        WriteValue(record_file_, input_version);
+        WriteValue(record_file_, static_cast<std::uint32_t>(sizeof(SDL_Event)));
+        keys_.fill(0);
+        recording_ = true;
+        return true;
+    }
+
+    bool Input::StartReplay(const std::string_view path)
+    {
+        replay_file_.open(std::string(path), std::ios::binary);
+        std::uint32_t magic = 0;
+        std::uint32_t version = 0;
+        std::uint32_t event_size = 0;
+        if (!replay_file_ || !ReadValue(replay_file_, magic) || !ReadValue(replay_file_, version) ||
+            !ReadValue(replay_file_, event_size))
+        {
+            std::cerr << "Failed to open input replay " << path << '\n';
+            replay_file_.close();
+            return false;
+        }
+        //Events are stored raw, a recording from another SDL build may not have the same layout
+        if (magic != input_magic || version != input_version || event_size != sizeof(SDL_Event))
+        {
+            std::cerr << "Input replay " << path << " has an incompatible format\n";
+            replay_file_.close();
+            return false;
+        }
+        keys_.fill(0);
+        replaying_ = true;
+        return true;
+    }
+
+    void Input::Stop()
+    {
+        if (recording_)
+        {
+            record_file_.close();
+            recording_ = false;
+        }
+        if (replaying_)
+        {
+            replay_file_.close();
+            replaying_ = false;
+        }
+    }
+
+    bool Input::BeginFrame(std::vector<SDL_Event>& events, float& dt)
+    {
+        int mouse_x = 0;
+        int mouse_y = 0;
+        //What the late latch took out of SDL during the previous frame belongs to this one
+        const int late_x = late_x_;
+        const int late_y = late_y_;
+        late_x_ = 0;
+        late_y_ = 0;
+        late_sampled_ = false;
+        if (replaying_)
+        {
+            const bool quit = std::ranges::any_of(events, IsQuitRequest);
+            events.clear();
+            if (quit || !ReadFrame(events, dt, mouse_x, mouse_y))
+            {
+                std::cout << "Input replay finished\n";
+                Stop();
+                return false;
+            }
+        }
+        else
+        {
+            mouse_buttons_ = SDL_GetRelativeMouseState(&mouse_x, &mouse_y);
+            mouse_x += late_x;
+            mouse_y += late_y;
+            if (recording_)
+            {
+                WriteFrame(events, dt, mouse_x, mouse_y);
+            }
+        }
+        mouse_x_ += mouse_x;
+        mouse_y_ += mouse_y;
+        return true;
+    }
+
+    const Uint8* Input::GetKeyboardState() const
+    {
+        return replaying_ ? keys_.data() : SDL_GetKeyboardState(nullptr);
+    }
+
+    Uint32 Input::GetRelativeMouseState(int* x, int* y)
+    {
+        *x = mouse_x_;
+        *y = mouse_y_;
+        mouse_x_ = 0;
+        mouse_y_ = 0;
+        return mouse_buttons_;
+    }
+
+    void Input::SampleLateMouseMotion(int* x, int* y)
+    {
+        if (replaying_ && !late_sampled_)
+        {
+            //Peek the dt and motion heading the next frame, ReadFrame still reads it whole
+            const auto position = replay_file_.tellg();
+            float dt = 0.0f;
+            std::int32_t next_x = 0;
+            std::int32_t next_y = 0;
+            if (ReadValue(replay_file_, dt) && ReadValue(replay_file_, next_x) && ReadValue(replay_file_, next_y))
+            {
+                late_x_ = next_x;
+                late_y_ = next_y;
+            }
+            replay_file_.clear();
+            replay_file_.seekg(position);
+        }
+        else if (!replaying_)
+        {
+            //The events stay queued for the next SDL_PollEvent, only the relative motion is taken here
+            SDL_PumpEvents();
+            int pumped_x = 0;
+            int pumped_y = 0;
+            SDL_GetRelativeMouseState(&pumped_x, &pumped_y);
+            late_x_ += pumped_x;
+            late_y_ += pumped_y;
+        }
+        late_sampled_ = true;
+        *x = late_x_;
+        *y = late_y_;
+    }
+
+    //Frame layout: dt, mouse x/y/buttons, changed key count + (scancode, state) pairs, event count + raw events
+    void Input::WriteFrame(const std::vector<SDL_Event>& events, const float dt, const int mouse_x, const int mouse_y)
+    {
+        WriteValue(record_file_, dt);
+        WriteValue(record_file_, static_cast<std::int32_t>(mouse_x));
+        WriteValue(record_file_, static_cast<std::int32_t>(mouse_y));
+        WriteValue(record_file_, static_cast<std::uint32_t>(mouse_buttons_));
+
+        const Uint8* keys = SDL_GetKeyboardState(nullptr);
+        std::uint16_t changed_keys = 0;
+        for (std::size_t i = 0; i < keys_.size(); i++)
+        {
+            changed_keys += keys[i] != keys_[i];
+        }
+        WriteValue(record_file_, changed_keys);
+        for (std::size_t i = 0; i < keys_.size(); i++)
+        {
+            if (keys[i] != keys_[i])
+            {
+                WriteValue(record_file_, static_cast<std::uint16_t>(i));
+                WriteValue(record_file_, keys[i]);
+                keys_[i] = keys[i];
+            }
+        }
+
+        const auto event_count = static_cast<std::uint16_t>(std::ranges::count_if(events, IsReplayable));
+        WriteValue(record_file_, event_count);
+        for (const auto& event : events)
+        {
+            if (IsReplayable(event))
+            {
+                WriteValue(record_file_, event);
+            }
+        }
+    }
+
+    bool Input::ReadFrame(std::vector<SDL_Event>& events, float& dt, int& mouse_x, int& mouse_y)
+    {
+        std::int32_t x = 0;
+        std::int32_t y = 0;
+        std::uint32_t buttons = 0;
+        std::uint16_t changed_keys = 0;
+        if (!ReadValue(replay_file_, dt) || !ReadValue(replay_file_, x) || !ReadValue(replay_file_, y) ||
+            !ReadValue(replay_file_, buttons) || !ReadValue(replay_file_, changed_keys))
+        {
+            return false;
+        }
+        for (std::uint16_t i = 0; i < changed_keys; i++)
+        {
+            std::uint16_t scancode = 0;
+            Uint8 state = 0;
+            if (!ReadValue(replay_file_, scancode) || !ReadValue(replay_file_, state) || scancode >= keys_.size())
+            {
+                return false;
+            }
+            keys_[scancode] = state;
+        }
+
+        std::uint16_t event_count = 0;
+        if (!ReadValue(replay_file_, event_count))
+        {
+            return false;
+        }
+        for (std::uint16_t i = 0; i < event_count; i++)
+        {
+            SDL_Event event;
+            if (!ReadValue(replay_file_, event))
+            {
+                return false;
+            }
+            events.push_back(event);
+        }
+        mouse_x = x;
+        mouse_y = y;
+        mouse_buttons_ = buttons;
+        return true;
+    }
+} // namespace gpr5300
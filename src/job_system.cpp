@@ -0,0 +1,215 @@
+#include "job_system.h"
+
+#include <string>
+
+#include "cpu_tracer.h"
+
+namespace gpr5300
+{
+    namespace
+    {
+        //Which queue the current thread owns, foreign threads (not created by the system) have none
+        struct JobThreadInfo
+        {
+            const JobSystem* system = nullptr;
+            std::size_t index = 0;
+        };
+
+        thread_local JobThreadInfo job_thread_info;
+    }
+
+    void JobSystem::Create(const int thread_count)
+    {
+        const int hardware_threads = static_cast<int>(std::thread::hardware_concurrency());
+        const std::size_t count = std::max(1, thread_count > 0 ? thread_count : hardware_threads);
+        queues_.clear();
+        for (std::size_t i = 0; i < count; i++)
+        {
+            queues_.push_back(std::make_unique<WorkQueue>());
+        }
+        job_thread_info = {this, 0};
+        running_ = true;
+        for (std::size_t i = 1; i < count; i++)
+        {
+            workers_.emplace_back(&JobSystem::WorkerLoop, this, i);
+        }
+    }
+
+    void JobSystem::Destroy()
+    {
+        if (queues_.empty())
+        {
+            return;
+        }
+        running_ = false;
+        {
+            std::scoped_lock lock(sleep_mutex_);
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_)
+        {
+            worker.join();
+        }
+        workers_.clear();
+        Job job;
+        while (Pop(job))
+        {
+            Execute(job);
+        }
+        queues_.clear();
+        job_thread_info = {};
+    }
+
+    void JobSystem::Schedule(std::function<void()> task, JobCounter* counter)
+    {
+        if (counter != nullptr)
+        {
+            counter->pending_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (queues_.empty())
+        {
+            Job job{std::move(task), counter};
+            Execute(job);
+            return;
+        }
+        Push({std::move(task), counter});
+    }
+
+    void JobSystem::ScheduleAfter(JobCounter& dependency, std::function<void()> task, JobCounter* counter)
+    {
+        if (counter != nullptr)
+        {
+            counter->pending_.fetch_add(1, std::memory_order_relaxed);
+        }
+        {
+            std::scoped_lock lock(dependency.mutex_);
+            if (!dependency.IsDone())
+            {
+                dependency.continuations_.push_back({std::move(task), counter});
+                return;
+            }
+        }
+        Job job{std::move(task), counter};
+        if (queues_.empty())
+        {
+            Execute(job);
+            return;
+        }
+        Push(std::move(job));
+    }
+
+    void JobSystem::Wait(JobCounter& counter)
+    {
+        ScopedZone zone("JobSystem::Wait");
+        while (!counter.IsDone())
+        {
+            Job job;
+            if (Pop(job))
+            {
+                Execute(job);
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+        //The last job decrements under the lock, taking it once guarantees that job let go of the counter
+        std::scoped_lock lock(counter.mutex_);
+    }
+
+    void JobSystem::Push(Job job)
+    {
+        const std::size_t index = job_thread_info.system == this ? job_thread_info.index : 0;
+        {
+            std::scoped_lock lock(queues_[index]->mutex);
+            queues_[index]->jobs.push_back(std::move(job));
+        }
+        queued_jobs_.fetch_add(1, std::memory_order_release);
+        //A worker checking the predicate holds the lock until it sleeps, this keeps the wake up from being lost
+        {
+            std::scoped_lock lock(sleep_mutex_);
+        }
+        wake_.notify_one();
+    }
+
+    bool JobSystem::Pop(Job& job)
+    {
+        const std::size_t own = job_thread_info.system == this ? job_thread_info.index : 0;
+        {
+            auto& queue = *queues_[own];
+            std::scoped_lock lock(queue.mutex);
+            if (!queue.jobs.empty())
+            {
+                job = std::move(queue.jobs.back());
+                queue.jobs.pop_back();
+                queued_jobs_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        //Steal the oldest job of the next threads, it is likely the biggest chunk of remaining work
+        for (std::size_t i = 1; i < queues_.size(); i++)
+        {
+            auto& queue = *queues_[(own + i) % queues_.size()];
+            std::scoped_lock lock(queue.mutex);
+            if (!queue.jobs.empty())
+            {
+                job = std::move(queue.jobs.front());
+                queue.jobs.pop_front();
+                queued_jobs_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void JobSystem::Execute(Job& job)
+    {
+        {
+            ScopedZone zone("Job");
+            job.task();
+        }
+        if (job.counter == nullptr)
+        {
+            return;
+        }
+        std::vector<Job> continuations;
+        {
+            std::scoped_lock lock(job.counter->mutex_);
+            if (job.counter->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                continuations.swap(job.counter->continuations_);
+            }
+        }
+        for (auto& continuation : continuations)
+        {
+            if (queues_.empty())
+            {
+                Execute(continuation);
+            }
+            else
+            {
+                Push(std::move(continuation));
+            }
+        }
+    }
+
+    void JobSystem::WorkerLoop(const std::size_t index)
+    {
+        job_thread_info = {this, index};
+        CpuTracer::SetThreadName("Worker " + std::to_string(index));
+        while (running_.load(std::memory_order_acquire))
+        {
+            Job job;
+            if (Pop(job))
+            {
+                Execute(job);
+                continue;
+            }
+            std::unique_lock lock(sleep_mutex_);
+            wake_.wait(lock, [this]
+            {
+                return queued_jobs_.load(std::memory_order_acquire) > 0 || !running_.load(std::memory_order_acquire);
+            });
+        }
+    }
+} // namespace gpr5300
@@ -0,0 +1,58 @@
+#include "late_latch.h"
+
+#include "cpu_tracer.h"
+#include "frame_uniforms.h"
+#include "free_camera.h"
+#include "input.h"
+
+namespace gpr5300
+{
+    void LateLatch::Create(Input* input, FrameUniforms* uniforms, const bool sample_in_latch)
+    {
+        input_ = input;
+        uniforms_ = uniforms;
+        sample_in_latch_ = sample_in_latch;
+        late_x_ = 0;
+        late_y_ = 0;
+    }
+
+    void LateLatch::Destroy()
+    {
+        input_ = nullptr;
+        uniforms_ = nullptr;
+    }
+
+    void LateLatch::Sample()
+    {
+        int x = 0;
+        int y = 0;
+        input_->SampleLateMouseMotion(&x, &y);
+        std::scoped_lock lock(mutex_);
+        late_x_ = x;
+        late_y_ = y;
+    }
+
+    void LateLatch::Latch(FreeCamera camera, const glm::mat4& projection, const bool mouse_look)
+    {
+        ScopedZone zone("LateLatch::Latch");
+        if (sample_in_latch_)
+        {
+            //Single threaded the last poll was at the top of the frame, fetch what arrived since
+            Sample();
+        }
+        int x = 0;
+        int y = 0;
+        {
+            //Threaded the engine samples the next frame only after this one replayed, the value is this frame's
+            std::scoped_lock lock(mutex_);
+            x = late_x_;
+            y = late_y_;
+        }
+        if (mouse_look && (x != 0 || y != 0))
+        {
+            camera.Update(x, y);
+        }
+
+        uniforms_->SetView({camera.view(), projection, glm::vec4(camera.camera_position_, 1.0f)});
+    }
+} // namespace gpr5300
@@ -0,0 +1,382 @@
+#include "mesh_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include <glm/common.hpp>
+
+#include "cpu_tracer.h"
+
+namespace gpr5300::MeshCache
+{
+    namespace
+    {
+        constexpr std::uint32_t mesh_cache_magic = 0x4D525047; //"GPRM"
+        //Bump when the layout, Vertex or the Assimp import flags change
+        constexpr std::uint32_t mesh_cache_version = 1;
+        //Vertex and index arrays start on this boundary, the mapping is page aligned
+        constexpr std::size_t data_alignment = 16;
+
+        struct MeshCacheHeader
+        {
+            std::uint32_t magic = mesh_cache_magic;
+            std::uint32_t version = mesh_cache_version;
+            std::uint64_t stamp = 0;
+            std::uint32_t vertex_size = sizeof(Vertex);
+            std::uint32_t mesh_count = 0;
+            std::uint32_t texture_count = 0;
+            //Source path, after the header, so two paths hashing to the same entry never mix
+            std::uint32_t path_length = 0;
+        };
+
+        struct MeshRecord
+        {
+            std::uint64_t vertex_offset = 0;
+            std::uint64_t index_offset = 0;
+            std::uint32_t vertex_count = 0;
+            std::uint32_t index_count = 0;
+            //Range of the texture index table
+            std::uint32_t first_texture = 0;
+            std::uint32_t texture_count = 0;
+            float bounds_min[3] = {};
+            float bounds_max[3] = {};
+        };
+
+        //Offsets in the string table
+        struct TextureRecord
+        {
+            std::uint32_t type_offset = 0;
+            std::uint32_t type_length = 0;
+            std::uint32_t path_offset = 0;
+            std::uint32_t path_length = 0;
+        };
+
+        std::filesystem::path cache_directory = "mesh_cache";
+        std::atomic<std::size_t> hits = 0;
+        std::atomic<std::size_t> misses = 0;
+
+        //FNV-1a, stable across runs and compilers unlike std::hash
+        std::uint64_t Fnv1a(const std::string_view data, std::uint64_t hash = 14695981039346656037ull)
+        {
+            for (const char c : data)
+            {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        std::uint64_t Fnv1a(const std::uint64_t value, const std::uint64_t hash)
+        {
+            return Fnv1a(std::string_view(reinterpret_cast<const char*>(&value), sizeof(value)), hash);
+        }
+
+        //Size and write time of the source and of its sibling files with the same stem (planet.mtl next to
+        //planet.obj, the .bin of a glTF), in name order
+        std::uint64_t SourceStamp(const std::filesystem::path& source)
+        {
+            std::error_code error;
+            std::vector<std::filesystem::path> files;
+            const std::filesystem::path directory = source.has_parent_path() ? source.parent_path() : ".";
+            for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+            {
+                if (entry.is_regular_file(error) && entry.path().stem() == source.stem())
+                {
+                    files.push_back(entry.path());
+                }
+            }
+            std::ranges::sort(files);
+            std::uint64_t hash = Fnv1a({});
+            for (const auto& file : files)
+            {
+                hash = Fnv1a(file.filename().generic_string(), hash);
+                hash = Fnv1a(static_cast<std::uint64_t>(std::filesystem::file_size(file, error)), hash);
+                const auto write_time = std::filesystem::last_write_time(file, error).time_since_epoch().count();
+                hash = Fnv1a(static_cast<std::uint64_t>(write_time), hash);
+            }
+            return hash;
+        }
+
+        std::filesystem::path EntryPath(const std::string& source_path)
+        {
+            char name[32];
+            std::snprintf(name, sizeof(name), "%016llx.mesh",
+                          static_cast<unsigned long long>(Fnv1a(source_path)));
+            return cache_directory / name;
+        }
+
+        template <typename T>
+        void Append(std::vector<std::byte>& output, const T* data, const std::size_t count)
+        {
+            const auto* bytes = reinterpret_cast<const std::byte*>(data);
+            output.insert(output.end(), bytes, bytes + count * sizeof(T));
+        }
+
+        void Align(std::vector<std::byte>& output)
+        {
+            output.resize((output.size() + data_alignment - 1) / data_alignment * data_alignment);
+        }
+
+        //Copy of the T at offset, false when it does not fit in bytes
+        template <typename T>
+        bool Read(const std::span<const std::byte> bytes, const std::uint64_t offset, T& value)
+        {
+            if (offset > bytes.size() || bytes.size() - offset < sizeof(T))
+            {
+                return false;
+            }
+            std::memcpy(&value, bytes.data() + offset, sizeof(T));
+            return true;
+        }
+
+        //count Ts at offset, read in place
+        template <typename T>
+        bool View(const std::span<const std::byte> bytes, const std::uint64_t offset, const std::uint64_t count,
+                  std::span<const T>& view)
+        {
+            if (offset % alignof(T) != 0 || offset > bytes.size() || (bytes.size() - offset) / sizeof(T) < count)
+            {
+                return false;
+            }
+            view = {reinterpret_cast<const T*>(bytes.data() + offset), static_cast<std::size_t>(count)};
+            return true;
+        }
+
+        bool Parse(const std::span<const std::byte> bytes, const std::string& source_path, CachedModel& model)
+        {
+            MeshCacheHeader header;
+            if (!Read(bytes, 0, header) || header.magic != mesh_cache_magic ||
+                header.version != mesh_cache_version || header.vertex_size != sizeof(Vertex) ||
+                header.stamp != SourceStamp(source_path))
+            {
+                return false;
+            }
+            std::uint64_t offset = sizeof(MeshCacheHeader);
+            std::span<const char> path;
+            if (!View(bytes, offset, header.path_length, path) ||
+                std::string_view(path.data(), path.size()) != source_path)
+            {
+                return false;
+            }
+            offset += header.path_length;
+
+            std::span<const std::byte> records;
+            std::span<const std::byte> texture_records;
+            if (!View(bytes, offset, std::uint64_t{header.mesh_count} * sizeof(MeshRecord), records))
+            {
+                return false;
+            }
+            offset += records.size();
+            std::uint32_t texture_index_count = 0;
+            if (!Read(bytes, offset, texture_index_count))
+            {
+                return false;
+            }
+            offset += sizeof(std::uint32_t);
+            std::span<const std::byte> texture_indices;
+            if (!View(bytes, offset, std::uint64_t{texture_index_count} * sizeof(std::uint32_t), texture_indices))
+            {
+                return false;
+            }
+            offset += texture_indices.size();
+            if (!View(bytes, offset, std::uint64_t{header.texture_count} * sizeof(TextureRecord), texture_records))
+            {
+                return false;
+            }
+            offset += texture_records.size();
+            std::uint32_t strings_length = 0;
+            std::span<const char> strings;
+            if (!Read(bytes, offset, strings_length) ||
+                !View(bytes, offset + sizeof(std::uint32_t), strings_length, strings))
+            {
+                return false;
+            }
+
+            model.textures.resize(header.texture_count);
+            for (std::uint32_t i = 0; i < header.texture_count; i++)
+            {
+                TextureRecord record;
+                Read(texture_records, i * sizeof(TextureRecord), record);
+                if (std::uint64_t{record.type_offset} + record.type_length > strings.size() ||
+                    std::uint64_t{record.path_offset} + record.path_length > strings.size())
+                {
+                    return false;
+                }
+                model.textures[i].type.assign(strings.data() + record.type_offset, record.type_length);
+                model.textures[i].path.assign(strings.data() + record.path_offset, record.path_length);
+            }
+
+            model.meshes.resize(header.mesh_count);
+            for (std::uint32_t i = 0; i < header.mesh_count; i++)
+            {
+                MeshRecord record;
+                Read(records, i * sizeof(MeshRecord), record);
+                MeshView& mesh = model.meshes[i];
+                if (!View(bytes, record.vertex_offset, record.vertex_count, mesh.vertices) ||
+                    !View(bytes, record.index_offset, record.index_count, mesh.indices) ||
+                    std::uint64_t{record.first_texture} + record.texture_count > texture_index_count)
+                {
+                    return false;
+                }
+                for (std::uint32_t t = 0; t < record.texture_count; t++)
+                {
+                    std::uint32_t texture = 0;
+                    Read(texture_indices, (record.first_texture + t) * sizeof(std::uint32_t), texture);
+                    if (texture >= header.texture_count)
+                    {
+                        return false;
+                    }
+                    mesh.textures.push_back(texture);
+                }
+                mesh.bounds.min = glm::vec3(record.bounds_min[0], record.bounds_min[1], record.bounds_min[2]);
+                mesh.bounds.max = glm::vec3(record.bounds_max[0], record.bounds_max[1], record.bounds_max[2]);
+            }
+            return true;
+        }
+    }
+
+    void SetDirectory(const std::string_view directory)
+    {
+        cache_directory = directory;
+    }
+
+    MeshBounds ComputeBounds(const std::span<const Vertex> vertices)
+    {
+        if (vertices.empty())
+        {
+            return {};
+        }
+        MeshBounds bounds{vertices.front().Position, vertices.front().Position};
+        for (const Vertex& vertex : vertices)
+        {
+            bounds.min = glm::min(bounds.min, vertex.Position);
+            bounds.max = glm::max(bounds.max, vertex.Position);
+        }
+        return bounds;
+    }
+
+    bool Load(const std::string& source_path, CachedModel& model)
+    {
+        if (cache_directory.empty())
+        {
+            return false;
+        }
+        ScopedZone zone("MeshCache::Load");
+        MappedFile file(EntryPath(source_path).string());
+        CachedModel parsed;
+        if (!file.IsOpen() || !Parse(file.Bytes(), source_path, parsed))
+        {
+            misses++;
+            return false;
+        }
+        //The views point into the mapping, which moving the file keeps in place
+        parsed.file = std::move(file);
+        model = std::move(parsed);
+        hits++;
+        return true;
+    }
+
+    void Save(const std::string& source_path, const std::span<const MeshView> meshes,
+              const std::span<const TextureReference> textures)
+    {
+        if (cache_directory.empty())
+        {
+            return;
+        }
+        ScopedZone zone("MeshCache::Save");
+        MeshCacheHeader header;
+        header.stamp = SourceStamp(source_path);
+        header.mesh_count = static_cast<std::uint32_t>(meshes.size());
+        header.texture_count = static_cast<std::uint32_t>(textures.size());
+        header.path_length = static_cast<std::uint32_t>(source_path.size());
+
+        std::vector<MeshRecord> records(meshes.size());
+        std::vector<std::uint32_t> texture_indices;
+        for (std::size_t i = 0; i < meshes.size(); i++)
+        {
+            MeshRecord& record = records[i];
+            record.vertex_count = static_cast<std::uint32_t>(meshes[i].vertices.size());
+            record.index_count = static_cast<std::uint32_t>(meshes[i].indices.size());
+            record.first_texture = static_cast<std::uint32_t>(texture_indices.size());
+            record.texture_count = static_cast<std::uint32_t>(meshes[i].textures.size());
+            for (const std::size_t texture : meshes[i].textures)
+            {
+                texture_indices.push_back(static_cast<std::uint32_t>(texture));
+            }
+            for (int axis = 0; axis < 3; axis++)
+            {
+                record.bounds_min[axis] = meshes[i].bounds.min[axis];
+                record.bounds_max[axis] = meshes[i].bounds.max[axis];
+            }
+        }
+        std::vector<TextureRecord> texture_records(textures.size());
+        std::string strings;
+        for (std::size_t i = 0; i < textures.size(); i++)
+        {
+            texture_records[i].type_offset = static_cast<std::uint32_t>(strings.size());
+            texture_records[i].type_length = static_cast<std::uint32_t>(textures[i].type.size());
+            strings += textures[i].type;
+            texture_records[i].path_offset = static_cast<std::uint32_t>(strings.size());
+            texture_records[i].path_length = static_cast<std::uint32_t>(textures[i].path.size());
+            strings += textures[i].path;
+        }
+
+        //Tables first, then the vertex and index arrays, each aligned. The records are patched once the array
+        //offsets are known.
+        std::vector<std::byte> output;
+        Append(output, &header, 1);
+        Append(output, source_path.data(), source_path.size());
+        const std::size_t records_offset = output.size();
+        Append(output, records.data(), records.size());
+        const auto texture_index_count = static_cast<std::uint32_t>(texture_indices.size());
+        Append(output, &texture_index_count, 1);
+        Append(output, texture_indices.data(), texture_indices.size());
+        Append(output, texture_records.data(), texture_records.size());
+        const auto strings_length = static_cast<std::uint32_t>(strings.size());
+        Append(output, &strings_length, 1);
+        Append(output, strings.data(), strings.size());
+        for (std::size_t i = 0; i < meshes.size(); i++)
+        {
+            Align(output);
+            records[i].vertex_offset = output.size();
+            Append(output, meshes[i].vertices.data(), meshes[i].vertices.size());
+            Align(output);
+            records[i].index_offset = output.size();
+            Append(output, meshes[i].indices.data(), meshes[i].indices.size());
+        }
+        std::memcpy(output.data() + records_offset, records.data(), records.size() * sizeof(MeshRecord));
+
+        std::error_code error;
+        std::filesystem::create_directories(cache_directory, error);
+        //Written aside then renamed, another instance never maps a half written entry
+        const std::filesystem::path path = EntryPath(source_path);
+        std::filesystem::path temporary_path = path;
+        temporary_path += ".tmp";
+        {
+            std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+            if (!file)
+            {
+                std::cerr << "Mesh cache: cannot write " << temporary_path.string() << '\n';
+                return;
+            }
+            file.write(reinterpret_cast<const char*>(output.data()), static_cast<std::streamsize>(output.size()));
+        }
+        std::filesystem::rename(temporary_path, path, error);
+    }
+
+    std::size_t Hits()
+    {
+        return hits;
+    }
+
+    std::size_t Misses()
+    {
+        return misses;
+    }
+} // namespace gpr5300::MeshCache
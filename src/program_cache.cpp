@@ -0,0 +1,180 @@
+#include "program_cache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cpu_tracer.h"
+
+namespace gpr5300::ProgramCache
+{
+    namespace
+    {
+        constexpr std::uint32_t program_cache_magic = 0x50525047; //"GPRP"
+        constexpr std::uint32_t program_cache_version = 1;
+
+        struct ProgramCacheHeader
+        {
+            std::uint32_t magic = program_cache_magic;
+            std::uint32_t version = program_cache_version;
+            std::uint64_t key = 0;
+            std::uint32_t format = 0;
+            std::uint32_t length = 0;
+        };
+
+        std::filesystem::path cache_directory = "shader_cache";
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+
+        //FNV-1a, stable across runs and compilers unlike std::hash
+        std::uint64_t Fnv1a(const std::string_view data, std::uint64_t hash = 14695981039346656037ull)
+        {
+            for (const char c : data)
+            {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        std::uint64_t DriverHash()
+        {
+            std::uint64_t hash = Fnv1a({});
+            for (const GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+            {
+                const auto* value = reinterpret_cast<const char*>(glGetString(name));
+                hash = Fnv1a(value != nullptr ? value : "", hash);
+                hash = Fnv1a(std::string_view("\0", 1), hash);
+            }
+            return hash;
+        }
+
+        bool IsSupported()
+        {
+            GLint format_count = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+            return format_count > 0;
+        }
+
+        std::filesystem::path EntryPath(const std::uint64_t key)
+        {
+            char name[32];
+            std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+            return cache_directory / name;
+        }
+    }
+
+    void SetDirectory(const std::string_view directory)
+    {
+        cache_directory = directory;
+    }
+
+    std::uint64_t Key(const std::initializer_list<std::string_view> sources)
+    {
+        //The driver strings do not change while the context lives
+        static const std::uint64_t driver_hash = DriverHash();
+        std::uint64_t hash = driver_hash;
+        for (const std::string_view source : sources)
+        {
+            //The separator keeps ("ab", "c") and ("a", "bc") apart
+            hash = Fnv1a(source, hash);
+            hash = Fnv1a(std::string_view("\0", 1), hash);
+        }
+        return hash;
+    }
+
+    bool Load(const std::uint64_t key, const GLuint program)
+    {
+        if (cache_directory.empty())
+        {
+            return false;
+        }
+        ScopedZone zone("ProgramCache::Load");
+        const std::filesystem::path path = EntryPath(key);
+        std::ifstream file(path, std::ios::binary);
+        ProgramCacheHeader header;
+        if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            header.magic != program_cache_magic || header.version != program_cache_version || header.key != key)
+        {
+            misses++;
+            return false;
+        }
+        //A damaged entry may claim any length, only allocate the blob once the file is known to hold it exactly
+        std::error_code error;
+        const std::uintmax_t file_size = std::filesystem::file_size(path, error);
+        if (error || file_size != sizeof(header) + std::uintmax_t{header.length})
+        {
+            misses++;
+            return false;
+        }
+        std::vector<char> binary(header.length);
+        if (!file.read(binary.data(), static_cast<std::streamsize>(binary.size())))
+        {
+            misses++;
+            return false;
+        }
+
+        glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+        GLint success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            //Same driver strings but a blob it no longer accepts (shader cache flags, rebuilt driver), recompile
+            misses++;
+            return false;
+        }
+        hits++;
+        return true;
+    }
+
+    void Save(const std::uint64_t key, const GLuint program)
+    {
+        static const bool supported = IsSupported();
+        if (cache_directory.empty() || !supported)
+        {
+            return;
+        }
+        ScopedZone zone("ProgramCache::Save");
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+        {
+            return;
+        }
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, &length, &format, binary.data());
+
+        std::error_code error;
+        std::filesystem::create_directories(cache_directory, error);
+        const ProgramCacheHeader header{.key = key, .format = format, .length = static_cast<std::uint32_t>(length)};
+        //Written aside then renamed, another instance never reads a half written entry
+        const std::filesystem::path path = EntryPath(key);
+        std::filesystem::path temporary_path = path;
+        temporary_path += ".tmp";
+        {
+            std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+            if (!file)
+            {
+                std::cerr << "Program cache: cannot write " << temporary_path.string() << '\n';
+                return;
+            }
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(binary.data(), length);
+        }
+        std::filesystem::rename(temporary_path, path, error);
+    }
+
+    std::size_t Hits()
+    {
+        return hits;
+    }
+
+    std::size_t Misses()
+    {
+        return misses;
+    }
+} // namespace gpr5300::ProgramCache
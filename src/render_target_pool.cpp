@@ -0,0 +1,158 @@
+#include "render_target_pool.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "gl_resources.h"
+#include "gl_state.h"
+
+namespace gpr5300
+{
+    namespace
+    {
+        //Frames a free target of the current size is kept around for the next scene or pass asking for it
+        constexpr std::uint64_t max_idle_frames = 3;
+
+        RenderTarget Resolve(const RenderTargetDesc& desc, const int viewport_width, const int viewport_height)
+        {
+            RenderTarget target;
+            if (desc.width > 0 && desc.height > 0)
+            {
+                target.width = desc.width;
+                target.height = desc.height;
+            }
+            else
+            {
+                target.width = std::max(1, static_cast<int>(std::lround(viewport_width * desc.scale)));
+                target.height = std::max(1, static_cast<int>(std::lround(viewport_height * desc.scale)));
+            }
+            target.samples = desc.samples;
+            target.renderbuffer = desc.renderbuffer;
+            return target;
+        }
+
+        bool SameKey(const RenderTargetDesc& a, const RenderTarget& resolved_a,
+                     const RenderTargetDesc& b, const RenderTarget& resolved_b)
+        {
+            return a.internal_format == b.internal_format && resolved_a.width == resolved_b.width &&
+                resolved_a.height == resolved_b.height && a.samples == b.samples && a.renderbuffer == b.renderbuffer;
+        }
+    }
+
+    void RenderTargetPool::Resize(const int width, const int height)
+    {
+        if (width <= 0 || height <= 0 || (width == Width() && height == Height()))
+        {
+            return;
+        }
+        width_.store(width, std::memory_order_relaxed);
+        height_.store(height, std::memory_order_relaxed);
+        generation_.fetch_add(1, std::memory_order_release);
+    }
+
+    RenderTarget RenderTargetPool::Acquire(const RenderTargetDesc& desc)
+    {
+        const RenderTarget resolved = Resolve(desc, Width(), Height());
+        for (Entry& entry : targets_)
+        {
+            if (!entry.in_use && SameKey(entry.desc, entry.target, desc, resolved))
+            {
+                entry.in_use = true;
+                entry.last_used_frame = frame_;
+                return entry.target;
+            }
+        }
+
+        Entry entry{desc, resolved, true, frame_};
+        RenderTarget& target = entry.target;
+        if (desc.renderbuffer)
+        {
+            target.id = GlResources::CreateRenderbuffer(desc.internal_format, target.width, target.height,
+                                                        desc.samples);
+        }
+        else if (desc.samples > 0)
+        {
+            target.id = GlResources::CreateTexture2DMultisample(desc.internal_format, target.width, target.height,
+                                                                desc.samples);
+        }
+        else
+        {
+            target.id = GlResources::CreateTexture2D(desc.internal_format, target.width, target.height);
+            GlResources::SetSampling(target.id, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE);
+        }
+        allocations_++;
+        targets_.push_back(entry);
+        return targets_.back().target;
+    }
+
+    void RenderTargetPool::Release(RenderTarget& target)
+    {
+        if (target.id == 0)
+        {
+            return;
+        }
+        for (Entry& entry : targets_)
+        {
+            if (entry.target.id == target.id && entry.target.renderbuffer == target.renderbuffer)
+            {
+                entry.in_use = false;
+                entry.last_used_frame = frame_;
+                break;
+            }
+        }
+        target = {};
+    }
+
+    void RenderTargetPool::Attach(const GLuint framebuffer, const GLenum attachment, const RenderTarget& target)
+    {
+        if (target.renderbuffer)
+        {
+            glNamedFramebufferRenderbuffer(framebuffer, attachment, GL_RENDERBUFFER, target.id);
+        }
+        else
+        {
+            glNamedFramebufferTexture(framebuffer, attachment, target.id, 0);
+        }
+    }
+
+    void RenderTargetPool::Collect()
+    {
+        frame_++;
+        std::erase_if(targets_, [this](const Entry& entry)
+        {
+            if (entry.in_use || (!IsStale(entry) && frame_ - entry.last_used_frame <= max_idle_frames))
+            {
+                return false;
+            }
+            Delete(entry.target);
+            return true;
+        });
+    }
+
+    void RenderTargetPool::Clear()
+    {
+        for (const Entry& entry : targets_)
+        {
+            Delete(entry.target);
+        }
+        targets_.clear();
+    }
+
+    bool RenderTargetPool::IsStale(const Entry& entry) const
+    {
+        const RenderTarget resolved = Resolve(entry.desc, Width(), Height());
+        return resolved.width != entry.target.width || resolved.height != entry.target.height;
+    }
+
+    void RenderTargetPool::Delete(const RenderTarget& target)
+    {
+        if (target.renderbuffer)
+        {
+            glDeleteRenderbuffers(1, &target.id);
+        }
+        else
+        {
+            GlState::DeleteTextures(1, &target.id);
+        }
+    }
+} // namespace gpr5300
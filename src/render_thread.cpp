@@ -0,0 +1,121 @@
+#include "render_thread.h"
+
+#include "cpu_tracer.h"
+
+namespace gpr5300
+{
+    void RenderThread::Create(const bool threaded, std::function<void(bool)> make_current)
+    {
+        threaded_ = threaded;
+        make_current_ = std::move(make_current);
+        if (!threaded_)
+        {
+            return;
+        }
+        //A GL context can only be current on one thread at a time
+        make_current_(false);
+        running_ = true;
+        thread_ = std::thread(&RenderThread::ThreadLoop, this);
+    }
+
+    void RenderThread::Destroy()
+    {
+        if (!threaded_)
+        {
+            return;
+        }
+        Flush();
+        {
+            std::scoped_lock lock(mutex_);
+            running_ = false;
+        }
+        submitted_.notify_one();
+        thread_.join();
+        make_current_(true);
+        threaded_ = false;
+    }
+
+    void RenderThread::Enqueue(RenderCommand command)
+    {
+        if (!threaded_)
+        {
+            command();
+            return;
+        }
+        lists_[record_index_].push_back(std::move(command));
+    }
+
+    void RenderThread::WaitForReplay()
+    {
+        if (!threaded_)
+        {
+            return;
+        }
+        std::unique_lock lock(mutex_);
+        replayed_.wait(lock, [this] { return !replaying_; });
+    }
+
+    void RenderThread::Submit()
+    {
+        if (!threaded_)
+        {
+            return;
+        }
+        ScopedZone zone("RenderThread::Submit");
+        std::unique_lock lock(mutex_);
+        replayed_.wait(lock, [this] { return !replaying_; });
+        replay_index_ = record_index_;
+        record_index_ = 1 - record_index_;
+        replaying_ = true;
+        lock.unlock();
+        submitted_.notify_one();
+    }
+
+    void RenderThread::Flush()
+    {
+        if (!threaded_)
+        {
+            return;
+        }
+        Submit();
+        std::unique_lock lock(mutex_);
+        replayed_.wait(lock, [this] { return !replaying_; });
+    }
+
+    void RenderThread::Execute(RenderCommand command)
+    {
+        Enqueue(std::move(command));
+        Flush();
+    }
+
+    void RenderThread::ThreadLoop()
+    {
+        CpuTracer::SetThreadName("Render");
+        make_current_(true);
+        while (true)
+        {
+            std::unique_lock lock(mutex_);
+            submitted_.wait(lock, [this] { return replaying_ || !running_; });
+            if (!replaying_)
+            {
+                break;
+            }
+            //The simulation only touches the other list until the next Submit, which waits on replaying_
+            auto& commands = lists_[replay_index_];
+            lock.unlock();
+            {
+                ScopedZone zone("RenderThread::Replay");
+                for (auto& command : commands)
+                {
+                    command();
+                }
+                commands.clear();
+            }
+            lock.lock();
+            replaying_ = false;
+            lock.unlock();
+            replayed_.notify_all();
+        }
+        make_current_(false);
+    }
+} // namespace gpr5300
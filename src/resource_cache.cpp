@@ -0,0 +1,283 @@
+#include "resource_cache.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+
+#include "cpu_tracer.h"
+#include "gl_state.h"
+#include "shader.h"
+#include "texture_loader.h"
+
+namespace gpr5300
+{
+    SharedTexture::~SharedTexture()
+    {
+        GlState::DeleteTextures(1, &id);
+    }
+
+    namespace
+    {
+        //Sorted, so the order the defines are listed in does not make a new variant
+        std::string VariantKey(std::string key, ShaderDefines& defines)
+        {
+            std::ranges::sort(defines);
+            for (const auto& [name, value] : defines)
+            {
+                key += '|' + name + '=' + value;
+            }
+            return key;
+        }
+
+        //The shader paths of the scenes, copies of the source tree resolved by the build
+        constexpr std::string_view loaded_shader_directory = "data/shaders";
+
+        //path under from moved under to, unchanged when outside of from
+        std::string Reroot(const std::string& path, const std::string_view from, const std::string_view to)
+        {
+            if (from.empty() || to.empty() || from == to)
+            {
+                return path;
+            }
+            const auto relative = std::filesystem::path(path).lexically_normal().lexically_relative(
+                std::filesystem::path(from).lexically_normal());
+            if (relative.empty() || *relative.begin() == "..")
+            {
+                return path;
+            }
+            return (std::filesystem::path(to) / relative).generic_string();
+        }
+
+        //Shader and ShaderStage are plain handles, the program goes away with the last reference
+        template <typename T>
+        std::shared_ptr<T> DeleteWithProgram(T* resource)
+        {
+            return std::shared_ptr<T>(resource, [](const T* program)
+            {
+                program->Delete();
+                delete program;
+            });
+        }
+    }
+
+    std::shared_ptr<const Shader> ResourceCache::LoadShader(const char* vertex_path, const char* fragment_path,
+                                                            ShaderDefines defines)
+    {
+        const std::string key = VariantKey(std::string(vertex_path) + '|' + fragment_path, defines);
+        if (auto shader = Find<Shader>(key))
+        {
+            return shader;
+        }
+        return Add(key, DeleteWithProgram(new Shader(vertex_path, fragment_path, ShaderCompile::Async,
+                                                     std::move(defines))));
+    }
+
+    std::shared_ptr<const Shader> ResourceCache::LoadShader(const ProgramSource& source, ShaderDefines defines)
+    {
+        const std::string key = VariantKey(std::string(source.vertex_path) + '|' + source.fragment_path, defines);
+        if (auto shader = Find<Shader>(key))
+        {
+            return shader;
+        }
+        return Add(key, DeleteWithProgram(new Shader(source, ShaderCompile::Async, std::move(defines))));
+    }
+
+    std::shared_ptr<const ShaderStage> ResourceCache::LoadStage(const GLenum type, const char* path,
+                                                                ShaderDefines defines)
+    {
+        const std::string key = VariantKey(std::to_string(type) + '|' + path, defines);
+        if (auto stage = Find<ShaderStage>(key))
+        {
+            return stage;
+        }
+        return Add(key, DeleteWithProgram(new ShaderStage(type, path, ShaderCompile::Async, std::move(defines))));
+    }
+
+    std::shared_ptr<const Shader> ResourceCache::LoadPipeline(const char* vertex_path, const char* fragment_path,
+                                                              ShaderDefines defines)
+    {
+        const std::string key = VariantKey(std::string("pipeline|") + vertex_path + '|' + fragment_path, defines);
+        if (auto shader = Find<Shader>(key))
+        {
+            return shader;
+        }
+        auto vertex = LoadStage(GL_VERTEX_SHADER, vertex_path, defines);
+        auto fragment = LoadStage(GL_FRAGMENT_SHADER, fragment_path, std::move(defines));
+        return Add(key, DeleteWithProgram(new Shader(std::move(vertex), std::move(fragment))));
+    }
+
+    void ResourceCache::SetShaderSourceDirectory(std::string directory)
+    {
+        shader_source_directory_ = std::move(directory);
+    }
+
+    void ResourceCache::ReloadShaders(const std::vector<std::string>& changed_files)
+    {
+        const auto source_path = [this](const std::string& path)
+        {
+            return Reroot(path, loaded_shader_directory, shader_source_directory_);
+        };
+        for (const std::string& file : changed_files)
+        {
+            //Saved in the source tree, the live programs know the path of their copy
+            const auto changed = std::filesystem::path(Reroot(file, shader_source_directory_,
+                                                              loaded_shader_directory)).lexically_normal();
+            //Any program may include a changed .glsl file
+            const bool is_include = changed.extension() == ".glsl";
+            const auto is_changed = [&changed, is_include](const std::string& path)
+            {
+                return is_include || std::filesystem::path(path).lexically_normal() == changed;
+            };
+            for (auto& [key, resource] : resources_)
+            {
+                if (key.first == std::type_index(typeid(ShaderStage)))
+                {
+                    auto live = std::static_pointer_cast<ShaderStage>(resource);
+                    if (!is_changed(live->Path()))
+                    {
+                        continue;
+                    }
+                    std::erase_if(stage_reloads_, [&live](const StageReload& reload)
+                    {
+                        if (reload.live != live)
+                        {
+                            return false;
+                        }
+                        reload.next->Delete();
+                        return true;
+                    });
+                    auto next = std::make_shared<ShaderStage>(live->Type(), source_path(live->Path()).c_str(),
+                                                              ShaderCompile::Async, live->Defines());
+                    stage_reloads_.push_back({std::move(live), std::move(next)});
+                    continue;
+                }
+                if (key.first != std::type_index(typeid(Shader)))
+                {
+                    continue;
+                }
+                auto live = std::static_pointer_cast<Shader>(resource);
+                //Pipelines follow the reload of their stages
+                if (live->IsPipeline() || (!is_changed(live->VertexPath()) && !is_changed(live->FragmentPath())))
+                {
+                    continue;
+                }
+                //A newer save replaces a rebuild still compiling
+                std::erase_if(shader_reloads_, [&live](const ShaderReload& reload)
+                {
+                    if (reload.live != live)
+                    {
+                        return false;
+                    }
+                    reload.next->Delete();
+                    return true;
+                });
+                auto next = std::make_shared<Shader>(source_path(live->VertexPath()).c_str(),
+                                                     source_path(live->FragmentPath()).c_str(), ShaderCompile::Async,
+                                                     live->Defines());
+                shader_reloads_.push_back({std::move(live), std::move(next)});
+            }
+        }
+
+        std::erase_if(shader_reloads_, [](const ShaderReload& reload)
+        {
+            if (!reload.next->IsReady())
+            {
+                return false;
+            }
+            if (reload.next->IsLinked())
+            {
+                std::cout << "Reloaded " << reload.live->VertexPath() << " + " << reload.live->FragmentPath() << '\n';
+                reload.live->Replace(std::move(*reload.next));
+            }
+            else
+            {
+                std::cerr << "Reload of " << reload.live->VertexPath() << " + " << reload.live->FragmentPath()
+                    << " failed, keeping the previous program\n";
+                reload.next->Delete();
+            }
+            return true;
+        });
+
+        std::erase_if(stage_reloads_, [this](const StageReload& reload)
+        {
+            if (!reload.next->IsReady())
+            {
+                return false;
+            }
+            if (!reload.next->IsLinked())
+            {
+                std::cerr << "Reload of " << reload.live->Path() << " failed, keeping the previous stage\n";
+                reload.next->Delete();
+                return true;
+            }
+            std::cout << "Reloaded " << reload.live->Path() << '\n';
+            reload.live->Replace(std::move(*reload.next));
+            for (auto& [key, resource] : resources_)
+            {
+                if (key.first != std::type_index(typeid(Shader)))
+                {
+                    continue;
+                }
+                const auto shader = std::static_pointer_cast<Shader>(resource);
+                if (shader->UsesStage(reload.live.get()))
+                {
+                    shader->RefreshStages();
+                }
+            }
+            return true;
+        });
+    }
+
+    std::shared_ptr<const SharedTexture> ResourceCache::LoadTexture(const char* path, const std::string& directory,
+                                                                    const bool gamma)
+    {
+        const std::string key = directory + '/' + path + (gamma ? "|srgb" : "");
+        if (auto texture = Find<SharedTexture>(key))
+        {
+            return texture;
+        }
+        return Add(key, std::make_shared<SharedTexture>(TextureFromFile(path, directory, gamma)));
+    }
+
+    std::shared_ptr<const SharedTexture> ResourceCache::LoadCubemap(const std::vector<std::string>& faces,
+                                                                    JobSystem* jobs)
+    {
+        std::string key;
+        for (const auto& face : faces)
+        {
+            key += face + '|';
+        }
+        if (auto cubemap = Find<SharedTexture>(key))
+        {
+            return cubemap;
+        }
+        return Add(key, std::make_shared<SharedTexture>(CubemapFromVec(faces, jobs)));
+    }
+
+    void ResourceCache::Trim()
+    {
+        ScopedZone zone("ResourceCache::Trim");
+        //A pipeline released leaves its stages held by the cache alone, they go in the next pass
+        while (std::erase_if(resources_, [](const auto& entry) { return entry.second.use_count() == 1; }) > 0)
+        {
+        }
+    }
+
+    void ResourceCache::Clear()
+    {
+        for (const ShaderReload& reload : shader_reloads_)
+        {
+            reload.next->Delete();
+        }
+        shader_reloads_.clear();
+        for (const StageReload& reload : stage_reloads_)
+        {
+            reload.next->Delete();
+        }
+        stage_reloads_.clear();
+        resources_.clear();
+        hits_ = 0;
+        misses_ = 0;
+    }
+} // namespace gpr5300
@@ -0,0 +1,178 @@
+#include "scene_host.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "cpu_tracer.h"
+#include "gl_state.h"
+#include "render_target_pool.h"
+#include "resource_cache.h"
+#include "stb_image.h"
+
+namespace gpr5300
+{
+    SceneHost::SceneHost(std::string initial_scene) : initial_scene_(std::move(initial_scene))
+    {
+    }
+
+    void SceneHost::Begin()
+    {
+        scenes_ = SceneRegistry();
+        std::ranges::sort(scenes_, {}, &SceneEntry::name);
+        if (scenes_.empty())
+        {
+            std::cerr << "Scene host: no scene registered\n";
+            return;
+        }
+
+        std::size_t index = 0;
+        if (!initial_scene_.empty())
+        {
+            const auto it = std::ranges::find(scenes_, initial_scene_, &SceneEntry::name);
+            if (it == scenes_.end())
+            {
+                std::cerr << "Scene host: unknown scene " << initial_scene_ << '\n';
+            }
+            else
+            {
+                index = it - scenes_.begin();
+            }
+        }
+        Switch(index);
+    }
+
+    void SceneHost::End()
+    {
+        if (current_ != nullptr)
+        {
+            current_->End();
+            current_.reset();
+        }
+        resources_->Trim();
+    }
+
+    void SceneHost::Update(const float dt)
+    {
+        if (current_ != nullptr)
+        {
+            current_->Update(dt);
+        }
+    }
+
+    bool SceneHost::SupportsFixedUpdate() const
+    {
+        return current_ != nullptr && current_->SupportsFixedUpdate();
+    }
+
+    void SceneHost::FixedUpdate(const float fixed_dt)
+    {
+        current_->FixedUpdate(fixed_dt);
+    }
+
+    void SceneHost::Render(const float alpha)
+    {
+        current_->Render(alpha);
+    }
+
+    bool SceneHost::SupportsLateLatch() const
+    {
+        return current_ != nullptr && current_->SupportsLateLatch();
+    }
+
+    void SceneHost::DrawImGui()
+    {
+        if (current_ == nullptr)
+        {
+            return;
+        }
+        //The switch happens here, after the current scene rendered its frame and before its ImGui is drawn
+        std::size_t selected = current_index_;
+        ImGui::Begin("Scenes");
+        for (std::size_t i = 0; i < scenes_.size(); i++)
+        {
+            if (ImGui::Selectable(scenes_[i].name.c_str(), i == current_index_))
+            {
+                selected = i;
+            }
+        }
+        ImGui::Separator();
+        ImGui::Text("Last switch: %.1f ms", switch_time_);
+        ImGui::Text("Cached resources: %zu (%zu hits, %zu loads)", resources_->Size(), resources_->Hits(),
+                    resources_->Misses());
+        ImGui::Text("Render targets: %zu (%zu allocations)", render_targets_->Size(), render_targets_->Allocations());
+        ImGui::End();
+
+        if (selected != current_index_)
+        {
+            Switch(selected);
+        }
+        current_->DrawImGui();
+    }
+
+    void SceneHost::OnEvent(const SDL_Event& event)
+    {
+        if (current_ != nullptr)
+        {
+            current_->OnEvent(event);
+        }
+    }
+
+    void SceneHost::UpdateCamera(const float dt)
+    {
+        if (current_ != nullptr)
+        {
+            current_->UpdateCamera(dt);
+        }
+    }
+
+    void SceneHost::Switch(const std::size_t index)
+    {
+        ScopedZone zone("SceneHost::Switch");
+        const auto start = std::chrono::steady_clock::now();
+        if (current_ != nullptr)
+        {
+            current_->End();
+            current_.reset();
+            ResetState();
+        }
+
+        current_index_ = index;
+        current_ = scenes_[index].create();
+        current_->SetJobSystem(job_system_);
+        current_->SetRenderThread(render_thread_);
+        current_->SetLateLatch(late_latch_);
+        current_->SetInput(input_);
+        current_->SetResourceCache(resources_);
+        current_->SetRenderTargetPool(render_targets_);
+        current_->SetFrameUniforms(frame_uniforms_);
+        current_->Begin();
+        //Only now are the resources the new scene did not pick up unused
+        resources_->Trim();
+
+        using milliseconds = std::chrono::duration<double, std::milli>;
+        switch_time_ = std::chrono::duration_cast<milliseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void SceneHost::ResetState() const
+    {
+        //Scenes assume the default GL state of a fresh context in Begin, undo what the previous one left behind
+        GlState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, render_targets_->Width(), render_targets_->Height());
+        GlState::Disable(GL_DEPTH_TEST);
+        GlState::DepthFunc(GL_LESS);
+        GlState::DepthMask(GL_TRUE);
+        GlState::Disable(GL_STENCIL_TEST);
+        glStencilMask(0xFF);
+        GlState::Disable(GL_BLEND);
+        GlState::Disable(GL_CULL_FACE);
+        GlState::Disable(GL_FRAMEBUFFER_SRGB);
+        GlState::Disable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+        GlState::UseProgram(0);
+        GlState::BindProgramPipeline(0);
+        GlState::BindVertexArray(0);
+        stbi_set_flip_vertically_on_load(false);
+    }
+} // namespace gpr5300
@@ -0,0 +1,16 @@
+#include "scene_registry.h"
+
+namespace gpr5300
+{
+    std::vector<SceneEntry>& SceneRegistry()
+    {
+        //Function local so registrations from static initializers never see it unconstructed
+        static std::vector<SceneEntry> scenes;
+        return scenes;
+    }
+
+    SceneRegistration::SceneRegistration(std::string name, std::function<std::unique_ptr<Scene>()> create)
+    {
+        SceneRegistry().push_back({std::move(name), std::move(create)});
+    }
+} // namespace gpr5300
@@ -0,0 +1,84 @@
+#include "shader_source.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+
+namespace gpr5300
+{
+    namespace
+    {
+        constexpr std::string_view utf8_bom = "\xEF\xBB\xBF";
+
+        //File named by an #include "file" line, empty for any other line
+        std::string_view IncludedName(const std::string_view line)
+        {
+            const auto first = line.find_first_not_of(" \t");
+            if (first == std::string_view::npos || line.substr(first, 8) != "#include")
+            {
+                return {};
+            }
+            const auto open = line.find('"', first + 8);
+            const auto close = open == std::string_view::npos ? open : line.find('"', open + 1);
+            if (close == std::string_view::npos)
+            {
+                return {};
+            }
+            return line.substr(open + 1, close - open - 1);
+        }
+
+        void AppendShaderFile(const std::filesystem::path& path, std::set<std::filesystem::path>& included,
+                              std::string& output, bool& complete)
+        {
+            std::ifstream file(path, std::ios::binary);
+            if (!file)
+            {
+                std::cerr << "Cannot read shader source " << path.generic_string() << '\n';
+                output += "#error cannot read " + path.generic_string() + '\n';
+                complete = false;
+                return;
+            }
+            std::string line;
+            int line_number = 0;
+            while (std::getline(file, line))
+            {
+                line_number++;
+                if (line_number == 1 && line.starts_with(utf8_bom))
+                {
+                    line.erase(0, utf8_bom.size());
+                }
+                const std::string_view name = IncludedName(line);
+                if (name.empty())
+                {
+                    output += line;
+                    output += '\n';
+                    continue;
+                }
+                const auto include_path = (path.parent_path() / name).lexically_normal();
+                if (included.insert(include_path).second)
+                {
+                    output += "#line 1\n";
+                    AppendShaderFile(include_path, included, output, complete);
+                    //Compile errors after the include keep the line numbers of this file
+                    output += "#line " + std::to_string(line_number + 1) + '\n';
+                }
+            }
+        }
+    }
+
+    std::string LoadShaderSource(const std::string_view path, bool* complete)
+    {
+        std::string source;
+        std::set<std::filesystem::path> included;
+        const auto root = std::filesystem::path(path).lexically_normal();
+        included.insert(root);
+        bool all_read = true;
+        AppendShaderFile(root, included, source, all_read);
+        if (complete != nullptr)
+        {
+            *complete = all_read;
+        }
+        return source;
+    }
+} // namespace gpr5300
@@ -0,0 +1,152 @@
+#include "shader_watcher.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "cpu_tracer.h"
+
+namespace gpr5300
+{
+#if defined(__linux__)
+    namespace
+    {
+        //Editors save through a temporary file renamed over the original, or by rewriting it in place
+        constexpr std::uint32_t watched_events = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+    }
+
+    bool ShaderWatcher::Start(const std::string_view directory)
+    {
+        inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        stop_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (inotify_fd_ < 0 || stop_fd_ < 0)
+        {
+            std::cerr << "Shader watcher: inotify unavailable, hot reload disabled\n";
+            Stop();
+            return false;
+        }
+        const std::string root(directory);
+        std::error_code error;
+        if (!std::filesystem::is_directory(root, error))
+        {
+            std::cerr << "Shader watcher: " << root << " is not a directory, hot reload disabled\n";
+            Stop();
+            return false;
+        }
+        //inotify is not recursive, every subdirectory gets its own watch
+        Watch(root);
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(root, error))
+        {
+            if (entry.is_directory())
+            {
+                Watch(entry.path().generic_string());
+            }
+        }
+        thread_ = std::thread(&ShaderWatcher::Run, this);
+        return true;
+    }
+
+    void ShaderWatcher::Stop()
+    {
+        if (thread_.joinable())
+        {
+            const std::uint64_t value = 1;
+            write(stop_fd_, &value, sizeof(value));
+            thread_.join();
+        }
+        if (inotify_fd_ >= 0)
+        {
+            close(inotify_fd_);
+            inotify_fd_ = -1;
+        }
+        if (stop_fd_ >= 0)
+        {
+            close(stop_fd_);
+            stop_fd_ = -1;
+        }
+        directories_.clear();
+    }
+
+    void ShaderWatcher::Watch(const std::string& directory)
+    {
+        const int descriptor = inotify_add_watch(inotify_fd_, directory.c_str(), watched_events);
+        if (descriptor >= 0)
+        {
+            directories_[descriptor] = directory;
+        }
+    }
+
+    void ShaderWatcher::Run()
+    {
+        CpuTracer::SetThreadName("ShaderWatcher");
+        //Aligned as inotify_event, big enough for many events at once
+        alignas(inotify_event) char buffer[4096];
+        pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {stop_fd_, POLLIN, 0}};
+        while (true)
+        {
+            if (poll(fds, 2, -1) < 0 || (fds[1].revents & POLLIN) != 0)
+            {
+                return;
+            }
+            ssize_t length = 0;
+            while ((length = read(inotify_fd_, buffer, sizeof(buffer))) > 0)
+            {
+                for (ssize_t offset = 0; offset < length;)
+                {
+                    const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                    offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+                    const auto directory = directories_.find(event->wd);
+                    if (event->len == 0 || directory == directories_.end())
+                    {
+                        continue;
+                    }
+                    const std::string path = directory->second + '/' + event->name;
+                    if ((event->mask & IN_ISDIR) != 0)
+                    {
+                        Watch(path);
+                    }
+                    else if ((event->mask & IN_CREATE) == 0)
+                    {
+                        //IN_CREATE of a file is followed by its IN_CLOSE_WRITE once the content is there
+                        std::scoped_lock lock(mutex_);
+                        changes_.insert(path);
+                    }
+                }
+            }
+        }
+    }
+#else
+    bool ShaderWatcher::Start(const std::string_view directory)
+    {
+        std::cerr << "Shader watcher: only supported on Linux, hot reload disabled\n";
+        return false;
+    }
+
+    void ShaderWatcher::Stop()
+    {
+    }
+
+    void ShaderWatcher::Watch(const std::string& directory)
+    {
+    }
+
+    void ShaderWatcher::Run()
+    {
+    }
+#endif
+
+    std::vector<std::string> ShaderWatcher::TakeChanges()
+    {
+        std::scoped_lock lock(mutex_);
+        std::vector<std::string> changes(changes_.begin(), changes_.end());
+        changes_.clear();
+        return changes;
+    }
+} // namespace gpr5300
@@ -1,34 +1,138 @@
+#include <algorithm>
 #include <iostream>
+#include <GL/glew.h>
 #include "texture_loader.h"
 
+#include "cpu_tracer.h"
+#include "gl_resources.h"
+#include "job_system.h"
+
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+Image DecodeImage(const char* path, int desired_comp) {
+  Image image;
+  image.pixel = stbi_load(path, &image.width, &image.height, &image.comp, desired_comp);
+  return image;
+}
+
+void FreeImage(Image& image) {
+  stbi_image_free(image.pixel);
+  image.pixel = nullptr;
+}
+
 unsigned int TextureManager::CreateTexture(const char* path) {
-  unsigned int texture;
-  glGenTextures(1, &texture);
-  glBindTexture(GL_TEXTURE_2D, texture);
-// set the texture wrapping/filtering options (on the currently bound texture object)
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-// load and generate the texture
-  int width, height, nrChannels;
-  unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
-  if (data)
-  {
-    //TODO add check JPG:
-      //glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-      //glGenerateMipmap(GL_TEXTURE_2D);
-    //TODO PNG
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-  }
-  else
+// load and generate the texture, always as RGBA so jpg and png share the storage format
+  Image image = DecodeImage(path, 4);
+  if (!image.pixel)
   {
     std::cout << "Failed to load texture" << std::endl;
+    unsigned int texture;
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+    return texture;
   }
-  stbi_image_free(data);
+  const unsigned int texture = gpr5300::GlResources::CreateTexture2D(
+      GL_RGBA8, image.width, image.height, gpr5300::GlResources::MipLevels(image.width, image.height));
+  glTextureSubImage2D(texture, 0, 0, 0, image.width, image.height, GL_RGBA, GL_UNSIGNED_BYTE, image.pixel);
+  glGenerateTextureMipmap(texture);
+// set the texture wrapping/filtering options
+  gpr5300::GlResources::SetSampling(texture, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_REPEAT);
+  FreeImage(image);
   return texture;
 }
+
+unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma)
+{
+    gpr5300::ScopedZone zone("TextureFromFile");
+    std::string filename = std::string(path);
+    filename = directory + '/' + filename;
+
+    Image image = DecodeImage(filename.c_str());
+    if (image.pixel == nullptr)
+    {
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+    }
+    const unsigned int textureID = TextureFromImage(image, gamma);
+    FreeImage(image);
+
+    return textureID;
+}
+
+unsigned int TextureFromImage(const Image& image, bool gamma)
+{
+    if (!image.pixel)
+    {
+        unsigned int textureID;
+        glCreateTextures(GL_TEXTURE_2D, 1, &textureID);
+        return textureID;
+    }
+
+    //Immutable storage wants a sized format
+    GLenum internal_format;
+    GLenum data_format;
+    if (image.comp == 1)
+    {
+        internal_format = GL_R8;
+        data_format = GL_RED;
+    }
+    else if (image.comp == 3)
+    {
+        internal_format = gamma ? GL_SRGB8 : GL_RGB8;
+        data_format = GL_RGB;
+    }
+    else
+    {
+        internal_format = gamma ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+        data_format = GL_RGBA;
+    }
+
+    const unsigned int textureID = gpr5300::GlResources::CreateTexture2D(
+        internal_format, image.width, image.height, gpr5300::GlResources::MipLevels(image.width, image.height));
+    glTextureSubImage2D(textureID, 0, 0, 0, image.width, image.height, data_format, GL_UNSIGNED_BYTE, image.pixel);
+    glGenerateTextureMipmap(textureID);
+    gpr5300::GlResources::SetSampling(textureID, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR,
+                                      data_format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+
+    return textureID;
+}
+//Decoding the faces dominates, with a job system they are decoded in parallel and only the upload stays serial
+unsigned int CubemapFromVec(std::vector<std::string> faces, gpr5300::JobSystem* jobs)
+{
+    gpr5300::ScopedZone zone("CubemapFromVec");
+    std::vector<Image> images(faces.size());
+    const auto decode = [&faces, &images](const std::size_t begin, const std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; i++)
+            images[i] = DecodeImage(faces[i].c_str(), 3);
+    };
+    if (jobs != nullptr)
+        jobs->ParallelFor(faces.size(), 1, decode);
+    else
+        decode(0, faces.size());
+
+    //The storage of every face is allocated at once, sized after the first face that loaded
+    const auto loaded = std::ranges::find_if(images, [](const Image& image) { return image.pixel != nullptr; });
+    const int size = loaded != images.end() ? loaded->width : 1;
+    const unsigned int textureID = gpr5300::GlResources::CreateTextureCube(GL_RGB8, size);
+
+    for (unsigned int i = 0; i < faces.size(); i++)
+    {
+        if (images[i].pixel && (images[i].width != size || images[i].height != size))
+        {
+            std::cout << "Cubemap face " << faces[i] << " is not " << size << 'x' << size << std::endl;
+        }
+        else if (images[i].pixel)
+        {
+            glTextureSubImage3D(textureID, 0, 0, 0, static_cast<GLint>(i), size, size, 1, GL_RGB, GL_UNSIGNED_BYTE,
+                                images[i].pixel);
+        }
+        else
+        {
+            std::cout << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
+        }
+        FreeImage(images[i]);
+    }
+    gpr5300::GlResources::SetSampling(textureID, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE);
+
+    return textureID;
+}
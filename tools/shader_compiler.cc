@@ -0,0 +1,868 @@
+//Offline shader step run by the shader_target of the build:
+//  shader_compiler resolve INPUT OUTPUT
+//      writes INPUT with its includes resolved, the file glslangValidator checks and the program loads
+//  shader_compiler program NAME VERTEX FRAGMENT HEADER
+//      generates HEADER for the program NAME: both sources embedded, its uniforms, uniform blocks and vertex
+//      attributes reflected as constants
+//  shader_compiler cost OUTPUT SHADER...
+//      writes a JSON report of the static cost estimate of every stage: ALU operations, texture fetches and
+//      branches weighted by loop trip counts, and the loops
+//  shader_compiler cost-diff BASELINE CURRENT [RATIO]
+//      lists the stages whose cost changed between two reports, fails when a metric grew by more than RATIO (1.25)
+//Paths of the program are stored as given, run it from the source directory so they are those the program opens.
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "shader_source.h"
+
+namespace gpr5300
+{
+    namespace
+    {
+        struct Declaration
+        {
+            std::string type;
+            std::string name;
+            bool is_array = false;
+        };
+
+        struct Reflection
+        {
+            //GLSL name of each uniform of the default block, struct members as "name.member"
+            std::map<std::string, std::string> uniforms;
+            std::set<std::string> blocks;
+            std::map<std::string, int> attributes;
+        };
+
+        //Comments and preprocessor lines removed, the declarations of every #if branch are kept
+        std::vector<std::string> Tokenize(const std::string_view source)
+        {
+            std::vector<std::string> tokens;
+            bool line_start = true;
+            for (std::size_t i = 0; i < source.size();)
+            {
+                const char c = source[i];
+                if (c == '\n')
+                {
+                    line_start = true;
+                    i++;
+                }
+                else if (std::isspace(static_cast<unsigned char>(c)))
+                {
+                    i++;
+                }
+                else if (line_start && c == '#')
+                {
+                    //Preprocessor lines, with their continuations
+                    while (i < source.size() && (source[i] != '\n' || source[i - 1] == '\\'))
+                    {
+                        i++;
+                    }
+                }
+                else if (source.substr(i, 2) == "//")
+                {
+                    i = source.find('\n', i);
+                    i = i == std::string_view::npos ? source.size() : i;
+                }
+                else if (source.substr(i, 2) == "/*")
+                {
+                    i = source.find("*/", i + 2);
+                    i = i == std::string_view::npos ? source.size() : i + 2;
+                }
+                else if (std::isalnum(static_cast<unsigned char>(c)) || c == '_')
+                {
+                    const std::size_t start = i;
+                    while (i < source.size() && (std::isalnum(static_cast<unsigned char>(source[i])) || source[i] == '_' ||
+                                                 source[i] == '.'))
+                    {
+                        i++;
+                    }
+                    tokens.emplace_back(source.substr(start, i - start));
+                    line_start = false;
+                }
+                else
+                {
+                    tokens.emplace_back(1, c);
+                    line_start = false;
+                    i++;
+                }
+            }
+            return tokens;
+        }
+
+        //Top level statements, the bodies of the functions left out
+        std::vector<std::vector<std::string>> Statements(const std::vector<std::string>& tokens)
+        {
+            std::vector<std::vector<std::string>> statements;
+            std::vector<std::string> statement;
+            int depth = 0;
+            for (const std::string& token : tokens)
+            {
+                if (token == ";" && depth == 0)
+                {
+                    statements.push_back(std::move(statement));
+                    statement.clear();
+                    continue;
+                }
+                statement.push_back(token);
+                if (token == "{")
+                {
+                    depth++;
+                }
+                else if (token == "}" && --depth == 0)
+                {
+                    //Structs and blocks end with a ';', function bodies do not
+                    const bool declaration = statement.front() == "struct" ||
+                        std::find(statement.begin(), statement.end(), "uniform") != statement.end();
+                    if (!declaration)
+                    {
+                        statement.clear();
+                    }
+                }
+            }
+            return statements;
+        }
+
+        //layout(...), precision and interpolation qualifiers, the location of a layout when it has one
+        std::size_t SkipQualifiers(const std::vector<std::string>& statement, int* location = nullptr)
+        {
+            static const std::set<std::string> qualifiers = {
+                "highp", "mediump", "lowp", "flat", "smooth", "noperspective", "centroid", "invariant", "precise"
+            };
+            std::size_t i = 0;
+            while (i < statement.size())
+            {
+                if (statement[i] == "layout")
+                {
+                    for (i++; i < statement.size() && statement[i] != ")"; i++)
+                    {
+                        if (statement[i] == "location" && location != nullptr && i + 2 < statement.size())
+                        {
+                            *location = std::atoi(statement[i + 2].c_str());
+                        }
+                    }
+                    i++;
+                }
+                else if (qualifiers.contains(statement[i]))
+                {
+                    i++;
+                }
+                else
+                {
+                    break;
+                }
+            }
+            return i;
+        }
+
+        //"type a, b[4] = ..." from begin, the names with their array flag
+        std::vector<Declaration> Declarators(const std::vector<std::string>& statement, std::size_t begin)
+        {
+            std::vector<Declaration> declarations;
+            if (begin + 1 >= statement.size())
+            {
+                return declarations;
+            }
+            const std::string type = statement[begin];
+            int depth = 0;
+            bool expect_name = true;
+            for (std::size_t i = begin + 1; i < statement.size(); i++)
+            {
+                const std::string& token = statement[i];
+                if (token == "(" || token == "[" || token == "{")
+                {
+                    if (token == "[" && depth == 0 && !declarations.empty())
+                    {
+                        declarations.back().is_array = true;
+                    }
+                    depth++;
+                }
+                else if (token == ")" || token == "]" || token == "}")
+                {
+                    depth--;
+                }
+                else if (token == "," && depth == 0)
+                {
+                    expect_name = true;
+                }
+                else if (token == "=" && depth == 0)
+                {
+                    expect_name = false;
+                }
+                else if (expect_name && depth == 0)
+                {
+                    declarations.push_back({type, token});
+                    expect_name = false;
+                }
+            }
+            return declarations;
+        }
+
+        //C++ type the Shader setters take for a GLSL type, empty when there is no setter for it
+        std::string CppType(const std::string_view glsl_type)
+        {
+            static const std::map<std::string_view, std::string_view> types = {
+                {"bool", "bool"}, {"int", "int"}, {"float", "float"},
+                {"vec2", "glm::vec2"}, {"vec3", "glm::vec3"}, {"vec4", "glm::vec4"},
+                {"mat2", "glm::mat2"}, {"mat3", "glm::mat3"}, {"mat4", "glm::mat4"},
+            };
+            if (const auto it = types.find(glsl_type); it != types.end())
+            {
+                return std::string(it->second);
+            }
+            //Samplers and images are set as the texture unit
+            if (glsl_type.find("sampler") != std::string_view::npos || glsl_type.find("image") != std::string_view::npos)
+            {
+                return "int";
+            }
+            return {};
+        }
+
+        void AddUniform(const Declaration& declaration, const std::string& prefix,
+                        const std::map<std::string, std::vector<Declaration>>& structs, Reflection& reflection)
+        {
+            const std::string name = prefix + declaration.name;
+            if (const auto it = structs.find(declaration.type); it != structs.end())
+            {
+                //Arrays of structs are set element by element, "lights[i].color", not reflected
+                if (!declaration.is_array)
+                {
+                    for (const Declaration& member : it->second)
+                    {
+                        AddUniform(member, name + '.', structs, reflection);
+                    }
+                }
+                return;
+            }
+            if (const std::string type = CppType(declaration.type); !type.empty())
+            {
+                reflection.uniforms.emplace(name, type);
+            }
+        }
+
+        void Reflect(const std::string_view source, const bool vertex, Reflection& reflection)
+        {
+            std::map<std::string, std::vector<Declaration>> structs;
+            for (const auto& statement : Statements(Tokenize(source)))
+            {
+                int location = -1;
+                const std::size_t first = SkipQualifiers(statement, &location);
+                if (first + 2 >= statement.size() || statement[first] == "precision")
+                {
+                    continue;
+                }
+                if (statement[first] == "struct")
+                {
+                    std::vector<Declaration>& members = structs[statement[first + 1]];
+                    std::vector<std::string> member;
+                    for (std::size_t i = first + 3; i < statement.size() && statement[i] != "}"; i++)
+                    {
+                        if (statement[i] != ";")
+                        {
+                            member.push_back(statement[i]);
+                            continue;
+                        }
+                        const auto declarators = Declarators(member, SkipQualifiers(member));
+                        members.insert(members.end(), declarators.begin(), declarators.end());
+                        member.clear();
+                    }
+                }
+                else if (statement[first] == "uniform")
+                {
+                    if (statement[first + 2] == "{")
+                    {
+                        reflection.blocks.insert(statement[first + 1]);
+                        continue;
+                    }
+                    for (const Declaration& declaration : Declarators(statement, first + 1))
+                    {
+                        AddUniform(declaration, {}, structs, reflection);
+                    }
+                }
+                else if (statement[first] == "in" && vertex)
+                {
+                    for (const Declaration& declaration : Declarators(statement, first + 1))
+                    {
+                        reflection.attributes.emplace(declaration.name, location);
+                    }
+                }
+            }
+        }
+
+        //GLSL names are C++ identifiers but for the members of structs and the C++ keywords
+        std::string Identifier(const std::string_view glsl_name)
+        {
+            static const std::set<std::string_view> keywords = {
+                "auto", "case", "char", "class", "default", "delete", "double", "enum", "explicit", "friend",
+                "goto", "long", "namespace", "new", "operator", "private", "protected", "public", "register",
+                "short", "signed", "sizeof", "static", "template", "this", "throw", "try", "typedef", "typename",
+                "union", "unsigned", "using", "virtual",
+            };
+            std::string identifier(glsl_name);
+            std::ranges::replace(identifier, '.', '_');
+            if (keywords.contains(identifier))
+            {
+                identifier += '_';
+            }
+            return identifier;
+        }
+
+        //Raw string literals in pieces, MSVC rejects a single literal over 16 KiB
+        void WriteSource(std::ostream& out, const std::string_view source)
+        {
+            constexpr std::size_t piece_size = 4096;
+            for (std::size_t offset = 0; offset < source.size(); offset += piece_size)
+            {
+                out << "        R\"glsl(" << source.substr(offset, piece_size) << ")glsl\"\n";
+            }
+            if (source.empty())
+            {
+                out << "        \"\"\n";
+            }
+        }
+
+        //Leaves an unchanged header alone, the files including it are not rebuilt
+        bool WriteIfChanged(const std::string& path, const std::string& content)
+        {
+            std::ifstream existing(path, std::ios::binary);
+            if (existing)
+            {
+                std::stringstream previous;
+                previous << existing.rdbuf();
+                if (previous.str() == content)
+                {
+                    return true;
+                }
+            }
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            if (!file)
+            {
+                std::cerr << "shader_compiler: cannot write " << path << '\n';
+                return false;
+            }
+            file << content;
+            return true;
+        }
+
+        //Static cost estimate of a stage, from its source: counts weighted by the trip counts of the loops around
+        //them, with the calls to the functions of the shader expanded. An estimate to compare revisions of the
+        //same shader, not a prediction of the driver output.
+        struct ShaderCost
+        {
+            double alu = 0.0;
+            double texture = 0.0;
+            double branches = 0.0;
+            //"function: trips" of every loop, '?' when the bound is not a constant
+            std::vector<std::string> loops;
+        };
+
+        struct Function
+        {
+            std::size_t begin = 0;
+            std::size_t end = 0;
+        };
+
+        class CostEstimator
+        {
+        public:
+            explicit CostEstimator(const std::string_view source) : tokens_(Tokenize(source))
+            {
+                ReadDefines(source);
+                FindFunctions();
+            }
+
+            [[nodiscard]] ShaderCost Estimate()
+            {
+                ShaderCost cost = Cost("main");
+                //Cost only lists the loops of its own function, add those of every function main reaches once
+                for (const auto& [name, function_cost] : costs_)
+                {
+                    if (name != "main")
+                    {
+                        cost.loops.insert(cost.loops.end(), function_cost.loops.begin(), function_cost.loops.end());
+                    }
+                }
+                return cost;
+            }
+
+        private:
+            //#define NAME VALUE, the first one wins like the #ifndef defaults of the variants
+            void ReadDefines(const std::string_view source)
+            {
+                std::istringstream lines{std::string(source)};
+                std::string line;
+                while (std::getline(lines, line))
+                {
+                    std::istringstream words(line);
+                    std::string directive, name, value;
+                    if (words >> directive >> name >> value && directive == "#define")
+                    {
+                        constants_.emplace(name, value);
+                    }
+                }
+            }
+
+            //Function bodies at the top level, and the "const type NAME = VALUE" constants, local ones included
+            void FindFunctions()
+            {
+                int depth = 0;
+                for (std::size_t i = 0; i < tokens_.size(); i++)
+                {
+                    const std::string& token = tokens_[i];
+                    if (token == "const" && i + 4 < tokens_.size() && tokens_[i + 3] == "=")
+                    {
+                        constants_.emplace(tokens_[i + 2], tokens_[i + 4]);
+                    }
+                    if (token == "{")
+                    {
+                        if (depth == 0 && i > 0 && tokens_[i - 1] == ")")
+                        {
+                            const std::size_t open = MatchingOpen(i - 1);
+                            if (open > 0)
+                            {
+                                functions_[tokens_[open - 1]] = {i + 1, Matching(i)};
+                            }
+                        }
+                        depth++;
+                    }
+                    else if (token == "}")
+                    {
+                        depth--;
+                    }
+                }
+            }
+
+            //Index of the token closing the bracket opened at open
+            [[nodiscard]] std::size_t Matching(const std::size_t open) const
+            {
+                const std::string& opening = tokens_[open];
+                const std::string closing = opening == "(" ? ")" : opening == "[" ? "]" : "}";
+                int depth = 0;
+                for (std::size_t i = open; i < tokens_.size(); i++)
+                {
+                    if (tokens_[i] == opening)
+                    {
+                        depth++;
+                    }
+                    else if (tokens_[i] == closing && --depth == 0)
+                    {
+                        return i;
+                    }
+                }
+                return tokens_.size();
+            }
+
+            [[nodiscard]] std::size_t MatchingOpen(const std::size_t close) const
+            {
+                int depth = 0;
+                for (std::size_t i = close + 1; i-- > 0;)
+                {
+                    if (tokens_[i] == ")")
+                    {
+                        depth++;
+                    }
+                    else if (tokens_[i] == "(" && --depth == 0)
+                    {
+                        return i;
+                    }
+                }
+                return 0;
+            }
+
+            //A literal or a constant, with its u/f suffix
+            [[nodiscard]] bool Value(std::string token, long long& value, const int nesting = 0) const
+            {
+                if (const auto it = constants_.find(token); it != constants_.end() && nesting < 8)
+                {
+                    return Value(it->second, value, nesting + 1);
+                }
+                while (!token.empty() && (token.back() == 'u' || token.back() == 'U' || token.back() == 'f'))
+                {
+                    token.pop_back();
+                }
+                char* end = nullptr;
+                value = std::strtoll(token.c_str(), &end, 10);
+                return !token.empty() && *end == '\0';
+            }
+
+            //for (type i = A; i < B; ...) with A and B constants, 0 when the trip count is not known
+            [[nodiscard]] long long TripCount(const std::size_t open, const std::size_t close) const
+            {
+                std::vector<std::vector<std::string>> clauses(1);
+                for (std::size_t i = open + 1; i < close; i++)
+                {
+                    if (tokens_[i] == ";")
+                    {
+                        clauses.emplace_back();
+                    }
+                    else
+                    {
+                        clauses.back().push_back(tokens_[i]);
+                    }
+                }
+                if (clauses.size() != 3)
+                {
+                    return 0;
+                }
+                const auto read = [this](const std::vector<std::string>& clause, std::size_t i, long long& value)
+                {
+                    const bool negative = i < clause.size() && clause[i] == "-";
+                    if (negative)
+                    {
+                        i++;
+                    }
+                    if (i >= clause.size() || !Value(clause[i], value))
+                    {
+                        return false;
+                    }
+                    value = negative ? -value : value;
+                    return true;
+                };
+                const auto& init = clauses[0];
+                const auto& condition = clauses[1];
+                const auto assign = std::ranges::find(init, "=");
+                long long first = 0;
+                long long last = 0;
+                if (assign == init.end() || condition.size() < 3 ||
+                    !read(init, static_cast<std::size_t>(assign - init.begin()) + 1, first))
+                {
+                    return 0;
+                }
+                const bool inclusive = condition[2] == "=";
+                if (!read(condition, inclusive ? 3 : 2, last))
+                {
+                    return 0;
+                }
+                const long long trips = condition[1] == "<" ? last - first : condition[1] == ">" ? first - last : 0;
+                return std::max(trips + (inclusive ? 1 : 0), 0ll);
+            }
+
+            [[nodiscard]] static bool IsTextureFetch(const std::string_view name)
+            {
+                return (name.starts_with("texture") || name.starts_with("texelFetch")) && name != "textureSize" &&
+                    name != "textureQueryLevels" && name != "textureQueryLod" && name != "textureSamples";
+            }
+
+            [[nodiscard]] static bool IsAluBuiltin(const std::string_view name)
+            {
+                static const std::set<std::string_view> builtins = {
+                    "abs", "acos", "asin", "atan", "ceil", "clamp", "cos", "cross", "dFdx", "dFdy", "degrees",
+                    "determinant", "distance", "dot", "exp", "exp2", "faceforward", "floor", "fract", "fwidth",
+                    "inverse", "inversesqrt", "length", "log", "log2", "max", "min", "mix", "mod", "normalize", "pow",
+                    "radians", "reflect", "refract", "round", "sign", "sin", "smoothstep", "sqrt", "step", "tan",
+                    "transpose", "bitfieldReverse", "bitCount",
+                };
+                return builtins.contains(name);
+            }
+
+            ShaderCost Cost(const std::string& name)
+            {
+                if (const auto it = costs_.find(name); it != costs_.end())
+                {
+                    return it->second;
+                }
+                ShaderCost cost;
+                const auto function = functions_.find(name);
+                if (function == functions_.end())
+                {
+                    return cost;
+                }
+                //Loops enclosing the current token: index of the end of their body and trip count
+                std::vector<std::pair<std::size_t, double>> loops;
+                double weight = 1.0;
+                for (std::size_t i = function->second.begin; i < function->second.end; i++)
+                {
+                    while (!loops.empty() && i >= loops.back().first)
+                    {
+                        weight /= loops.back().second;
+                        loops.pop_back();
+                    }
+                    const std::string& token = tokens_[i];
+                    const bool call = i + 1 < tokens_.size() && tokens_[i + 1] == "(";
+                    if ((token == "for" || token == "while") && call)
+                    {
+                        const std::size_t close = Matching(i + 1);
+                        const long long trips = token == "for" ? TripCount(i + 1, close) : 0;
+                        cost.loops.push_back(name + ": " + (trips > 0 ? std::to_string(trips) : "?"));
+                        std::size_t body_end = close + 1;
+                        if (body_end < tokens_.size() && tokens_[body_end] == "{")
+                        {
+                            body_end = Matching(body_end) + 1;
+                        }
+                        else
+                        {
+                            while (body_end < tokens_.size() && tokens_[body_end] != ";")
+                            {
+                                body_end++;
+                            }
+                            body_end++;
+                        }
+                        const double factor = static_cast<double>(std::max(trips, 1ll));
+                        loops.emplace_back(body_end, factor);
+                        weight *= factor;
+                        i = close;
+                    }
+                    else if (token == "if" || token == "?")
+                    {
+                        cost.branches += weight;
+                    }
+                    else if (call && IsTextureFetch(token))
+                    {
+                        cost.texture += weight;
+                    }
+                    else if (call && IsAluBuiltin(token))
+                    {
+                        cost.alu += weight;
+                    }
+                    else if (call && token != name && functions_.contains(token))
+                    {
+                        const ShaderCost callee = Cost(token);
+                        cost.alu += callee.alu * weight;
+                        cost.texture += callee.texture * weight;
+                        cost.branches += callee.branches * weight;
+                    }
+                    else if (token == "+" || token == "-" || token == "*" || token == "/")
+                    {
+                        cost.alu += weight;
+                        //++, --, += and the like are one operation
+                        if (i + 1 < tokens_.size() && (tokens_[i + 1] == token || tokens_[i + 1] == "="))
+                        {
+                            i++;
+                        }
+                    }
+                }
+                costs_[name] = cost;
+                return cost;
+            }
+
+            std::vector<std::string> tokens_;
+            std::map<std::string, std::string> constants_;
+            std::map<std::string, Function> functions_;
+            std::map<std::string, ShaderCost> costs_;
+        };
+
+        //Flat JSON object of the stages, each an object of the metrics
+        void WriteCosts(std::ostream& out, const std::map<std::string, ShaderCost>& costs)
+        {
+            out << "{\n";
+            std::size_t index = 0;
+            for (const auto& [path, cost] : costs)
+            {
+                out << "  \"" << path << "\": {\"alu\": " << std::llround(cost.alu) << ", \"texture\": " <<
+                    std::llround(cost.texture) << ", \"branches\": " << std::llround(cost.branches) << ", \"loops\": [";
+                for (std::size_t i = 0; i < cost.loops.size(); i++)
+                {
+                    out << (i > 0 ? ", " : "") << '"' << cost.loops[i] << '"';
+                }
+                out << "]}" << (++index < costs.size() ? "," : "") << '\n';
+            }
+            out << "}\n";
+        }
+
+        int Cost(const std::string& output, const std::vector<std::string>& inputs)
+        {
+            std::map<std::string, ShaderCost> costs;
+            for (const std::string& input : inputs)
+            {
+                bool complete = true;
+                const std::string source = LoadShaderSource(input, &complete);
+                if (!complete)
+                {
+                    return EXIT_FAILURE;
+                }
+                costs[input] = CostEstimator(source).Estimate();
+            }
+            std::ostringstream out;
+            WriteCosts(out, costs);
+            return WriteIfChanged(output, out.str()) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        //Reads back the numbers of a file written by WriteCosts: stage, then metric
+        std::map<std::string, std::map<std::string, double>> ReadCosts(const std::string& path)
+        {
+            std::map<std::string, std::map<std::string, double>> costs;
+            std::ifstream file(path);
+            std::string line;
+            while (std::getline(file, line))
+            {
+                const auto path_begin = line.find('"');
+                const auto path_end = path_begin == std::string::npos ? path_begin : line.find('"', path_begin + 1);
+                const auto object = line.find('{', path_end == std::string::npos ? 0 : path_end);
+                if (path_end == std::string::npos || object == std::string::npos)
+                {
+                    continue;
+                }
+                auto& metrics = costs[line.substr(path_begin + 1, path_end - path_begin - 1)];
+                for (const std::string_view metric : {"alu", "texture", "branches"})
+                {
+                    const std::string key = '"' + std::string(metric) + "\": ";
+                    if (const auto at = line.find(key, object); at != std::string::npos)
+                    {
+                        metrics[std::string(metric)] = std::strtod(line.c_str() + at + key.size(), nullptr);
+                    }
+                }
+            }
+            return costs;
+        }
+
+        //Lists the stages whose cost changed, fails when one grew by more than ratio
+        int CostDiff(const std::string& baseline_path, const std::string& current_path, const double ratio)
+        {
+            const auto baseline = ReadCosts(baseline_path);
+            const auto current = ReadCosts(current_path);
+            if (current.empty())
+            {
+                std::cerr << "shader_compiler: no cost in " << current_path << '\n';
+                return EXIT_FAILURE;
+            }
+            bool regressed = false;
+            for (const auto& [path, metrics] : current)
+            {
+                const auto previous = baseline.find(path);
+                if (previous == baseline.end())
+                {
+                    std::cout << path << ": new\n";
+                    continue;
+                }
+                for (const auto& [metric, value] : metrics)
+                {
+                    const auto it = previous->second.find(metric);
+                    const double before = it == previous->second.end() ? 0.0 : it->second;
+                    if (value == before)
+                    {
+                        continue;
+                    }
+                    const double growth = before > 0.0 ? value / before : value > 0.0 ? ratio + 1.0 : 1.0;
+                    const bool too_much = growth > ratio;
+                    regressed |= too_much;
+                    std::cout << path << ": " << metric << ' ' << before << " -> " << value << " (x" << growth << ')' <<
+                        (too_much ? "  REGRESSION" : "") << '\n';
+                }
+            }
+            for (const auto& [path, metrics] : baseline)
+            {
+                if (!current.contains(path))
+                {
+                    std::cout << path << ": removed\n";
+                }
+            }
+            return regressed ? EXIT_FAILURE : EXIT_SUCCESS;
+        }
+
+        int Resolve(const std::string& input, const std::string& output)
+        {
+            bool complete = true;
+            const std::string source = LoadShaderSource(input, &complete);
+            if (!complete || !WriteIfChanged(output, source))
+            {
+                return EXIT_FAILURE;
+            }
+            return EXIT_SUCCESS;
+        }
+
+        int GenerateProgram(const std::string& name, const std::string& vertex_path,
+                            const std::string& fragment_path, const std::string& header)
+        {
+            bool vertex_complete = true;
+            bool fragment_complete = true;
+            const std::string vertex_source = LoadShaderSource(vertex_path, &vertex_complete);
+            const std::string fragment_source = LoadShaderSource(fragment_path, &fragment_complete);
+            if (!vertex_complete || !fragment_complete)
+            {
+                return EXIT_FAILURE;
+            }
+            Reflection vertex_reflection;
+            Reflection reflection;
+            Reflect(vertex_source, true, vertex_reflection);
+            Reflect(fragment_source, false, reflection);
+            for (const auto& [uniform, type] : vertex_reflection.uniforms)
+            {
+                //Both stages declare it: the types must agree or the program does not link
+                if (const auto [it, inserted] = reflection.uniforms.emplace(uniform, type); !inserted &&
+                    it->second != type)
+                {
+                    std::cerr << "shader_compiler: " << name << ": uniform " << uniform << " is " << type <<
+                        " in the vertex stage and " << it->second << " in the fragment stage\n";
+                    return EXIT_FAILURE;
+                }
+            }
+            reflection.blocks.insert(vertex_reflection.blocks.begin(), vertex_reflection.blocks.end());
+            reflection.attributes = vertex_reflection.attributes;
+
+            std::ostringstream out;
+            out << "//Generated by shader_compiler from " << vertex_path << " and " << fragment_path <<
+                ", do not edit\n";
+            out << "#pragma once\n\n";
+            out << "#include <glm/glm.hpp>\n\n";
+            out << "#include \"shader_source.h\"\n\n";
+            out << "namespace gpr5300::shaders::" << name << "\n{\n";
+            out << "    inline constexpr ProgramSource source{\n";
+            out << "        \"" << vertex_path << "\",\n";
+            WriteSource(out, vertex_source);
+            out << "        ,\n";
+            out << "        \"" << fragment_path << "\",\n";
+            WriteSource(out, fragment_source);
+            out << "    };\n\n";
+            out << "    //Default block of both stages\n";
+            out << "    namespace uniforms\n    {\n";
+            for (const auto& [uniform, type] : reflection.uniforms)
+            {
+                out << "        inline constexpr UniformName<" << type << "> " << Identifier(uniform) << "{\"" <<
+                    uniform << "\"};\n";
+            }
+            out << "    }\n\n";
+            out << "    namespace blocks\n    {\n";
+            for (const std::string& block : reflection.blocks)
+            {
+                out << "        inline constexpr std::string_view " << Identifier(block) << " = \"" << block <<
+                    "\";\n";
+            }
+            out << "    }\n\n";
+            out << "    //Vertex inputs, -1 for those without a layout location\n";
+            out << "    namespace attributes\n    {\n";
+            for (const auto& [attribute, location] : reflection.attributes)
+            {
+                out << "        inline constexpr int " << Identifier(attribute) << " = " << location << ";\n";
+            }
+            out << "    }\n";
+            out << "} // namespace gpr5300::shaders::" << name << '\n';
+            return WriteIfChanged(header, out.str()) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+} // namespace gpr5300
+
+int main(int argc, char* argv[])
+{
+    const std::vector<std::string> args(argv + 1, argv + argc);
+    if (args.size() == 3 && args[0] == "resolve")
+    {
+        return gpr5300::Resolve(args[1], args[2]);
+    }
+    if (args.size() == 5 && args[0] == "program")
+    {
+        return gpr5300::GenerateProgram(args[1], args[2], args[3], args[4]);
+    }
+    if (args.size() >= 3 && args[0] == "cost")
+    {
+        return gpr5300::Cost(args[1], {args.begin() + 2, args.end()});
+    }
+    if ((args.size() == 3 || args.size() == 4) && args[0] == "cost-diff")
+    {
+        return gpr5300::CostDiff(args[1], args[2], args.size() == 4 ? std::atof(args[3].c_str()) : 1.25);
+    }
+    std::cerr << "Usage: shader_compiler resolve INPUT OUTPUT\n"
+        "       shader_compiler program NAME VERTEX FRAGMENT HEADER\n"
+        "       shader_compiler cost OUTPUT SHADER...\n"
+        "       shader_compiler cost-diff BASELINE CURRENT [RATIO]\n";
+    return EXIT_FAILURE;
+}